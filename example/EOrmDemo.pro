@@ -1,6 +1,12 @@
 QT       += core gui sql
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
+
+# objects are loaded by EOrmAsync, which requires Qt 5.4
+lessThan(QT_MAJOR_VERSION, 5): error("EOrmDemo requires Qt 5.4 or later")
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 4) {
+    error("EOrmDemo requires Qt 5.4 or later")
+}
 
 TARGET = EOrmDemo
 
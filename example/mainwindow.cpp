@@ -6,6 +6,10 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
+    watcher = new QFutureWatcher<QList<Test*> >(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(showObjects()));
+    model = new EOrmModel(this);
+    ui->tableView->setModel(model);
 
     QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
     db.setDatabaseName("db.sqlite");
@@ -13,6 +17,8 @@ MainWindow::MainWindow(QWidget *parent) :
         qDebug()<<db.lastError().text();
         return;
     }
+    // objects are loaded in background by connections of the pool
+    EOrmConnectionPool::setSource(db);
 
     updateObjects();
     connect(ui->btnSave, SIGNAL(released()), this, SLOT(createObject()));
@@ -36,8 +42,9 @@ void MainWindow::createObject()
         newObj->setProperty("description", description);
         if (newObj->save()) {
             _resetCreateObjFields();
-            delete newObj;
+            model->insertObject(newObj);
         } else {
+            delete newObj;
             QMessageBox::warning(0,"Warning", "Object not saved!");
         }
     } catch (EOrmException *e) {
@@ -46,13 +53,18 @@ void MainWindow::createObject()
 }
 
 void MainWindow::updateObjects()
+{
+    watcher->setFuture(EOrmAsync::all<Test>(EOrmFind::find()));
+}
+
+void MainWindow::showObjects()
 {
     try {
-        ui->tableView->reset();
-        QList<Test*> list = EOrmFind::find()->all<Test>();
-        EOrmModel *model = new EOrmModel();
-        model->setData(list);
-        ui->tableView->setModel(model);
+        // only changed rows are repainted, selection is kept
+        model->refresh(watcher->result());
+    } catch (EOrmAsyncException &e) {
+        // rows loaded before stay in the model
+        QMessageBox::critical(0, "Critical", e.message());
     } catch (EOrmException *e) {
         QMessageBox::critical(0, "Critical", e->message());
     }
@@ -64,12 +76,11 @@ void MainWindow::deleteObject()
         if (ui->tableView->selectionModel()->
                 selection().indexes().count() > 0) {
                 int row = ui->tableView->selectionModel()->currentIndex().row();
-                Test *delObj = new Test(ui->tableView->model()->
-                                        data(ui->tableView->model()->
-                                             index(row, 0)));
-                delObj->remove();
-                delete delObj;
-                updateObjects();
+                EOrmActiveRecord *delObj = model->object(row);
+                // model owns and deletes the object of the row
+                if (delObj->remove()) {
+                    model->removeObject(delObj);
+                }
 
         } else {
             QMessageBox::warning(0,"Warning", "Select object for delete!");
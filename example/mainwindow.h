@@ -3,9 +3,11 @@
 
 #include <QMainWindow>
 #include <QMessageBox>
+#include <QFutureWatcher>
 #include "test.h"
 #include "eormfind.h"
 #include "eormmodel.h"
+#include "eormasync.h"
 
 namespace Ui {
 class MainWindow;
@@ -23,10 +25,15 @@ public slots:
     void createObject();
     void updateObjects();
     void deleteObject();
+
+private slots:
+    void showObjects();
     
 private:
     void _resetCreateObjFields();
     Ui::MainWindow *ui;
+    QFutureWatcher<QList<Test*> > *watcher;
+    EOrmModel *model;
 };
 
 #endif // MAINWINDOW_H
@@ -15,7 +15,17 @@ SOURCES += \
     eormfind.cpp \
     eormmodel.cpp \
     eorm.cpp \
-    eormexception.cpp
+    eormexception.cpp \
+    eormmetadata.cpp \
+    eormstatementcache.cpp \
+    eormsession.cpp \
+    eormcursor.cpp \
+    eormpagetoken.cpp \
+    eormrowset.cpp \
+    eormidentitymap.cpp \
+    eormrecordcache.cpp \
+    eormquerycache.cpp \
+    eormconnectionpool.cpp
 
 HEADERS += \
     eormactiverecord.h \
@@ -23,4 +33,26 @@ HEADERS += \
     eormmodel.h \
     eorm.h \
     eormexception.h \
+    eormmetadata.h \
+    eormstatementcache.h \
+    eormsession.h \
+    eormcursor.h \
+    eormpagetoken.h \
+    eormrowset.h \
+    eormidentitymap.h \
+    eormrecordcache.h \
+    eormquerycache.h \
+    eormconnectionpool.h \
     eorm_global.h
+
+# EOrmAsync uses QtConcurrent::run() with a thread pool, added in Qt 5.4
+EORM_ASYNC = 1
+lessThan(QT_MAJOR_VERSION, 5): EORM_ASYNC = 0
+equals(QT_MAJOR_VERSION, 5):lessThan(QT_MINOR_VERSION, 4): EORM_ASYNC = 0
+equals(EORM_ASYNC, 1) {
+    QT += concurrent
+    SOURCES += eormasync.cpp
+    HEADERS += eormasync.h
+} else {
+    message("EOrmAsync requires Qt 5.4 or later, it is not built")
+}
@@ -40,6 +40,9 @@
 ****************************************************************************/
 
 #include "eorm.h"
+#include "eormconnectionpool.h"
+#include "eormquerycache.h"
+#include "eormrecordcache.h"
 
 /*!
  * \lang_en
@@ -52,6 +55,31 @@
  */
 QString EOrm::m_connectionName = QString();
 
+/*!
+ * \lang_en
+ * \brief Initialization of depth of transactions opened on connections.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация глубины транзакций, открытых на соединениях.
+ * \endlang
+ */
+QHash<QString, int> EOrm::m_transactions;
+QSet<QString> EOrm::m_rollbackOnly;
+QMutex EOrm::m_transactionsMutex;
+
+/*!
+ * \lang_en
+ * \brief Initialization of support of RETURNING clause by connections.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация поддержки выражения RETURNING соединениями.
+ * \endlang
+ */
+QHash<QString, bool> EOrm::m_returning;
+QMutex EOrm::m_returningMutex;
+
 /*!
  * \lang_en
  * \brief Function returned the set name of connection with a database.
@@ -84,30 +112,65 @@ void EOrm::setConnectionName(QString connectionName)
     EOrm::m_connectionName = connectionName;
 }
 
+/*!
+ * \lang_en
+ * \brief Function returned key of connection for caches of objects.
+ *
+ *  For connections of EOrmConnectionPool it is the name of the source
+ *  connection, so caches are shared by all connections to the same database.
+ *  For other connections it is the name of connection.
+ * \param db - a database object
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает ключ соединения для кэшей объектов.
+ *
+ *  Для соединений EOrmConnectionPool это имя исходного соединения, поэтому
+ *  кэши общие для всех соединений с одной базой. Для других соединений это
+ *  имя соединения.
+ * \param db - объект базы данных
+ * \return QString
+ * \endlang
+ */
+QString EOrm::connectionKey(QSqlDatabase db)
+{
+    return EOrmConnectionPool::origin(db.connectionName());
+}
+
 /*!
  * \lang_en
  * \brief Function returned object of QSqlDatabase by name of connections.
  *
- *  The name of connection gave from function of EOrm::connectionName. If the name are not set, connection by default are use.
+ *  If the current thread leases connection of pool (see
+ *  EOrmConnectionLease), it is returned. Otherwise the name of connection gave
+ *  from function of EOrm::connectionName. If the name are not set,
+ *  connection by default are use.
  * \return QSqlDatabase
  * \endlang
  *
  * \lang_ru
  * \brief Функция возвращает объект QSqlDatabase по имени соединения.
  *
- *  Имя соединения берется из функции EOrm::connectionName. Если имя не заданно,
- *  используется соединение по-умолчанию.
+ *  Если текущий поток арендует соединение пула (см. EOrmConnectionLease),
+ *  возвращается оно. Иначе имя соединения берется из функции
+ *  EOrm::connectionName. Если имя не заданно, используется соединение
+ *  по-умолчанию.
  * \return QSqlDatabase
  * \endlang
  */
 QSqlDatabase EOrm::activeConnection()
 {
-    const char *connection_name = QSqlDatabase::defaultConnection;
-    if (!EOrm::connectionName().isEmpty()) {
-        connection_name = qPrintable(EOrm::connectionName());
+    QSqlDatabase leased = EOrmConnectionPool::current();
+    if (leased.isValid()) {
+        return leased;
+    }
+    QString connectionName = EOrm::connectionName();
+    if (connectionName.isEmpty()) {
+        connectionName = QLatin1String(QSqlDatabase::defaultConnection);
     }
-    if (QSqlDatabase::contains(connection_name)) {
-        return QSqlDatabase::database(connection_name);
+    if (QSqlDatabase::contains(connectionName)) {
+        return QSqlDatabase::database(connectionName);
     } else {
         return QSqlDatabase();
     }
@@ -134,3 +197,289 @@ void EOrm::throwError(uint code, QString message)
 {
     throw new EOrmException(code, message);
 }
+
+/*!
+ * \lang_en
+ * \brief Function opened transaction on the connection.
+ *
+ *  Transactions can be nested: only the outer call starts the database
+ *  transaction, inner calls increase its depth. So an operation which uses
+ *  own transaction can be a part of a bigger one.
+ * \param db - a database object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция открывает транзакцию на соединении.
+ *
+ *  Транзакции могут быть вложенными: только внешний вызов начинает
+ *  транзакцию базы, внутренние вызовы увеличивают ее глубину. Так операция,
+ *  использующая собственную транзакцию, может быть частью более крупной.
+ * \param db - объект базы данных
+ * \return bool
+ * \endlang
+ */
+bool EOrm::transaction(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrm::m_transactionsMutex);
+    int depth = EOrm::m_transactions.value(db.connectionName(), 0);
+    EOrm::m_transactions.insert(db.connectionName(), depth + 1);
+    if (depth == 0) {
+        return db.transaction();
+    }
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function committed transaction on the connection.
+ *
+ *  The database transaction is committed by the outer call only. If any inner
+ *  transaction was rolled back, the outer one is rolled back too and FALSE is
+ *  returned. Records and results of queries changed in the transaction are
+ *  dropped from EOrmRecordCache and EOrmQueryCache once more after the outer
+ *  call.
+ * \param db - a database object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция фиксирует транзакцию на соединении.
+ *
+ *  Транзакция базы фиксируется только внешним вызовом. Если какая-либо
+ *  вложенная транзакция была отменена, внешняя также отменяется и
+ *  возвращается FALSE. Записи и результаты запросов, измененные в
+ *  транзакции, повторно сбрасываются из EOrmRecordCache и EOrmQueryCache
+ *  после внешнего вызова.
+ * \param db - объект базы данных
+ * \return bool
+ * \endlang
+ */
+bool EOrm::commit(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrm::m_transactionsMutex);
+    QString connection = db.connectionName();
+    int depth = EOrm::m_transactions.take(connection);
+    if (depth > 1) {
+        EOrm::m_transactions.insert(connection, depth - 1);
+        return true;
+    }
+    bool ok = false;
+    if (EOrm::m_rollbackOnly.remove(connection)) {
+        db.rollback();
+    } else {
+        ok = db.commit();
+    }
+    locker.unlock();
+    EOrmRecordCache::finishTransaction(db);
+    EOrmQueryCache::finishTransaction(db);
+    return ok;
+}
+
+/*!
+ * \lang_en
+ * \brief Function rolled back transaction on the connection.
+ *
+ *  The database transaction is rolled back by the outer call, inner call only
+ *  mark the outer transaction to be rolled back. Records and results of
+ *  queries changed in the transaction are dropped from EOrmRecordCache and
+ *  EOrmQueryCache once more after the outer call.
+ * \param db - a database object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция отменяет транзакцию на соединении.
+ *
+ *  Транзакция базы отменяется внешним вызовом, вложенный вызов только
+ *  помечает внешнюю транзакцию для отмены. Записи и результаты запросов,
+ *  измененные в транзакции, повторно сбрасываются из EOrmRecordCache и
+ *  EOrmQueryCache после внешнего вызова.
+ * \param db - объект базы данных
+ * \return bool
+ * \endlang
+ */
+bool EOrm::rollback(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrm::m_transactionsMutex);
+    QString connection = db.connectionName();
+    int depth = EOrm::m_transactions.take(connection);
+    if (depth > 1) {
+        EOrm::m_transactions.insert(connection, depth - 1);
+        EOrm::m_rollbackOnly.insert(connection);
+        return true;
+    }
+    EOrm::m_rollbackOnly.remove(connection);
+    bool ok = db.rollback();
+    locker.unlock();
+    EOrmRecordCache::finishTransaction(db);
+    EOrmQueryCache::finishTransaction(db);
+    return ok;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned depth of transaction opened on the connection, 0
+ *  if there is no transaction.
+ * \param db - a database object
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает глубину транзакции, открытой на соединении, 0
+ *  если транзакции нет.
+ * \param db - объект базы данных
+ * \return int
+ * \endlang
+ */
+int EOrm::transactionDepth(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrm::m_transactionsMutex);
+    return EOrm::m_transactions.value(db.connectionName(), 0);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned the maximum count of bound values in one statement
+ *  supported by the driver of connection.
+ * \param db - a database object
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает максимальное количество параметров в одном
+ *  запросе, поддерживаемое драйвером соединения.
+ * \param db - объект базы данных
+ * \return int
+ * \endlang
+ */
+int EOrm::maxBindValues(QSqlDatabase db)
+{
+    QString driver = db.driverName();
+    if (driver == "QPSQL" || driver == "QMYSQL") {
+        return 32767;
+    } else if (driver == "QODBC") {
+        return 2100;
+    }
+    return 999;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned TRUE if the database of connection supports
+ *  RETURNING clause of INSERT statement.
+ *
+ *  QPSQL always supports it, QSQLITE starting with SQLite 3.35. The version of
+ *  SQLite is asked once per connection.
+ * \param db - a database object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает TRUE, если база данных соединения поддерживает
+ *  выражение RETURNING запроса INSERT.
+ *
+ *  QPSQL поддерживает его всегда, QSQLITE начиная с SQLite 3.35. Версия SQLite
+ *  запрашивается один раз для соединения.
+ * \param db - объект базы данных
+ * \return bool
+ * \endlang
+ */
+bool EOrm::supportsReturning(QSqlDatabase db)
+{
+    QString driver = db.driverName();
+    if (driver == "QPSQL") {
+        return true;
+    } else if (driver != "QSQLITE") {
+        return false;
+    }
+    QMutexLocker locker(&EOrm::m_returningMutex);
+    QHash<QString, bool>::const_iterator it =
+            EOrm::m_returning.constFind(db.connectionName());
+    if (it != EOrm::m_returning.constEnd()) {
+        return it.value();
+    }
+    bool supported = false;
+    QSqlQuery qr(db);
+    if (qr.exec("SELECT sqlite_version()") && qr.next()) {
+        QStringList version = qr.value(0).toString().split('.');
+        int major = version.value(0).toInt();
+        int minor = version.value(1).toInt();
+        supported = (major > 3 || (major == 3 && minor >= 35));
+    }
+    EOrm::m_returning.insert(db.connectionName(), supported);
+    return supported;
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, open transaction on the connection.
+ * \param db - a database object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, открывает транзакцию на соединении.
+ * \param db - объект базы данных
+ * \endlang
+ */
+EOrmTransaction::EOrmTransaction(QSqlDatabase db) :
+    m_db(db), m_finished(false)
+{
+    EOrm::transaction(this->m_db);
+}
+
+/*!
+ * \lang_en
+ * \brief Destructor, roll back transaction if it was not finished.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Деструктор, отменяет транзакцию, если она не завершена.
+ * \endlang
+ */
+EOrmTransaction::~EOrmTransaction()
+{
+    if (!this->m_finished) {
+        EOrm::rollback(this->m_db);
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function commit transaction, see EOrm::commit().
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция фиксирует транзакцию, см. EOrm::commit().
+ * \return bool
+ * \endlang
+ */
+bool EOrmTransaction::commit()
+{
+    if (this->m_finished) {
+        return false;
+    }
+    this->m_finished = true;
+    return EOrm::commit(this->m_db);
+}
+
+/*!
+ * \lang_en
+ * \brief Function roll back transaction, see EOrm::rollback().
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция отменяет транзакцию, см. EOrm::rollback().
+ * \return bool
+ * \endlang
+ */
+bool EOrmTransaction::rollback()
+{
+    if (this->m_finished) {
+        return false;
+    }
+    this->m_finished = true;
+    return EOrm::rollback(this->m_db);
+}
@@ -69,14 +69,75 @@ public:
     static QSqlDatabase activeConnection();
     static QString connectionName();
     static void setConnectionName(QString connectionName);
+    static QString connectionKey(QSqlDatabase db);
     static void throwError(uint code,
                            QString message = QString("Unknown error."));
+    static bool transaction(QSqlDatabase db);
+    static bool commit(QSqlDatabase db);
+    static bool rollback(QSqlDatabase db);
+    static int transactionDepth(QSqlDatabase db);
+    static int maxBindValues(QSqlDatabase db);
+    static bool supportsReturning(QSqlDatabase db);
 
 private:
     static ErrorType m_errorType;
     static int m_errorCode;
     static QString m_errorMessage;
     static QString m_connectionName;
+    static QHash<QString, int> m_transactions;
+    static QSet<QString> m_rollbackOnly;
+    static QMutex m_transactionsMutex;
+    static QHash<QString, bool> m_returning;
+    static QMutex m_returningMutex;
+
+};
+
+/*!
+ * \class EOrmTransaction
+ *
+ * \lang_en
+ * \brief The class, transaction of connection for the current scope.
+ *
+ *  Constructor opens transaction by EOrm::transaction(), commit() commits it.
+ *  If transaction was not committed, destructor rolls it back, so it is
+ *  rolled back by any exception leaving the scope. Example:
+ * \code
+ *  EOrmTransaction transaction(db);
+ *  obj->save();
+ *  other->save();
+ *  return transaction.commit();
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс, транзакция соединения на время текущей области видимости.
+ *
+ *  Конструктор открывает транзакцию функцией EOrm::transaction(), commit()
+ *  ее фиксирует. Если транзакция не зафиксирована, деструктор ее отменяет,
+ *  поэтому она отменяется любым исключением, покидающим область видимости.
+ *  Пример:
+ * \code
+ *  EOrmTransaction transaction(db);
+ *  obj->save();
+ *  other->save();
+ *  return transaction.commit();
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmTransaction
+{
+
+public:
+    explicit EOrmTransaction(QSqlDatabase db);
+    ~EOrmTransaction();
+    bool commit();
+    bool rollback();
+
+private:
+    Q_DISABLE_COPY(EOrmTransaction)
+
+    QSqlDatabase m_db;
+    bool m_finished;
 
 };
 
@@ -40,6 +40,7 @@
 ****************************************************************************/
 
 #include "eormactiverecord.h"
+#include "eormidentitymap.h"
 
 /*!
  * \lang_en
@@ -167,32 +168,59 @@ bool EOrmActiveRecord::init(QSqlDatabase db, QVariant pk)
 /*!
  * \lang_en
  * \brief The virtual function. Returned the name of primary key.
+ *
+ *  By default the name are taken from the table metadata, so the database
+ *  catalog is not queried on every call.
  * \return QString
  * \endlang
  *
  * \lang_ru
  * \brief Виртуальная функция. Возвращает наименование первичного ключа.
+ *
+ *  По-умолчанию наименование берется из метаданных таблицы, поэтому каталог
+ *  базы не запрашивается при каждом вызове.
  * \return QString
  * \endlang
  */
 QString EOrmActiveRecord::primaryKeyName()
 {
-    return this->db().primaryIndex(this->tableName()).name();
+    QSharedPointer<const EOrmTableInfo> table = this->m_table;
+    if (table.isNull()) {
+        table = EOrmMetadata::table(this->db(), this->tableName());
+    }
+    if (!table.isNull()) {
+        return table->primaryKeyName();
+    }
+    return QString();
 }
 
 /*!
  * \lang_en
  * \brief Returned a database object.
+ *
+ *  Object loaded under EOrmConnectionLease keeps connection of the pool
+ *  after the lease ends. When the pool closes this connection, object is
+ *  bound again to EOrm::activeConnection() of the calling thread, so the
+ *  connection is resolved again for every operation.
  * \return QSqlDatabase
  * \endlang
  *
  * \lang_ru
  * \brief Возвращает объект базы данных.
+ *
+ *  Объект, загруженный при EOrmConnectionLease, сохраняет соединение пула
+ *  после окончания аренды. Когда пул закрывает это соединение, объект
+ *  заново связывается с EOrm::activeConnection() вызывающего потока,
+ *  поэтому соединение определяется заново для каждой операции.
  * \return QSqlDatabase
  * \endlang
  */
 QSqlDatabase EOrmActiveRecord::db()
 {
+    // connection of the pool could be removed after end of lease
+    if (!this->m_db.isValid()) {
+        this->m_db = EOrm::activeConnection();
+    }
     return this->m_db;
 }
 
@@ -209,7 +237,23 @@ QSqlDatabase EOrmActiveRecord::db()
  */
 QVariant EOrmActiveRecord::pk()
 {
-    return this->property(qPrintable(this->primaryKeyName()));
+    return this->value(this->primaryKeyName());
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if object was not saved in database yet.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если объект еще не сохранялся в базе.
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::isNew() const
+{
+    return !this->m_pk.isValid();
 }
 
 /*!
@@ -217,8 +261,10 @@ QVariant EOrmActiveRecord::pk()
  * \brief Function of preloading, call at initialization.
  *
  *  Set connection with the table of a database, selected fields of the table
- *  and create similar properties of object. Returned FALSE if missed
- *  connection, the table or fields in the table.
+ *  and create similar properties of object. Fields of the table are taken from
+ *  EOrmMetadata, so the database catalog is queried only for the first object
+ *  of the table. Returned FALSE if missed connection, the table or fields in
+ *  the table.
  * \return bool
  * \endlang
  *
@@ -226,25 +272,27 @@ QVariant EOrmActiveRecord::pk()
  * \brief Функция предзагрузки, вызываемая при инициализации.
  *
  *  Выполняет соединение с таблицей базы данных, выбирает поля таблицы и
- *  создает аналогичные свойства объекта. Возвращает FALSE, если отсутствует
- *  соединение, таблица или поля в таблице.
+ *  создает аналогичные свойства объекта. Поля таблицы берутся из
+ *  EOrmMetadata, поэтому каталог базы запрашивается только для первого
+ *  объекта таблицы. Возвращает FALSE, если отсутствует соединение, таблица
+ *  или поля в таблице.
  * \return bool
  * \endlang
  */
 bool EOrmActiveRecord::preload()
 {
     if (this->db().isOpen()) {
-        if (this->db().tables().indexOf(this->tableName()) > -1) {
-            int fields_count = this->db().record(this->tableName()).count();
+        QSharedPointer<const EOrmTableInfo> table = EOrmMetadata::table(
+                    this->db(), this->tableName());
+        if (!table.isNull()) {
+            int fields_count = table->count();
             if (fields_count > 0) {
+                this->m_table = table;
+                this->m_values.resize(fields_count);
+                this->m_dirty = QBitArray(fields_count);
+                this->m_stale = QBitArray(fields_count);
                 for (int i = 0; i < fields_count; i++) {
-                    QSqlField fd = this->db().record(
-                                       this->tableName()).field(i);
-                    this->setProperty(fd.name().toUtf8(), fd.value());
-                    this->m_properties << fd.name().toUtf8();
-                    if (fd.requiredStatus() != 0) {
-                        this->m_requiredProperties << fd.name().toUtf8();
-                    }
+                    this->m_values[i] = QVariant(table->type(i));
                 }
                 return true;
             } else {
@@ -263,12 +311,18 @@ bool EOrmActiveRecord::preload()
 /*!
  * \lang_en
  * \brief Function load values of object properties from the main table.
+ *
+ *  If record cache is turned on for the table (see EOrmRecordCache), values
+ *  are taken from it when possible.
  * \param primaryKey - primary key
  * \return bool
  * \endlang
  *
  * \lang_ru
  * \brief Функция загрузки, выбирающая значения свойств объекта из таблицы.
+ *
+ *  Если для таблицы включен кэш записей (см. EOrmRecordCache), значения по
+ *  возможности берутся из него.
  * \param primaryKey - первичный ключ
  * \return bool
  * \endlang
@@ -276,33 +330,39 @@ bool EOrmActiveRecord::preload()
 bool EOrmActiveRecord::load(QVariant primaryKey)
 {
     if (primaryKey.isValid()) {
-        QStringList prop = this->m_properties;
-        prop << this->primaryKeyName();
-        QStringList sql;
-        sql << "SELECT";
-        sql << prop.join(",");
-        sql << "FROM";
-        sql << this->tableName();
-        sql << "WHERE " << this->primaryKeyName() << "= ?";
-        QSqlQuery qr(this->db());
-        if (qr.prepare(sql.join(" "))) {
-            qr.addBindValue(primaryKey);
-            if (qr.exec()) {
-                if (qr.size() != 0) {
-                    while (qr.next()) {
+        QVector<QVariant> cached;
+        if (EOrmRecordCache::fetch(this->db(), this->tableName(), primaryKey,
+                                   &cached)
+                && cached.count() == this->m_values.count()) {
+            this->m_values = cached;
+            this->m_dirty.fill(false);
+            this->m_stale.fill(false);
+            this->m_pk = this->value(this->primaryKeyName());
+            return true;
+        }
+        QStringList prop = this->columns();
+        QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                    this->db(), EOrmStatementCache::Select, this->tableName(),
+                    this->primaryKeyName(), prop);
+        if (!qr.isNull()) {
+            qr->bindValue(0, primaryKey);
+            if (qr->exec()) {
+                if (qr->size() != 0) {
+                    while (qr->next()) {
                         for (int i = 0; i < prop.size(); ++i) {
-                            QByteArray name = prop.at(i).toLocal8Bit()
-                                              .constData();
-                            QVariant value = qr.value(qr.record()
-                                                      .indexOf(name));
-                            this->setProperty(name, value);
+                            this->m_values[i] = qr->value(i);
                         }
                     }
-                    this->m_pk = this->property(
-                                     qPrintable(this->primaryKeyName()));
+                    qr->finish();
+                    this->m_dirty.fill(false);
+                    this->m_stale.fill(false);
+                    this->m_pk = this->value(this->primaryKeyName());
+                    EOrmRecordCache::store(this->db(), this->tableName(),
+                                           this->m_pk, this->m_values);
                     return true;
                 } else {
-                    if (qr.size() > 1) {
+                    qr->finish();
+                    if (qr->size() > 1) {
                         EOrm::throwError(7, "Load: Try to load more "
                                          "than one objects");
                     } else {
@@ -322,6 +382,94 @@ bool EOrmActiveRecord::load(QVariant primaryKey)
     return false;
 }
 
+/*!
+ * \lang_en
+ * \brief Function fill object properties from the current row of query.
+ *
+ *  It is used by EOrmFind to build objects directly from a selection result
+ *  without additional query per object. Indexes of columns are resolved once
+ *  per query by the caller: i-th element is a position in the result of i-th
+ *  object property, -1 if the property was not selected. If markAbsent is
+ *  TRUE, not selected properties are marked as not loaded.
+ * \param query - positioned on a valid row query
+ * \param columns - indexes of result columns
+ * \param markAbsent - mark not selected properties as not loaded
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция заполняет свойства объекта из текущей строки запроса.
+ *
+ *  Используется в EOrmFind для построения объектов прямо из результата
+ *  выборки, без дополнительного запроса на каждый объект. Индексы столбцов
+ *  вычисляются вызывающей стороной один раз на запрос: i-й элемент - позиция
+ *  i-го свойства объекта в результате, -1 если свойство не выбиралось. Если
+ *  markAbsent равен TRUE, невыбранные свойства отмечаются незагруженными.
+ * \param query - запрос, спозиционированный на строке
+ * \param columns - индексы столбцов результата
+ * \param markAbsent - отметить невыбранные свойства незагруженными
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::hydrate(const QSqlQuery &query,
+                               const QVector<int> &columns, bool markAbsent)
+{
+    int count = qMin(columns.count(), this->m_values.count());
+    for (int i = 0; i < count; i++) {
+        if (columns.at(i) > -1) {
+            this->m_values[i] = query.value(columns.at(i));
+            this->m_stale.clearBit(i);
+        } else if (markAbsent) {
+            this->m_stale.setBit(i);
+        }
+    }
+    this->m_dirty.fill(false);
+    this->m_pk = this->value(this->primaryKeyName());
+    return this->m_pk.isValid();
+}
+
+/*!
+ * \lang_en
+ * \brief Function fill object properties from the row of values.
+ *
+ *  It is similar hydrate() for query, it is used by EOrmFind for results
+ *  taken from query cache (see EOrmQueryCache).
+ * \param rows - rows of values
+ * \param row - ordinal of the row
+ * \param columns - indexes of result columns
+ * \param markAbsent - mark not selected properties as not loaded
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция заполняет свойства объекта из строки значений.
+ *
+ *  Аналогична hydrate() для запроса, используется в EOrmFind для
+ *  результатов, взятых из кэша запросов (см. EOrmQueryCache).
+ * \param rows - строки значений
+ * \param row - порядковый номер строки
+ * \param columns - индексы столбцов результата
+ * \param markAbsent - отметить невыбранные свойства незагруженными
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::hydrate(const EOrmRowSet &rows, int row,
+                               const QVector<int> &columns, bool markAbsent)
+{
+    int count = qMin(columns.count(), this->m_values.count());
+    for (int i = 0; i < count; i++) {
+        if (columns.at(i) > -1) {
+            this->m_values[i] = rows.value(row, columns.at(i));
+            this->m_stale.clearBit(i);
+        } else if (markAbsent) {
+            this->m_stale.setBit(i);
+        }
+    }
+    this->m_dirty.fill(false);
+    this->m_pk = this->value(this->primaryKeyName());
+    return this->m_pk.isValid();
+}
+
 /*!
  * \lang_en
  * \brief Function reset values of all object properties.
@@ -336,11 +484,10 @@ bool EOrmActiveRecord::load(QVariant primaryKey)
 bool EOrmActiveRecord::clear()
 {
     this->m_pk = QVariant();
-    for (int i = 0; i < this->m_properties.count(); i++) {
-        this->setProperty(this->m_properties.value(i).toUtf8(), QVariant());
-    }
-    this->m_properties = QStringList();
-    this->m_requiredProperties = QStringList();
+    this->m_values.clear();
+    this->m_dirty.clear();
+    this->m_stale.clear();
+    this->m_table.clear();
     return true;
 }
 
@@ -349,7 +496,8 @@ bool EOrmActiveRecord::clear()
  * \brief Function remove object.
  *
  *  Thus the object is removed only from a database. If updateProperties are
- *  equal TRUE, object properties force updated.
+ *  equal TRUE, object properties force updated. In any case the object is
+ *  expired in current identity map (see EOrmIdentityMap::expire()).
  * \param updateProperties - reload properties from database, TRUE by default
  * \return bool
  * \endlang
@@ -358,53 +506,58 @@ bool EOrmActiveRecord::clear()
  * \brief Функция удаления объекта.
  *
  *  При этом объект удаляется только из базы данных. Если updateProperties равен
- *  TRUE, также обновляются свойства у объекта, вызвавшего данную функцию.
+ *  TRUE, также обновляются свойства у объекта, вызвавшего данную функцию. В
+ *  любом случае объект становится устаревшим в текущей карте идентичности
+ *  (см. EOrmIdentityMap::expire()).
  * \param updateProperties - перезагрузка свойств с базы, TRUE по-умолчанию
  * \return bool
  * \endlang
  */
 bool EOrmActiveRecord::remove(bool updateProperties)
 {
-    QStringList sql;
-    sql << "DELETE FROM";
-    sql << this->tableName();
-    sql << "WHERE";
-    sql << this->primaryKeyName() + "= ?";
-    this->db().transaction();
-    QSqlQuery qr(this->db());
-    if (qr.prepare(sql.join(" "))) {
-        qr.addBindValue(this->m_pk);
-        if (qr.exec()) {
-            if (qr.numRowsAffected() == 1) {
+    EOrm::transaction(this->db());
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                this->db(), EOrmStatementCache::Delete, this->tableName(),
+                this->primaryKeyName(), QStringList());
+    if (!qr.isNull()) {
+        qr->bindValue(0, this->m_pk);
+        if (qr->exec()) {
+            if (qr->numRowsAffected() == 1) {
+                qr->finish();
+                EOrmRecordCache::invalidate(this->db(), this->tableName(),
+                                            this->m_pk);
+                EOrmQueryCache::invalidate(this->db(), this->tableName());
+                EOrmIdentityMap *map = EOrmIdentityMap::current();
+                if (map != 0) {
+                    map->expire(this);
+                }
                 if (updateProperties) {
                     this->clear();
                 }
-                this->db().commit();
+                EOrm::commit(this->db());
                 return true;
             } else {
-                if (qr.numRowsAffected() > 1) {
-                    qr.finish();
-                    this->db().rollback();
+                if (qr->numRowsAffected() > 1) {
+                    qr->finish();
+                    EOrm::rollback(this->db());
                     EOrm::throwError(11, "Remove: Try to delete more "
                                      "than one object");
                 } else {
-                    qr.finish();
-                    this->db().rollback();
+                    qr->finish();
+                    EOrm::rollback(this->db());
                     EOrm::throwError(12, "Remove: Object deleting failed");
                 }
             }
         } else {
-            qr.finish();
-            this->db().rollback();
+            qr->finish();
+            EOrm::rollback(this->db());
             EOrm::throwError(10, "Remove: Execute query failed");
         }
     } else {
-        qr.finish();
-        this->db().rollback();
+        EOrm::rollback(this->db());
         EOrm::throwError(9, "Remove: Prepare query failed");
     }
-    qr.finish();
-    this->db().rollback();
+    EOrm::rollback(this->db());
     return false;
 }
 
@@ -413,8 +566,12 @@ bool EOrmActiveRecord::remove(bool updateProperties)
  * \brief Function save object state inot database.
  *
  *  If such object does not exist in database it formed. In the opposite a case
- *  the data of object is updated. If updateProperties parameter is equal TRUE,
- *  after saving of object it`s properties will be force reloaded.
+ *  the data of object is updated. Only columns changed since the last loading
+ *  or saving are updated, columns are listed in database order, so the same
+ *  set of changes produce the same statement. Saving of unchanged object does
+ *  not query database at all. If updateProperties parameter is equal TRUE,
+ *  after saving of object it`s properties will be force reloaded (same as
+ *  FullRefresh mode), otherwise they are not refreshed (NoRefresh mode).
  * \param updateProperties - update properties, TRUE by default
  * \return bool
  * \endlang
@@ -423,8 +580,13 @@ bool EOrmActiveRecord::remove(bool updateProperties)
  * \brief Функция сохрания объекта.
  *
  *  Если такого объекта не существует в базе, то он создается. В противном
- *  случае данные объекта обновляются. Если параметр updateProperties равен
- *  TRUE, после сохранения свойства объекта тут же снова загружаются. Это
+ *  случае данные объекта обновляются. Обновляются только столбцы, измененные
+ *  с момента последней загрузки или сохранения, столбцы перечисляются в
+ *  порядке базы, поэтому одинаковый набор изменений дает одинаковый запрос.
+ *  Сохранение неизмененного объекта к базе не обращается. Если параметр
+ *  updateProperties равен
+ *  TRUE, после сохранения свойства объекта тут же снова загружаются (режим
+ *  FullRefresh), иначе они не обновляются (режим NoRefresh). Это
  *  необходимо,например, при замене первичного ключа.
  * \param updateProperties - нужно ли обновлять свойства, TRUE по-умолчанию
  * \return bool
@@ -432,49 +594,164 @@ bool EOrmActiveRecord::remove(bool updateProperties)
  */
 bool EOrmActiveRecord::save(bool updateProperties)
 {
-    QHash<QString, QVariant> properties = this->properties();
+    return this->save(updateProperties ? EOrmActiveRecord::FullRefresh
+                                       : EOrmActiveRecord::NoRefresh);
+}
+
+/*!
+ * \lang_en
+ * \brief Function save object state into database with the given refresh
+ *  mode.
+ *
+ *  Refresh mode defines what happens with columns after the statement:
+ *  NoRefresh keeps values of object as is, FullRefresh refreshes all columns,
+ *  DefaultsRefresh refreshes only columns which were not written by the
+ *  statement (primary key, server defaults, trigger values),
+ *  InvalidateDefaults marks such columns as not loaded. If the database
+ *  supports RETURNING clause (see EOrm::supportsReturning()), refreshed
+ *  columns are returned by the same statement. Otherwise FullRefresh reloads
+ *  object by the second statement and DefaultsRefresh acts as
+ *  InvalidateDefaults. Not loaded columns are selected by one statement at the
+ *  first reading of any of them.
+ * \param mode - refresh mode
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция сохранения объекта с заданным режимом обновления свойств.
+ *
+ *  Режим обновления определяет, что происходит со столбцами после запроса:
+ *  NoRefresh оставляет значения объекта как есть, FullRefresh обновляет все
+ *  столбцы, DefaultsRefresh обновляет только столбцы, которые не записывались
+ *  запросом (первичный ключ, значения по-умолчанию сервера, значения
+ *  триггеров), InvalidateDefaults отмечает такие столбцы незагруженными. Если
+ *  база поддерживает выражение RETURNING (см. EOrm::supportsReturning()),
+ *  обновляемые столбцы возвращаются тем же запросом. Иначе FullRefresh
+ *  перезагружает объект вторым запросом, а DefaultsRefresh действует как
+ *  InvalidateDefaults. Незагруженные столбцы выбираются одним запросом при
+ *  первом чтении любого из них.
+ * \param mode - режим обновления
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::save(RefreshMode mode)
+{
+    bool exists = this->m_pk.isValid();
+    if (exists && !this->isDirty()) {
+        return true;
+    }
     QStringList propList;
     QVariantList propValues;
-    bool withPrimaryKey = false;
-    if (this->m_pk != this->property(
-            this->primaryKeyName().toUtf8())) {
-        withPrimaryKey = true;
-    }
-    QHashIterator<QString, QVariant> i(properties);
-    while (i.hasNext()) {
-        i.next();
-        if (i.key() == this->primaryKeyName() && withPrimaryKey == false) {
-            continue;
-        }
-        //! \todo add exception throwing if required key is empty
-        if (this->m_requiredProperties.contains(i.key())
-            && i.value().isNull()) {
-            continue;
+    this->changes(exists, &propList, &propValues);
+    if (exists) {
+        if (propList.isEmpty()) {
+            return true;
         }
-        propList << i.key();
-        propValues << i.value();
-    }
-    if (this->m_pk.isValid()) {
-        if (this->updateObject(propList, propValues, updateProperties)) {
+        QVariant oldPk = this->m_pk;
+        EOrmRecordCache::invalidate(this->db(), this->tableName(), oldPk);
+        if (this->updateObject(propList, propValues, mode)) {
+            EOrmRecordCache::invalidate(this->db(), this->tableName(), oldPk);
+            EOrmRecordCache::invalidate(this->db(), this->tableName(),
+                                        this->m_pk);
+            EOrmQueryCache::invalidate(this->db(), this->tableName());
             return true;
         }
     } else {
-        if (this->insertObject(propList, propValues, updateProperties)) {
+        if (this->insertObject(propList, propValues, mode)) {
+            EOrmRecordCache::invalidate(this->db(), this->tableName(),
+                                        this->m_pk);
+            EOrmQueryCache::invalidate(this->db(), this->tableName());
             return true;
         }
     }
     return false;
 }
 
+/*!
+ * \lang_en
+ * \brief Function collect columns and values which should be written.
+ *
+ *  For existing object only changed columns are collected, for new object all
+ *  columns except primary key, which was not set. Required columns with null
+ *  value and not loaded columns are skipped. Columns are listed in database
+ *  order.
+ * \param exists - is object exist in database
+ * \param columns - the list of columns
+ * \param values - the list of values of columns
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция собирает столбцы и значения, которые нужно записать.
+ *
+ *  Для существующего объекта собираются только измененные столбцы, для
+ *  нового - все столбцы, кроме незаданного первичного ключа. Обязательные
+ *  столбцы с нулевым значением и незагруженные столбцы пропускаются. Столбцы
+ *  перечисляются в порядке базы.
+ * \param exists - существует ли объект в базе
+ * \param columns - список столбцов
+ * \param values - список значений столбцов
+ * \endlang
+ */
+void EOrmActiveRecord::changes(bool exists, QStringList *columns,
+                               QVariantList *values)
+{
+    QStringList prop = this->columns();
+    int pkIndex = prop.indexOf(this->primaryKeyName());
+    for (int i = 0; i < prop.count(); i++) {
+        bool dirty = this->m_dirty.testBit(i);
+        if (exists && !dirty) {
+            continue;
+        }
+        if (i == pkIndex && !dirty) {
+            continue;
+        }
+        if (this->m_stale.testBit(i)) {
+            continue;
+        }
+        //! \todo add exception throwing if required key is empty
+        if (this->m_table->isRequired(i) && this->m_values.at(i).isNull()) {
+            continue;
+        }
+        *columns << prop.at(i);
+        *values << this->m_values.at(i);
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function mark object as saved with the given primary key.
+ * \param primaryKey - primary key
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция отмечает объект сохраненным с заданным первичным ключом.
+ * \param primaryKey - первичный ключ
+ * \endlang
+ */
+void EOrmActiveRecord::setSaved(const QVariant &primaryKey)
+{
+    this->m_pk = primaryKey;
+    if (!this->m_table.isNull()) {
+        int index = this->m_table->indexOf(this->primaryKeyName());
+        if (index > -1) {
+            this->m_values[index] = primaryKey;
+        }
+    }
+    this->m_dirty.fill(false);
+}
+
 /*!
  * \lang_en
  * \brief Update of object.
  *
  *  This function is called by save() function if current object already exists.
- *  If it is necessary to update properties, updateProperties are expos in TRUE.
+ *  If properties are refreshed by RETURNING clause, the only statement is
+ *  executed. If properties are reloaded by the second statement, both are
+ *  executed in one transaction. Otherwise the only statement is executed
+ *  without explicit transaction.
  * \param properties - the list of update properties
  * \param values - the list of values of properties
- * \param updateProperties - reload of properties, TRUE by default
+ * \param mode - refresh mode
  * \return bool
  * \endlang
  *
@@ -482,78 +759,93 @@ bool EOrmActiveRecord::save(bool updateProperties)
  * \brief Функция обновления объекта.
  *
  *  Данная функция вызывается функцией save(),если данный объект уже существует.
- *  Если его свойства необходимо обновить, updateProperties выставляется в TRUE.
+ *  Если свойства обновляются выражением RETURNING, выполняется единственный
+ *  запрос. Если свойства перезагружаются вторым запросом, оба выполняются в
+ *  одной транзакции. Иначе выполняется единственный запрос без явной
+ *  транзакции.
  * \param properties - список обновляемых свойств
  * \param values - список значений свойств
- * \param updateProperties - перезагрузка свойств с базы, TRUE по-умолчанию
+ * \param mode - режим обновления свойств
  * \return bool
  * \endlang
  */
 bool EOrmActiveRecord::updateObject(QStringList properties, QVariantList values,
-                                    bool updateProperties)
-{
-    QStringList sql;
-    sql << "UPDATE";
-    sql << this->tableName();
-    sql << "SET";
-    for (int i = 0; i < properties.count(); i++) {
-        sql << properties.value(i) + " = ?";
-        sql << ", ";
-    }
-    sql.removeLast();
-    sql << "WHERE";
-    sql << this->primaryKeyName() + " = ?";
-    this->db().transaction();
-    QSqlQuery qr(this->db());
-    if (qr.prepare(sql.join(" "))) {
+                                    RefreshMode mode)
+{
+    QVariant newPk = this->value(this->primaryKeyName());
+    if (!newPk.isValid() || newPk.isNull()) {
+        EOrm::throwError(22, "Update: New primary key NULL or invalid");
+        return false;
+    }
+    QStringList returning;
+    if (EOrm::supportsReturning(this->db())) {
+        if (mode == EOrmActiveRecord::FullRefresh) {
+            returning = this->columns();
+        } else if (mode == EOrmActiveRecord::DefaultsRefresh) {
+            returning = this->unwritten(properties);
+        }
+    }
+    bool reload = (mode == EOrmActiveRecord::FullRefresh
+                   && returning.isEmpty());
+    if (reload) {
+        EOrm::transaction(this->db());
+    }
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                this->db(), EOrmStatementCache::Update, this->tableName(),
+                this->primaryKeyName(), properties, 1, returning);
+    if (!qr.isNull()) {
         for (int i = 0; i < values.count(); i++) {
-            qr.addBindValue(values.value(i));
+            qr->bindValue(i, values.value(i));
         }
-        qr.addBindValue(this->m_pk);
-        if (qr.exec()) {
-            if (qr.numRowsAffected() > 0) {
-                if (updateProperties) {
-                    if (this->load(this->property(
-                                       qPrintable(this->primaryKeyName())))) {
-                        this->db().commit();
+        qr->bindValue(values.count(), this->m_pk);
+        if (qr->exec()) {
+            if (!returning.isEmpty()) {
+                bool updated = qr->next() && this->refresh(*qr, returning);
+                qr->finish();
+                if (updated) {
+                    return true;
+                }
+                EOrm::throwError(15, "Update: Object updating failed");
+                return false;
+            }
+            int rowsAffected = qr->numRowsAffected();
+            qr->finish();
+            if (rowsAffected > 0) {
+                if (reload) {
+                    if (this->load(newPk)) {
+                        EOrm::commit(this->db());
                         return true;
                     } else {
-                        qr.finish();
-                        this->db().rollback();
+                        EOrm::rollback(this->db());
                         EOrm::throwError(21, "Update: Can not update "
                                          "properties state");
                     }
                 } else {
-                    QVariant newPk = this->property(
-                                     qPrintable(this->primaryKeyName()));
-                    if (newPk.isValid() && !newPk.isNull()) {
-                        this->m_pk = newPk;
-                        this->db().commit();
-                        return true;
-                    } else {
-                        qr.finish();
-                        this->db().rollback();
-                        EOrm::throwError(22, "Update: New primary key NULL or"
-                                         " invalid");
+                    this->setSaved(newPk);
+                    if (mode != EOrmActiveRecord::NoRefresh) {
+                        this->invalidate(this->unwritten(properties));
                     }
+                    return true;
                 }
             } else {
-                qr.finish();
-                this->db().rollback();
+                if (reload) {
+                    EOrm::rollback(this->db());
+                }
                 EOrm::throwError(15, "Update: Object updating failed");
             }
         } else {
-            qr.finish();
-            this->db().rollback();
+            qr->finish();
+            if (reload) {
+                EOrm::rollback(this->db());
+            }
             EOrm::throwError(14, "Update: Execute query failed");
         }
     } else {
-        qr.finish();
-        this->db().rollback();
+        if (reload) {
+            EOrm::rollback(this->db());
+        }
         EOrm::throwError(13, "Update: Prepare query failed");
     }
-    qr.finish();
-    this->db().rollback();
     return false;
 }
 
@@ -562,9 +854,12 @@ bool EOrmActiveRecord::updateObject(QStringList properties, QVariantList values,
  * \brief Insert new object.
  *
  *  It is call from function save() if the object does not exists in database.
+ *  If the database supports RETURNING clause, generated primary key and
+ *  refreshed columns are returned by the insert statement itself, without
+ *  reloading.
  * \param properties - the list of update properties
  * \param values - the list of values of properties
- * \param updateProperties - reload of properties, TRUE by default
+ * \param mode - refresh mode
  * \return bool
  * \endlang
  *
@@ -572,184 +867,1363 @@ bool EOrmActiveRecord::updateObject(QStringList properties, QVariantList values,
  * \brief Функция добавления объекта.
  *
  *  Вызывается из функции save(), если сохраняемого объекта не существует в базе.
+ *  Если база поддерживает выражение RETURNING, сгенерированный первичный ключ
+ *  и обновляемые столбцы возвращаются самим запросом добавления, без
+ *  перезагрузки.
  * \param properties - список обновляемых свойств
  * \param values - список значений свойств
- * \param updateProperties - перезагрузка свойств с базы, TRUE по-умолчанию
+ * \param mode - режим обновления свойств
  * \return bool
  * \endlang
  */
 bool EOrmActiveRecord::insertObject(QStringList properties, QVariantList values,
-                                    bool updateProperties)
-{
-    QStringList sql;
-    sql << "INSERT INTO";
-    sql << this->tableName();
-    sql << "(" + properties.join(",") + ")";
-    sql << "VALUES";
-    sql << "(" + this->placeholders(values) + ")";
-    this->db().transaction();
-    QSqlQuery qr(this->db());
-    if (qr.prepare(sql.join(" "))) {
+                                    RefreshMode mode)
+{
+    QStringList returning;
+    if (EOrm::supportsReturning(this->db())) {
+        if (mode == EOrmActiveRecord::FullRefresh) {
+            returning = this->columns();
+        } else if (mode == EOrmActiveRecord::DefaultsRefresh) {
+            returning = this->unwritten(properties);
+        }
+        if (!returning.contains(this->primaryKeyName())) {
+            returning << this->primaryKeyName();
+        }
+    }
+    EOrm::transaction(this->db());
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                this->db(), EOrmStatementCache::Insert, this->tableName(),
+                this->primaryKeyName(), properties, 1, returning);
+    if (!qr.isNull()) {
         for (int i = 0; i < values.count(); i++) {
-            qr.addBindValue(values.value(i));
+            qr->bindValue(i, values.value(i));
         }
-        if (qr.exec()) {
-            if (qr.numRowsAffected()) {
-                if (updateProperties) {
-                    if (this->load(this->lastInsertId(&qr))) {
-                        this->db().commit();
+        if (qr->exec()) {
+            if (!returning.isEmpty()) {
+                bool saved = qr->next() && this->refresh(*qr, returning)
+                        && !this->m_pk.isNull();
+                qr->finish();
+                if (saved) {
+                    if (mode == EOrmActiveRecord::InvalidateDefaults) {
+                        this->invalidate(this->unwritten(properties));
+                    }
+                    EOrm::commit(this->db());
+                    return true;
+                }
+                this->m_pk = QVariant();
+                EOrm::rollback(this->db());
+                EOrm::throwError(24, "Insert: New primary key NULL or invalid");
+            } else if (qr->numRowsAffected()) {
+                if (mode == EOrmActiveRecord::FullRefresh) {
+                    if (this->load(this->lastInsertId(qr.data()))) {
+                        qr->finish();
+                        EOrm::commit(this->db());
                         return true;
                     } else {
-                        qr.finish();
-                        this->db().rollback();
+                        qr->finish();
+                        EOrm::rollback(this->db());
                         EOrm::throwError(23, "Insert: Can not update "
                                          "properties state");
                     }
                 } else {
-                     QVariant newPk = this->lastInsertId(&qr);
+                    QVariant newPk = this->lastInsertId(qr.data());
+                    qr->finish();
                     if (newPk.isValid() && !newPk.isNull()) {
-                        this->m_pk = newPk;
-                        this->db().commit();
+                        this->setSaved(newPk);
+                        if (mode != EOrmActiveRecord::NoRefresh) {
+                            this->invalidate(this->unwritten(properties));
+                        }
+                        EOrm::commit(this->db());
                         return true;
                     } else {
-                        qr.finish();
-                        this->db().rollback();
+                        EOrm::rollback(this->db());
                         EOrm::throwError(24, "Insert: New primary key NULL or"
                                          " invalid");
                     }
                 }
             } else {
-                qr.finish();
-                this->db().rollback();
+                qr->finish();
+                EOrm::rollback(this->db());
                 EOrm::throwError(18, "Insert: Object inserting failed");
             }
         } else {
-            qr.finish();
-            this->db().rollback();
+            qr->finish();
+            EOrm::rollback(this->db());
             EOrm::throwError(17, "Insert: Execute query failed");
         }
     } else {
-        qr.finish();
-        this->db().rollback();
+        EOrm::rollback(this->db());
         EOrm::throwError(16, "Insert: Prepare query failed");
     }
-    qr.finish();
-    this->db().rollback();
+    EOrm::rollback(this->db());
     return false;
 }
 
 /*!
  * \lang_en
- * \brief Function substitute variables with placeholders.
+ * \brief Function returned copy of state of object: primary key, values and
+ *  flags of columns.
+ * \return State
+ * \endlang
  *
- *  Returned a line from "?", enumerat through a comma, an amount equal
- *  to an amount of lines in the list. It are necessary for convenience of
- *  operation with a database.
- * \param list - the list (as a rule properties of object)
- * \return QString
+ * \lang_ru
+ * \brief Функция возвращает копию состояния объекта: первичный ключ,
+ *  значения и признаки столбцов.
+ * \return State
+ * \endlang
+ */
+EOrmActiveRecord::State EOrmActiveRecord::state() const
+{
+    State result;
+    result.pk = this->m_pk;
+    result.values = this->m_values;
+    result.dirty = this->m_dirty;
+    result.stale = this->m_stale;
+    result.table = this->m_table;
+    return result;
+}
+
+/*!
+ * \lang_en
+ * \brief Function restore state of object taken by state(), it is used
+ *  after rollback of transaction.
+ * \param state - state of object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция восстанавливает состояние объекта, полученное функцией
+ *  state(), используется после отката транзакции.
+ * \param state - состояние объекта
+ * \endlang
+ */
+void EOrmActiveRecord::restore(const State &state)
+{
+    this->m_pk = state.pk;
+    this->m_values = state.values;
+    this->m_dirty = state.dirty;
+    this->m_stale = state.stale;
+    this->m_table = state.table;
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, take states of objects before they are written.
+ *
+ *  Static write functions change objects before their transaction is
+ *  committed: set generated keys, clear removed objects. Snapshot is
+ *  declared before EOrmTransaction, so if the transaction is rolled back the
+ *  destructor restores objects to their states, unless release() is called
+ *  after successful commit.
+ * \param objects - the list of objects
  * \endlang
  *
  * \lang_ru
- * \brief Функция замещения переменных плейсхолдерами.
+ * \brief Конструктор, запоминает состояния объектов до их записи.
  *
- *  Возвращает строчку из "?", перечисленных через запятую, количеством, равным
- *  количеству строчек в списке. Нужна для удобства работы с базой данных.
- * \param list - список (как правило свойств объекта)
- * \return QString
+ *  Статические функции записи изменяют объекты до фиксации своей транзакции:
+ *  присваивают сгенерированные ключи, очищают удаленные объекты. Snapshot
+ *  объявляется до EOrmTransaction, поэтому при откате транзакции деструктор
+ *  восстанавливает состояния объектов, если после успешной фиксации не
+ *  вызвана release().
+ * \param objects - список объектов
  * \endlang
  */
-QString EOrmActiveRecord::placeholders(QVariantList list)
+EOrmActiveRecord::Snapshot::Snapshot(
+        const QList<EOrmActiveRecord*> &objects) :
+    m_objects(objects), m_released(false)
 {
-    QStringList phList;
-    for (int i = 0; i < list.count(); i++) {
-        phList << "?";
+    foreach (EOrmActiveRecord *obj, objects) {
+        this->m_states << obj->state();
     }
-    return phList.join(",");
 }
 
 /*!
  * \lang_en
- * \brief Returned the last inserted primary key.
+ * \brief Destructor, restore states of objects if they were not released.
+ * \endlang
  *
- *  Generally similar function exists in Qt, however by operation with
- *  the QPSQL driver it returned a little not that it are expected.
- * \param insertQuery - the link to request
- * \return QVariant
+ * \lang_ru
+ * \brief Деструктор, восстанавливает состояния объектов, если они не
+ *  освобождены.
+ * \endlang
+ */
+EOrmActiveRecord::Snapshot::~Snapshot()
+{
+    if (this->m_released) {
+        return;
+    }
+    for (int i = 0; i < this->m_objects.count(); i++) {
+        this->m_objects.at(i)->restore(this->m_states.at(i));
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function keep current states of objects, it is called after
+ *  commit.
  * \endlang
  *
  * \lang_ru
- * \brief Ворзвращает последний вставленный первичный ключ.
+ * \brief Функция сохраняет текущие состояния объектов, вызывается после
+ *  фиксации.
+ * \endlang
+ */
+void EOrmActiveRecord::Snapshot::release()
+{
+    this->m_released = true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned columns of object, which are not in the list of
+ *  written columns.
+ * \param written - the list of written columns
+ * \return QStringList
+ * \endlang
  *
- *  Вообще подобная функция есть и стреди стандартных в Qt, однако при работе с
- *  драйвером QPSQL она возвращает немного не то, что ожидается.
- * \param insertQuery - ссылка на запрос
- * \return QVariant
+ * \lang_ru
+ * \brief Функция возвращает столбцы объекта, которых нет в списке
+ *  записываемых столбцов.
+ * \param written - список записываемых столбцов
+ * \return QStringList
  * \endlang
  */
-QVariant EOrmActiveRecord::lastInsertId(QSqlQuery *insertQuery)
+QStringList EOrmActiveRecord::unwritten(const QStringList &written) const
 {
-    if (this->db().driverName() == "QPSQL") {
-        QString sql = QString("SELECT MAX(%1) FROM %2").arg(
-                          this->primaryKeyName()).arg(this->tableName());
-        QSqlQuery qr(this->db());
-        if (qr.exec(sql)) {
-            if (qr.size() == 1) {
-                qr.next();
-                return qr.value(0);
-            } else {
-                EOrm::throwError(20, "Last insert ID for QPSQL: Empty result");
-            }
-        } else {
-            EOrm::throwError(19, "Last insert ID for QPSQL: "
-                             "Execute query failed");
+    QStringList result;
+    foreach (QString column, this->columns()) {
+        if (!written.contains(column)) {
+            result << column;
         }
-    } else {
-        return insertQuery->lastInsertId();
     }
-    return QVariant();
+    return result;
 }
 
 /*!
  * \lang_en
- * \brief Function returned hash of properties of object.
- * \return QHash <QString, QVariant>
+ * \brief Function fill columns of object from the row returned by RETURNING
+ *  clause.
+ *
+ *  Other columns keep their values. Object is marked as saved.
+ * \param query - positioned on a valid row query
+ * \param returning - the list of returned columns
+ * \return bool
  * \endlang
  *
  * \lang_ru
- * \brief Функция возвращает хэш свойств объекта.
- * \return QHash<QString, QVariant>
+ * \brief Функция заполняет столбцы объекта из строки, возвращенной выражением
+ *  RETURNING.
+ *
+ *  Остальные столбцы сохраняют свои значения. Объект отмечается сохраненным.
+ * \param query - запрос, спозиционированный на строке
+ * \param returning - список возвращаемых столбцов
+ * \return bool
  * \endlang
  */
-QHash<QString, QVariant> EOrmActiveRecord::properties()
+bool EOrmActiveRecord::refresh(const QSqlQuery &query,
+                               const QStringList &returning)
 {
-    QHash<QString, QVariant> propList;
-    if (this->m_properties.count() > 0) {
-        foreach (QString prop, this->m_properties) {
-            propList.insert(prop, this->property(prop.toUtf8()));
+    QVector<int> indexes(this->m_values.count(), -1);
+    for (int i = 0; i < returning.count(); i++) {
+        int index = this->m_table->indexOf(returning.at(i));
+        if (index > -1) {
+            indexes[index] = i;
         }
     }
-    return propList;
+    return this->hydrate(query, indexes);
 }
 
 /*!
  * \lang_en
- * \brief Function of check, whether are property mandatory
+ * \brief Function mark columns as not loaded.
  *
- *  Function checked could or not property to accept null value.
- * \param propertyName - the name of property
+ *  Primary key is never marked. Values of such columns are selected at the
+ *  first reading.
+ * \param columns - the list of columns
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция отмечает столбцы незагруженными.
+ *
+ *  Первичный ключ никогда не отмечается. Значения таких столбцов выбираются
+ *  при первом чтении.
+ * \param columns - список столбцов
+ * \endlang
+ */
+void EOrmActiveRecord::invalidate(const QStringList &columns)
+{
+    QString pkName = this->primaryKeyName();
+    foreach (QString column, columns) {
+        int index = this->m_table->indexOf(column);
+        if (index > -1 && column != pkName) {
+            this->m_stale.setBit(index);
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function select values of all not loaded columns by one statement.
+ *
+ *  Columns stay marked as not loaded until their values are copied, so
+ *  after an error they are selected again at the next reading. If the object
+ *  was selected together with other objects (see share()), not loaded columns
+ *  of all of them are selected at once by fetchStaleAll().
  * \return bool
  * \endlang
  *
  * \lang_ru
- * \brief Функция проверки, является ли свойство обязательным.
+ * \brief Функция выбирает значения всех незагруженных столбцов одним
+ *  запросом.
  *
- *  Функция проверяет, является ли свойство необходимым, т.е. может оно
- *  или нет принимать нулевое значение.
- * \param propertyName - наименование свойства
+ *  Столбцы остаются отмеченными незагруженными до копирования их значений,
+ *  поэтому после ошибки они выбираются снова при следующем чтении. Если
+ *  объект выбран вместе с другими объектами (см. share()), незагруженные
+ *  столбцы их всех выбираются сразу функцией fetchStaleAll().
  * \return bool
  * \endlang
  */
-bool EOrmActiveRecord::isRequired(QString propertyName)
+bool EOrmActiveRecord::fetchStale()
 {
-    return !(this->m_requiredProperties.indexOf(propertyName) == -1);
+    QStringList columns;
+    QVector<int> indexes;
+    for (int i = 0; i < this->m_stale.count(); i++) {
+        if (this->m_stale.testBit(i)) {
+            columns << this->m_table->column(i);
+            indexes << i;
+        }
+    }
+    if (columns.isEmpty()) {
+        return true;
+    }
+    if (!this->m_pk.isValid()) {
+        this->m_stale.fill(false);
+        return true;
+    }
+    if (!this->m_siblings.isNull()) {
+        QList<EOrmActiveRecord*> objects;
+        foreach (QPointer<EOrmActiveRecord> obj, *this->m_siblings) {
+            if (!obj.isNull() && obj->m_pk.isValid()
+                    && obj->m_stale == this->m_stale) {
+                objects << obj.data();
+            }
+        }
+        if (objects.count() > 1) {
+            EOrmActiveRecord::fetchStaleAll(objects);
+            if (this->m_stale.count(true) > 0) {
+                EOrm::throwError(43, "Lazy load: Object is missing in "
+                                 "database");
+                return false;
+            }
+            return true;
+        }
+    }
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                this->db(), EOrmStatementCache::Select, this->tableName(),
+                this->primaryKeyName(), columns);
+    if (qr.isNull()) {
+        EOrm::throwError(41, "Lazy load: Prepare query failed");
+        return false;
+    }
+    qr->bindValue(0, this->m_pk);
+    if (!qr->exec()) {
+        qr->finish();
+        EOrm::throwError(42, "Lazy load: Execute query failed");
+        return false;
+    }
+    if (!qr->next()) {
+        qr->finish();
+        EOrm::throwError(43, "Lazy load: Object is missing in database");
+        return false;
+    }
+    for (int i = 0; i < indexes.count(); i++) {
+        this->m_values[indexes.at(i)] = qr->value(i);
+        this->m_stale.clearBit(indexes.at(i));
+    }
+    qr->finish();
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function select not loaded columns of several objects.
+ *
+ *  Objects should be of one table and have the same not loaded columns.
+ *  Columns are selected by primary keys with IN, the count of keys in one
+ *  statement is limited by EOrm::maxBindValues(). Objects missing in
+ *  database keep columns not loaded.
+ * \param objects - the list of objects
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция выбирает незагруженные столбцы нескольких объектов.
+ *
+ *  Объекты должны быть одной таблицы и иметь одинаковые незагруженные
+ *  столбцы. Столбцы выбираются по первичным ключам с IN, количество ключей в
+ *  одном запросе ограничивается EOrm::maxBindValues(). У объектов,
+ *  отсутствующих в базе, столбцы остаются незагруженными.
+ * \param objects - список объектов
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::fetchStaleAll(const QList<EOrmActiveRecord*> &objects)
+{
+    if (objects.isEmpty()) {
+        return true;
+    }
+    EOrmActiveRecord *first = objects.first();
+    QStringList columns;
+    QVector<int> indexes;
+    for (int i = 0; i < first->m_stale.count(); i++) {
+        if (first->m_stale.testBit(i)) {
+            columns << first->m_table->column(i);
+            indexes << i;
+        }
+    }
+    if (columns.isEmpty()) {
+        return true;
+    }
+    QSqlDatabase db = first->db();
+    QString pkName = first->primaryKeyName();
+    QHash<QString, EOrmActiveRecord*> keys;
+    foreach (EOrmActiveRecord *obj, objects) {
+        keys.insert(obj->m_pk.toString(), obj);
+    }
+    int maxRows = qMax(1, EOrm::maxBindValues(db));
+    for (int i = 0; i < objects.count(); i += maxRows) {
+        QList<EOrmActiveRecord*> chunk = objects.mid(i, maxRows);
+        QStringList sql;
+        sql << "SELECT";
+        sql << pkName + "," + columns.join(",");
+        sql << "FROM";
+        sql << first->tableName();
+        sql << "WHERE";
+        sql << pkName + " IN ("
+               + EOrmStatementCache::placeholders(chunk.count()) + ")";
+        QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                    db, sql.join(" "));
+        if (qr.isNull()) {
+            EOrm::throwError(41, "Lazy load: Prepare query failed");
+            return false;
+        }
+        for (int j = 0; j < chunk.count(); j++) {
+            qr->bindValue(j, chunk.at(j)->m_pk);
+        }
+        if (!qr->exec()) {
+            qr->finish();
+            EOrm::throwError(42, "Lazy load: Execute query failed");
+            return false;
+        }
+        while (qr->next()) {
+            EOrmActiveRecord *obj = keys.value(qr->value(0).toString());
+            if (obj == 0) {
+                continue;
+            }
+            for (int j = 0; j < indexes.count(); j++) {
+                obj->m_values[indexes.at(j)] = qr->value(j + 1);
+                obj->m_stale.clearBit(indexes.at(j));
+            }
+        }
+        qr->finish();
+    }
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function join partially loaded objects of one selection.
+ *
+ *  It is called by EOrmFind after selection with select(). Reading a not
+ *  loaded column of one of the objects selects it for all joined objects,
+ *  so a list or a model of such objects does not execute a statement per
+ *  object. Objects are held by weak pointers, deleted objects are skipped.
+ * \param objects - the list of objects
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция объединяет частично загруженные объекты одной выборки.
+ *
+ *  Вызывается EOrmFind после выборки с select(). Чтение незагруженного
+ *  столбца одного из объектов выбирает его для всех объединенных объектов,
+ *  поэтому список или модель таких объектов не выполняет запрос на каждый
+ *  объект. Объекты хранятся слабыми указателями, удаленные объекты
+ *  пропускаются.
+ * \param objects - список объектов
+ * \endlang
+ */
+void EOrmActiveRecord::share(QList<EOrmActiveRecord*> objects)
+{
+    QSharedPointer<Siblings> siblings(new Siblings());
+    foreach (EOrmActiveRecord *obj, objects) {
+        if (obj->m_stale.count(true) > 0) {
+            *siblings << QPointer<EOrmActiveRecord>(obj);
+        }
+    }
+    if (siblings->count() < 2) {
+        return;
+    }
+    foreach (QPointer<EOrmActiveRecord> obj, *siblings) {
+        obj->m_siblings = siblings;
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Returned the last inserted primary key.
+ *
+ *  It is used only for databases without RETURNING clause. QPSQL driver always
+ *  returns keys by RETURNING clause, because its lastInsertId() gives OID
+ *  instead of primary key.
+ * \param insertQuery - the link to request
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Ворзвращает последний вставленный первичный ключ.
+ *
+ *  Используется только для баз без выражения RETURNING. Драйвер QPSQL всегда
+ *  возвращает ключи выражением RETURNING, так как его lastInsertId() дает OID
+ *  вместо первичного ключа.
+ * \param insertQuery - ссылка на запрос
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmActiveRecord::lastInsertId(QSqlQuery *insertQuery)
+{
+    return insertQuery->lastInsertId();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned hash of properties of object.
+ * \return QHash <QString, QVariant>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает хэш свойств объекта.
+ * \return QHash<QString, QVariant>
+ * \endlang
+ */
+QHash<QString, QVariant> EOrmActiveRecord::properties()
+{
+    QHash<QString, QVariant> propList;
+    QStringList columns = this->columns();
+    for (int i = 0; i < columns.count(); i++) {
+        propList.insert(columns.at(i), this->value(i));
+    }
+    return propList;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned value of the column by ordinal.
+ *
+ *  Ordinals of columns are defined by the table metadata (see
+ *  EOrmTableInfo::indexOf()). This is the fastest way to read object values.
+ *  Reading a column marked as not loaded selects it from the database by
+ *  fetchStale(), so this const function can throw EOrmException* when the
+ *  select fails.
+ * \param index - ordinal of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает значение столбца по порядковому номеру.
+ *
+ *  Порядковые номера столбцов определяются метаданными таблицы (см.
+ *  EOrmTableInfo::indexOf()). Это самый быстрый способ чтения значений.
+ *  Чтение столбца, отмеченного незагруженным, выбирает его из базы функцией
+ *  fetchStale(), поэтому эта константная функция может выбросить
+ *  EOrmException* при ошибке выборки.
+ * \param index - порядковый номер столбца
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmActiveRecord::value(int index) const
+{
+    if (index > -1 && index < this->m_stale.count()
+            && this->m_stale.testBit(index)) {
+        const_cast<EOrmActiveRecord*>(this)->fetchStale();
+    }
+    return this->m_values.value(index);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned value of the column by name.
+ *
+ *  Like value(int), it can throw EOrmException* when a not loaded column
+ *  can't be selected.
+ * \param name - name of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает значение столбца по наименованию.
+ *
+ *  Как и value(int), может выбросить EOrmException*, если незагруженный
+ *  столбец не удается выбрать.
+ * \param name - наименование столбца
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmActiveRecord::value(const QString &name) const
+{
+    if (!this->m_table.isNull()) {
+        return this->value(this->m_table->indexOf(name));
+    }
+    return QVariant();
+}
+
+/*!
+ * \lang_en
+ * \brief Function set value of the column by ordinal.
+ *
+ *  If the value differs from current one, the column is marked as changed and
+ *  will be written by save(). Returned FALSE if object has no column with
+ *  such ordinal.
+ * \param index - ordinal of column
+ * \param value - new value
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция устанавливает значение столбца по порядковому номеру.
+ *
+ *  Если значение отличается от текущего, столбец отмечается как измененный и
+ *  будет записан функцией save(). Возвращает FALSE, если у объекта нет
+ *  столбца с таким номером.
+ * \param index - порядковый номер столбца
+ * \param value - новое значение
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::setValue(int index, const QVariant &value)
+{
+    if (index > -1 && index < this->m_values.count()) {
+        const QVariant &current = this->m_values.at(index);
+        if (this->m_stale.testBit(index) || current != value
+                || current.isNull() != value.isNull()) {
+            this->m_values[index] = value;
+            this->m_dirty.setBit(index);
+            this->m_stale.clearBit(index);
+        }
+        return true;
+    }
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Function set value of the column by name.
+ *
+ *  Returned FALSE if object has no column with such name.
+ * \param name - name of column
+ * \param value - new value
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция устанавливает значение столбца по наименованию.
+ *
+ *  Возвращает FALSE, если у объекта нет столбца с таким наименованием.
+ * \param name - наименование столбца
+ * \param value - новое значение
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::setValue(const QString &name, const QVariant &value)
+{
+    if (!this->m_table.isNull()) {
+        return this->setValue(this->m_table->indexOf(name), value);
+    }
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Compatibility function, returned value of the property by name.
+ *
+ *  Values of columns are not stored as dynamic properties of QObject any
+ *  more, so for names of columns value() is used, other names are passed to
+ *  QObject::property(). QObject::property() is not virtual, so call through
+ *  pointer to QObject does not see values of columns: use value() or
+ *  properties() there.
+ * \param name - name of property
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция совместимости, возвращает значение свойства по имени.
+ *
+ *  Значения столбцов больше не хранятся как динамические свойства QObject,
+ *  поэтому для наименований столбцов используется value(), прочие имена
+ *  передаются в QObject::property(). QObject::property() не виртуальна,
+ *  поэтому вызов через указатель на QObject не видит значений столбцов:
+ *  там следует использовать value() или properties().
+ * \param name - имя свойства
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmActiveRecord::property(const char *name) const
+{
+    if (!this->m_table.isNull()) {
+        int index = this->m_table->indexOf(QString::fromUtf8(name));
+        if (index > -1) {
+            return this->value(index);
+        }
+    }
+    return QObject::property(name);
+}
+
+/*!
+ * \lang_en
+ * \brief Compatibility function, set value of the property by name.
+ *
+ *  For names of columns setValue() is used, other names are passed to
+ *  QObject::setProperty(). Call through pointer to QObject is handled by
+ *  event().
+ * \param name - name of property
+ * \param value - new value
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция совместимости, устанавливает значение свойства по имени.
+ *
+ *  Для наименований столбцов используется setValue(), прочие имена
+ *  передаются в QObject::setProperty(). Вызов через указатель на QObject
+ *  обрабатывается в event().
+ * \param name - имя свойства
+ * \param value - новое значение
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::setProperty(const char *name, const QVariant &value)
+{
+    if (!this->m_table.isNull()) {
+        int index = this->m_table->indexOf(QString::fromUtf8(name));
+        if (index > -1) {
+            return this->setValue(index, value);
+        }
+    }
+    return QObject::setProperty(name, value);
+}
+
+/*!
+ * \lang_en
+ * \brief Function handle events of the object.
+ *
+ *  If QObject::setProperty() is called through pointer to QObject with name
+ *  of column, QObject creates dynamic property. Its value is moved to the
+ *  column by setValue() and the dynamic property is removed, so the value is
+ *  saved as if it was set by setProperty() of the object. Setting of invalid
+ *  value this way is not seen, because QObject does not create the property.
+ * \param e - event
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция обработки событий объекта.
+ *
+ *  Если QObject::setProperty() вызывается через указатель на QObject с
+ *  наименованием столбца, QObject создает динамическое свойство. Его значение
+ *  переносится в столбец функцией setValue(), а динамическое свойство
+ *  удаляется, поэтому значение сохраняется так же, как если бы оно было
+ *  установлено функцией setProperty() объекта. Установка таким способом
+ *  недействительного значения не обнаруживается, так как QObject не создает
+ *  свойство.
+ * \param e - событие
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::event(QEvent *e)
+{
+    if (e->type() == QEvent::DynamicPropertyChange
+            && !this->m_table.isNull()) {
+        QByteArray name =
+                static_cast<QDynamicPropertyChangeEvent*>(e)->propertyName();
+        int index = this->m_table->indexOf(QString::fromUtf8(name));
+        if (index > -1) {
+            QVariant value = QObject::property(name);
+            if (value.isValid()) {
+                QObject::setProperty(name, QVariant());
+                this->setValue(index, value);
+            }
+            return true;
+        }
+    }
+    return QObject::event(e);
+}
+
+/*!
+ * \lang_en
+ * \brief Function of check, whether are property mandatory
+ *
+ *  Function checked could or not property to accept null value.
+ * \param propertyName - the name of property
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверки, является ли свойство обязательным.
+ *
+ *  Функция проверяет, является ли свойство необходимым, т.е. может оно
+ *  или нет принимать нулевое значение.
+ * \param propertyName - наименование свойства
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::isRequired(QString propertyName)
+{
+    if (!this->m_table.isNull()) {
+        return this->m_table->isRequired(this->m_table->indexOf(propertyName));
+    }
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Function of check, whether are any column changed since the last
+ *  loading or saving.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверки, изменялся ли какой-либо столбец с момента
+ *  последней загрузки или сохранения.
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::isDirty() const
+{
+    return this->m_dirty.count(true) > 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Function of check, whether are the column changed since the last
+ *  loading or saving.
+ * \param name - name of column
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверки, изменялся ли столбец с момента последней загрузки
+ *  или сохранения.
+ * \param name - наименование столбца
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::isDirty(const QString &name) const
+{
+    if (!this->m_table.isNull()) {
+        int index = this->m_table->indexOf(name);
+        if (index > -1) {
+            return this->m_dirty.testBit(index);
+        }
+    }
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Function of check, whether are value of the column loaded.
+ *
+ *  Columns not selected by EOrmFind::select() or invalidated after saving are
+ *  not loaded, they are never written by save() unless they are set, and
+ *  their values are selected at the first reading.
+ * \param name - name of column
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверки, загружено ли значение столбца.
+ *
+ *  Столбцы, не выбранные EOrmFind::select() или сброшенные после сохранения,
+ *  не загружены, они никогда не записываются функцией save(), если их не
+ *  установить, и их значения выбираются при первом чтении.
+ * \param name - наименование столбца
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::isLoaded(const QString &name) const
+{
+    if (!this->m_table.isNull()) {
+        int index = this->m_table->indexOf(name);
+        if (index > -1) {
+            return !this->m_stale.testBit(index);
+        }
+    }
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned names of object columns in database order.
+ *
+ *  Names are shared with the table metadata, empty list is returned for not
+ *  initialized or cleared object.
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает наименования столбцов объекта в порядке базы.
+ *
+ *  Наименования общие с метаданными таблицы, для неинициализированного или
+ *  очищенного объекта возвращается пустой список.
+ * \return QStringList
+ * \endlang
+ */
+QStringList EOrmActiveRecord::columns() const
+{
+    if (!this->m_table.isNull()) {
+        return this->m_table->columns();
+    }
+    return QStringList();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, insert list of new objects.
+ *
+ *  All objects are inserted in one transaction. On QPSQL objects of the same
+ *  table with the same set of columns, which include the primary key, are
+ *  inserted by one statement with several rows, its size is limited by
+ *  EOrm::maxBindValues(). Objects with generated primary keys are inserted by
+ *  one prepared statement with RETURNING executed for every object, because
+ *  order of rows returned by several rows insert is not guaranteed. Other
+ *  drivers use one prepared statement executed for every object or as one
+ *  batch. Generated primary keys are assigned to objects, properties are not
+ *  reloaded. If any object already exists in database, or any insert failed,
+ *  nothing is inserted and objects are restored to their previous states.
+ * \param objects - the list of new objects
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, добавляет список новых объектов.
+ *
+ *  Все объекты добавляются в одной транзакции. Для QPSQL объекты одной
+ *  таблицы с одинаковым набором столбцов, включающим первичный ключ,
+ *  добавляются одним запросом с несколькими строками, его размер
+ *  ограничивается EOrm::maxBindValues(). Объекты с генерируемыми первичными
+ *  ключами добавляются одним подготовленным запросом с RETURNING,
+ *  выполняемым для каждого объекта, так как порядок строк, возвращаемых
+ *  добавлением нескольких строк, не гарантирован. Для других драйверов
+ *  используется один подготовленный запрос, выполняемый для каждого объекта
+ *  или одним пакетом. Сгенерированные первичные ключи присваиваются
+ *  объектам, свойства не перезагружаются. Если какой-либо объект уже
+ *  существует в базе или добавление не удалось, ничего не добавляется, а
+ *  объекты восстанавливаются в прежние состояния.
+ * \param objects - список новых объектов
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::insertAll(QList<EOrmActiveRecord*> objects)
+{
+    if (objects.isEmpty()) {
+        return true;
+    }
+    QSqlDatabase db = objects.first()->db();
+    bool multiRow = (db.driverName() == "QPSQL");
+    QList<QStringList> columns;
+    QList<QVariantList> values;
+    foreach (EOrmActiveRecord *obj, objects) {
+        if (obj->m_pk.isValid()) {
+            EOrm::throwError(25, "Insert all: Object already exists");
+            return false;
+        }
+        QStringList objColumns;
+        QVariantList objValues;
+        obj->changes(false, &objColumns, &objValues);
+        columns << objColumns;
+        values << objValues;
+    }
+    Snapshot snapshot(objects);
+    EOrmTransaction transaction(db);
+    int i = 0;
+    while (i < objects.count()) {
+        QString tableName = objects.at(i)->tableName();
+        int maxRows = 1;
+        if (multiRow && !columns.at(i).isEmpty()) {
+            maxRows = qMax(1, EOrm::maxBindValues(db) / columns.at(i).count());
+        }
+        QList<EOrmActiveRecord*> chunk;
+        QList<QVariantList> rows;
+        int j = i;
+        while (j < objects.count() && (!multiRow || chunk.count() < maxRows)
+               && objects.at(j)->tableName() == tableName
+               && columns.at(j) == columns.at(i)) {
+            chunk << objects.at(j);
+            rows << values.at(j);
+            j++;
+        }
+        EOrmActiveRecord::insertChunk(db, columns.at(i), chunk, rows,
+                                      multiRow);
+        EOrmQueryCache::invalidate(db, tableName);
+        i = j;
+    }
+    if (!transaction.commit()) {
+        return false;
+    }
+    snapshot.release();
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, update changed columns of list of existing
+ *  objects.
+ *
+ *  Objects are grouped by table and set of changed columns, every group is
+ *  written by one prepared statement: by one batch on QOCI, which reports
+ *  count of rows updated by the whole batch, otherwise by execution for
+ *  every object. Every object should be updated, otherwise error is raised.
+ *  Objects without changes are skipped, properties are not reloaded. All
+ *  objects are updated in one transaction, if it is rolled back objects are
+ *  restored to their previous states.
+ * \param objects - the list of objects
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, обновляет измененные столбцы списка
+ *  существующих объектов.
+ *
+ *  Объекты группируются по таблице и набору измененных столбцов, каждая
+ *  группа записывается одним подготовленным запросом: одним пакетом на QOCI,
+ *  который сообщает количество строк, обновленных всем пакетом, иначе
+ *  выполнением для каждого объекта. Каждый объект должен быть обновлен,
+ *  иначе возникает ошибка. Объекты без изменений пропускаются, свойства не
+ *  перезагружаются. Все объекты обновляются в одной транзакции, при ее
+ *  откате объекты восстанавливаются в прежние состояния.
+ * \param objects - список объектов
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::updateChanged(QList<EOrmActiveRecord*> objects)
+{
+    if (objects.isEmpty()) {
+        return true;
+    }
+    QSqlDatabase db = objects.first()->db();
+    QStringList keys;
+    QHash<QString, QStringList> columns;
+    QHash<QString, QList<EOrmActiveRecord*> > groups;
+    QHash<QString, QList<QVariantList> > rows;
+    foreach (EOrmActiveRecord *obj, objects) {
+        QStringList objColumns;
+        QVariantList objValues;
+        obj->changes(true, &objColumns, &objValues);
+        if (objColumns.isEmpty()) {
+            continue;
+        }
+        QVariant newPk = obj->value(obj->primaryKeyName());
+        if (!newPk.isValid() || newPk.isNull()) {
+            EOrm::throwError(22, "Update: New primary key NULL or invalid");
+            return false;
+        }
+        // where condition takes the old primary key
+        objValues << obj->m_pk;
+        QString key = obj->tableName() + ":" + objColumns.join(",");
+        if (!groups.contains(key)) {
+            keys << key;
+            columns.insert(key, objColumns);
+        }
+        groups[key] << obj;
+        rows[key] << objValues;
+    }
+    // only OCI reports rows affected by the whole batch
+    bool batch = db.driver()->hasFeature(QSqlDriver::BatchOperations)
+            && db.driverName() == "QOCI";
+    Snapshot snapshot(objects);
+    EOrmTransaction transaction(db);
+    foreach (QString key, keys) {
+        QList<EOrmActiveRecord*> group = groups.value(key);
+        QList<QVariantList> groupRows = rows.value(key);
+        EOrmActiveRecord *first = group.first();
+        QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                    db, EOrmStatementCache::Update, first->tableName(),
+                    first->primaryKeyName(), columns.value(key));
+        if (qr.isNull()) {
+            EOrm::throwError(13, "Update: Prepare query failed");
+            return false;
+        }
+        if (batch) {
+            for (int j = 0; j < groupRows.first().count(); j++) {
+                QVariantList column;
+                for (int i = 0; i < groupRows.count(); i++) {
+                    column << groupRows.at(i).at(j);
+                }
+                qr->bindValue(j, column);
+            }
+            if (!qr->execBatch()) {
+                qr->finish();
+                EOrm::throwError(14, "Update: Execute query failed");
+                return false;
+            }
+            int rowsAffected = qr->numRowsAffected();
+            qr->finish();
+            if (rowsAffected != group.count()) {
+                EOrm::throwError(15, "Update: Object updating failed");
+                return false;
+            }
+        } else {
+            for (int i = 0; i < groupRows.count(); i++) {
+                for (int j = 0; j < groupRows.at(i).count(); j++) {
+                    qr->bindValue(j, groupRows.at(i).at(j));
+                }
+                if (!qr->exec()) {
+                    qr->finish();
+                    EOrm::throwError(14, "Update: Execute query failed");
+                    return false;
+                }
+                int rowsAffected = qr->numRowsAffected();
+                qr->finish();
+                if (rowsAffected <= 0) {
+                    EOrm::throwError(15, "Update: Object updating failed");
+                    return false;
+                }
+            }
+        }
+        EOrmQueryCache::invalidate(db, first->tableName());
+        foreach (EOrmActiveRecord *obj, group) {
+            EOrmRecordCache::invalidate(db, obj->tableName(), obj->m_pk);
+            obj->setSaved(obj->value(obj->primaryKeyName()));
+            EOrmRecordCache::invalidate(db, obj->tableName(), obj->m_pk);
+        }
+    }
+    if (!transaction.commit()) {
+        return false;
+    }
+    snapshot.release();
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function insert objects of the same table with the same columns.
+ *
+ *  It is called by insertAll() inside of its transaction. In multi-row mode
+ *  objects with primary key are inserted by one statement, objects with
+ *  generated key are inserted one by one with RETURNING of the key, so every
+ *  key is read from the row of its own object.
+ * \param db - a database object
+ * \param columns - the list of columns
+ * \param objects - the list of objects
+ * \param rows - the list of values of every object
+ * \param multiRow - driver supports insert of several rows with RETURNING
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция добавляет объекты одной таблицы с одинаковыми столбцами.
+ *
+ *  Вызывается функцией insertAll() внутри ее транзакции. В режиме нескольких
+ *  строк объекты с первичным ключом добавляются одним запросом, объекты с
+ *  генерируемым ключом добавляются по одному с возвратом ключа RETURNING,
+ *  поэтому каждый ключ читается из строки своего объекта.
+ * \param db - объект базы данных
+ * \param columns - список столбцов
+ * \param objects - список объектов
+ * \param rows - список значений каждого объекта
+ * \param multiRow - драйвер поддерживает добавление нескольких строк с
+ *  RETURNING
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::insertChunk(QSqlDatabase db, const QStringList &columns,
+                                   QList<EOrmActiveRecord*> objects,
+                                   QList<QVariantList> rows, bool multiRow)
+{
+    EOrmActiveRecord *first = objects.first();
+    QString pkName = first->primaryKeyName();
+    int pkIndex = columns.indexOf(pkName);
+    if (multiRow && pkIndex > -1) {
+        QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                    db, EOrmStatementCache::Insert, first->tableName(), pkName,
+                    columns, objects.count());
+        if (qr.isNull()) {
+            EOrm::throwError(26, "Insert all: Prepare query failed");
+            return false;
+        }
+        int index = 0;
+        for (int i = 0; i < rows.count(); i++) {
+            for (int j = 0; j < rows.at(i).count(); j++) {
+                qr->bindValue(index++, rows.at(i).at(j));
+            }
+        }
+        if (!qr->exec()) {
+            qr->finish();
+            EOrm::throwError(27, "Insert all: Execute query failed");
+            return false;
+        }
+        qr->finish();
+        for (int i = 0; i < objects.count(); i++) {
+            objects.at(i)->setSaved(rows.at(i).at(pkIndex));
+        }
+        return true;
+    }
+    if (multiRow) {
+        // rows of one statement can be returned in any order
+        QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                    db, EOrmStatementCache::Insert, first->tableName(), pkName,
+                    columns, 1, QStringList(pkName));
+        if (qr.isNull()) {
+            EOrm::throwError(26, "Insert all: Prepare query failed");
+            return false;
+        }
+        for (int i = 0; i < objects.count(); i++) {
+            for (int j = 0; j < rows.at(i).count(); j++) {
+                qr->bindValue(j, rows.at(i).at(j));
+            }
+            if (!qr->exec()) {
+                qr->finish();
+                EOrm::throwError(27, "Insert all: Execute query failed");
+                return false;
+            }
+            if (!qr->next()) {
+                qr->finish();
+                EOrm::throwError(28, "Insert all: Generated keys are missing");
+                return false;
+            }
+            QVariant newPk = qr->value(0);
+            qr->finish();
+            objects.at(i)->setSaved(newPk);
+        }
+        return true;
+    }
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                db, EOrmStatementCache::Insert, first->tableName(), pkName,
+                columns);
+    if (qr.isNull()) {
+        EOrm::throwError(26, "Insert all: Prepare query failed");
+        return false;
+    }
+    if (pkIndex > -1 && db.driver()->hasFeature(QSqlDriver::BatchOperations)) {
+        for (int j = 0; j < columns.count(); j++) {
+            QVariantList column;
+            for (int i = 0; i < rows.count(); i++) {
+                column << rows.at(i).at(j);
+            }
+            qr->bindValue(j, column);
+        }
+        if (!qr->execBatch()) {
+            qr->finish();
+            EOrm::throwError(27, "Insert all: Execute query failed");
+            return false;
+        }
+        qr->finish();
+        for (int i = 0; i < objects.count(); i++) {
+            objects.at(i)->setSaved(rows.at(i).at(pkIndex));
+        }
+        return true;
+    }
+    for (int i = 0; i < objects.count(); i++) {
+        for (int j = 0; j < rows.at(i).count(); j++) {
+            qr->bindValue(j, rows.at(i).at(j));
+        }
+        if (!qr->exec()) {
+            qr->finish();
+            EOrm::throwError(27, "Insert all: Execute query failed");
+            return false;
+        }
+        QVariant newPk = pkIndex > -1 ? rows.at(i).at(pkIndex)
+                                      : objects.at(i)->lastInsertId(qr.data());
+        qr->finish();
+        if (!newPk.isValid() || newPk.isNull()) {
+            EOrm::throwError(24, "Insert: New primary key NULL or invalid");
+            return false;
+        }
+        objects.at(i)->setSaved(newPk);
+    }
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, remove list of objects.
+ *
+ *  All objects are removed in one transaction. Objects of the same table are
+ *  removed by one statement with the list of primary keys, its size is
+ *  limited by EOrm::maxBindValues(). Removed objects are cleared and expired
+ *  in current identity map after commit. If any object does not exist in
+ *  database, nothing is removed and objects are restored to their previous
+ *  states.
+ * \param objects - the list of objects
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, удаляет список объектов.
+ *
+ *  Все объекты удаляются в одной транзакции. Объекты одной таблицы удаляются
+ *  одним запросом со списком первичных ключей, его размер ограничивается
+ *  EOrm::maxBindValues(). Удаленные объекты очищаются и после фиксации
+ *  становятся устаревшими в текущей карте идентичности. Если какой-либо
+ *  объект не существует в базе, ничего не удаляется, а объекты
+ *  восстанавливаются в прежние состояния.
+ * \param objects - список объектов
+ * \return bool
+ * \endlang
+ */
+bool EOrmActiveRecord::removeAll(QList<EOrmActiveRecord*> objects)
+{
+    if (objects.isEmpty()) {
+        return true;
+    }
+    QSqlDatabase db = objects.first()->db();
+    int maxRows = EOrm::maxBindValues(db);
+    Snapshot snapshot(objects);
+    EOrmTransaction transaction(db);
+    int i = 0;
+    while (i < objects.count()) {
+        QString tableName = objects.at(i)->tableName();
+        QList<EOrmActiveRecord*> chunk;
+        while (i < objects.count() && chunk.count() < maxRows
+               && objects.at(i)->tableName() == tableName) {
+            if (!objects.at(i)->m_pk.isValid()) {
+                EOrm::throwError(33, "Remove all: Object does not exist");
+            }
+            chunk << objects.at(i);
+            i++;
+        }
+        QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                    db, EOrmStatementCache::Delete, tableName,
+                    chunk.first()->primaryKeyName(), QStringList(),
+                    chunk.count());
+        if (qr.isNull()) {
+            EOrm::throwError(34, "Remove all: Prepare query failed");
+        }
+        for (int j = 0; j < chunk.count(); j++) {
+            qr->bindValue(j, chunk.at(j)->m_pk);
+        }
+        if (!qr->exec()) {
+            qr->finish();
+            EOrm::throwError(35, "Remove all: Execute query failed");
+        }
+        int rowsAffected = qr->numRowsAffected();
+        qr->finish();
+        if (rowsAffected != chunk.count()) {
+            EOrm::throwError(36, "Remove all: Objects deleting failed");
+        }
+        EOrmQueryCache::invalidate(db, tableName);
+        foreach (EOrmActiveRecord *obj, chunk) {
+            EOrmRecordCache::invalidate(db, tableName, obj->m_pk);
+            obj->clear();
+        }
+    }
+    if (!transaction.commit()) {
+        return false;
+    }
+    snapshot.release();
+    EOrmIdentityMap *map = EOrmIdentityMap::current();
+    if (map != 0) {
+        foreach (EOrmActiveRecord *obj, objects) {
+            map->expire(obj);
+        }
+    }
+    return true;
 }
@@ -44,6 +44,10 @@
 
 #include "eorm_global.h"
 #include "eorm.h"
+#include "eormmetadata.h"
+#include "eormstatementcache.h"
+#include "eormrecordcache.h"
+#include "eormquerycache.h"
 
 /*!
  * \class EOrmActiveRecord
@@ -57,7 +61,13 @@
  *  possible to redefine also function primaryKeyName(), which should return
  *  the name of primary key. Also it are necessary call init() function i.e. in
  *  child constructor. Also if you don`t set QSqlDatabase object in constructor,
- *  EOrmActiveRecord use EOrm::activeConnection() for this. Example of usage:
+ *  EOrmActiveRecord use EOrm::activeConnection() for this. Values of columns
+ *  are stored in the object by column ordinal and are accessed by value() and
+ *  setValue(), property() and setProperty() are kept for compatibility. A
+ *  column set by QObject::setProperty() through pointer to QObject is moved
+ *  into the object as well, but QObject::property() does not see values of
+ *  columns, so generic code should use value() or properties().
+ *  Example of usage:
  * \code
  *  // creation of new object
  *  Region *obj = new Region();
@@ -99,7 +109,13 @@
  *  либо самостоятельно, либо для удобства в конструкторах дочерних классов
  *  вызывать функцию init(). Если создаваемому объекту не указать какой объект
  *  QSqlDatabase использовать, он будет получен используя функцию
- *  EOrm::activeConnection(). Пример использования:
+ *  EOrm::activeConnection(). Значения столбцов хранятся в объекте по
+ *  порядковому номеру столбца и доступны через value() и setValue(),
+ *  property() и setProperty() сохранены для совместимости. Столбец,
+ *  установленный QObject::setProperty() через указатель на QObject, также
+ *  переносится в объект, но QObject::property() не видит значений столбцов,
+ *  поэтому обобщенный код должен использовать value() или properties().
+ *  Пример использования:
  * \code
  *  // создание нового объекта
  *  Region *obj = new Region();
@@ -132,8 +148,16 @@
 class EORMSHARED_EXPORT EOrmActiveRecord : public QObject
 {
     Q_OBJECT
+    friend class EOrmFind;
+    friend class EOrmCursorBase;
+    friend class EOrmIdentityMap;
+    friend class EOrmAsync;
+    friend class EOrmModel;
+    friend class EOrmSession;
 
 public:
+    enum RefreshMode { NoRefresh, FullRefresh, DefaultsRefresh,
+                       InvalidateDefaults };
     explicit EOrmActiveRecord(QObject *parent = 0);
     /*!
      * \lang_en
@@ -151,15 +175,33 @@ public:
     virtual QString tableName() =0;
     virtual QString primaryKeyName();
     bool save(bool updateProperties = true);
+    bool save(RefreshMode mode);
     bool remove(bool updateProperties = true);
     bool load(QVariant primaryKey);
     bool clear();
     bool isRequired(QString propertyName);
+    bool isDirty() const;
+    bool isDirty(const QString &name) const;
+    bool isLoaded(const QString &name) const;
     QHash<QString, QVariant> properties();
+    QVariant value(int index) const;
+    QVariant value(const QString &name) const;
+    bool setValue(int index, const QVariant &value);
+    bool setValue(const QString &name, const QVariant &value);
+    QVariant property(const char *name) const;
+    bool setProperty(const char *name, const QVariant &value);
     QSqlDatabase db();
     QVariant pk();
+    bool isNew() const;
+    static bool insertAll(QList<EOrmActiveRecord*> objects);
+    template <typename T>
+    static bool insertAll(QList<T*> objects);
+    static bool removeAll(QList<EOrmActiveRecord*> objects);
+    template <typename T>
+    static bool removeAll(QList<T*> objects);
 
 protected:
+    bool event(QEvent *e);
     bool init();
     bool init(QVariant pk);
     bool init(QSqlDatabase db);
@@ -167,17 +209,151 @@ protected:
 
 
 private:
+    struct State {
+        QVariant pk;
+        QVector<QVariant> values;
+        QBitArray dirty;
+        QBitArray stale;
+        QSharedPointer<const EOrmTableInfo> table;
+    };
+    typedef QList<QPointer<EOrmActiveRecord> > Siblings;
+    class Snapshot
+    {
+    public:
+        explicit Snapshot(const QList<EOrmActiveRecord*> &objects);
+        ~Snapshot();
+        void release();
+    private:
+        Q_DISABLE_COPY(Snapshot)
+        QList<EOrmActiveRecord*> m_objects;
+        QList<State> m_states;
+        bool m_released;
+    };
+
     bool preload();
-    bool updateObject(QStringList properties, QVariantList values, bool updateProperties);
-    bool insertObject(QStringList properties, QVariantList values, bool updateProperties);
+    bool hydrate(const QSqlQuery &query, const QVector<int> &columns,
+                 bool markAbsent = false);
+    bool hydrate(const EOrmRowSet &rows, int row, const QVector<int> &columns,
+                 bool markAbsent = false);
+    void changes(bool exists, QStringList *columns, QVariantList *values);
+    void setSaved(const QVariant &primaryKey);
+    State state() const;
+    void restore(const State &state);
+    static bool updateChanged(QList<EOrmActiveRecord*> objects);
+    static bool insertChunk(QSqlDatabase db, const QStringList &columns,
+                            QList<EOrmActiveRecord*> objects,
+                            QList<QVariantList> rows, bool multiRow);
+    bool updateObject(QStringList properties, QVariantList values, RefreshMode mode);
+    bool insertObject(QStringList properties, QVariantList values, RefreshMode mode);
+    QStringList unwritten(const QStringList &written) const;
+    bool refresh(const QSqlQuery &query, const QStringList &returning);
+    void invalidate(const QStringList &columns);
+    bool fetchStale();
+    static bool fetchStaleAll(const QList<EOrmActiveRecord*> &objects);
+    static void share(QList<EOrmActiveRecord*> objects);
+    template <typename T>
+    static void share(QList<T*> objects);
     QVariant lastInsertId(QSqlQuery *insertQuery);
-    QString placeholders(QVariantList list);
+    QStringList columns() const;
 
-    QStringList m_properties;
-    QStringList m_requiredProperties;
+    QSharedPointer<const EOrmTableInfo> m_table;
+    QVector<QVariant> m_values;
+    QBitArray m_dirty;
+    QBitArray m_stale;
     QSqlDatabase m_db;
     QVariant m_pk;
+    QSharedPointer<Siblings> m_siblings;
 
 };
 
+/*!
+ * \lang_en
+ * \brief Template function, insert list of new objects.
+ *
+ *  Same as insertAll() for the list of EOrmActiveRecord, for example:
+ * \code
+ *  QList<Region*> regions;
+ *  ...
+ *  bool objOk = EOrmActiveRecord::insertAll(regions);
+ * \endcode
+ * \param objects - the list of new objects
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, добавляет список новых объектов.
+ *
+ *  Аналогична insertAll() для списка EOrmActiveRecord, например:
+ * \code
+ *  QList<Region*> regions;
+ *  ...
+ *  bool objOk = EOrmActiveRecord::insertAll(regions);
+ * \endcode
+ * \param objects - список новых объектов
+ * \return bool
+ * \endlang
+ */
+template <typename T>
+bool EOrmActiveRecord::insertAll(QList<T*> objects)
+{
+    QList<EOrmActiveRecord*> records;
+    foreach (T *obj, objects) {
+        records << obj;
+    }
+    return EOrmActiveRecord::insertAll(records);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, remove list of objects.
+ *
+ *  Same as removeAll() for the list of EOrmActiveRecord.
+ * \param objects - the list of objects
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, удаляет список объектов.
+ *
+ *  Аналогична removeAll() для списка EOrmActiveRecord.
+ * \param objects - список объектов
+ * \return bool
+ * \endlang
+ */
+template <typename T>
+bool EOrmActiveRecord::removeAll(QList<T*> objects)
+{
+    QList<EOrmActiveRecord*> records;
+    foreach (T *obj, objects) {
+        records << obj;
+    }
+    return EOrmActiveRecord::removeAll(records);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, join partially loaded objects of one selection.
+ *
+ *  Same as share() for the list of EOrmActiveRecord.
+ * \param objects - the list of objects
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, объединяет частично загруженные объекты одной
+ *  выборки.
+ *
+ *  Аналогична share() для списка EOrmActiveRecord.
+ * \param objects - список объектов
+ * \endlang
+ */
+template <typename T>
+void EOrmActiveRecord::share(QList<T*> objects)
+{
+    QList<EOrmActiveRecord*> records;
+    foreach (T *obj, objects) {
+        records << obj;
+    }
+    EOrmActiveRecord::share(records);
+}
+
 #endif // EORMACTIVERECORD_H
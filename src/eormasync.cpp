@@ -0,0 +1,418 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormasync.h"
+
+/*!
+ * \lang_en
+ * \brief The class, thread pool of tasks of EOrmAsync.
+ *
+ *  Threads never expire, because every thread keeps own connection of
+ *  EOrmConnectionPool and it would be opened again by the next task.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс, пул потоков задач EOrmAsync.
+ *
+ *  Потоки никогда не завершаются по простою, так как каждый поток хранит
+ *  собственное соединение EOrmConnectionPool, и оно открывалось бы заново
+ *  следующей задачей.
+ * \endlang
+ */
+class EOrmAsyncThreadPool : public QThreadPool
+{
+
+public:
+    EOrmAsyncThreadPool()
+    {
+        this->setExpiryTimeout(-1);
+    }
+
+};
+
+Q_GLOBAL_STATIC(EOrmAsyncThreadPool, eormAsyncThreadPool)
+
+/*!
+ * \lang_en
+ * \brief Static function, returned the thread pool of tasks.
+ *
+ *  The pool is separate from QThreadPool::globalInstance(), so tasks of the
+ *  application do not wait for queries. Count of threads is limited by
+ *  EOrmConnectionPool::maxSize(), so tasks do not wait for connections of
+ *  each other. Threads do not expire and keep their connections.
+ * \return *QThreadPool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает пул потоков задач.
+ *
+ *  Пул отделен от QThreadPool::globalInstance(), поэтому задачи приложения
+ *  не ожидают запросов. Количество потоков ограничено
+ *  EOrmConnectionPool::maxSize(), поэтому задачи не ожидают соединений друг
+ *  друга. Потоки не завершаются по простою и сохраняют свои соединения.
+ * \return *QThreadPool
+ * \endlang
+ */
+QThreadPool *EOrmAsync::threadPool()
+{
+    QThreadPool *pool = eormAsyncThreadPool();
+    int size = EOrmConnectionPool::maxSize();
+    if (pool->maxThreadCount() > size) {
+        pool->setMaxThreadCount(size);
+    }
+    return pool;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, save object asynchronously.
+ *
+ *  Object is saved by EOrmActiveRecord::save() with connection of the worker
+ *  thread, it is not used in other transactions of the calling thread.
+ *  Object is changed by the worker thread, so it should not be used or
+ *  deleted until the future is finished (see EOrmAsyncWrite).
+ * \param obj - object
+ * \param mode - mode of refresh
+ * \return QFuture<bool>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, асинхронно сохраняет объект.
+ *
+ *  Объект сохраняется функцией EOrmActiveRecord::save() через соединение
+ *  рабочего потока, оно не участвует в других транзакциях вызывающего
+ *  потока. Объект изменяется рабочим потоком, поэтому его нельзя
+ *  использовать или удалять до завершения QFuture (см. EOrmAsyncWrite).
+ * \param obj - объект
+ * \param mode - режим обновления
+ * \return QFuture<bool>
+ * \endlang
+ */
+QFuture<bool> EOrmAsync::save(EOrmActiveRecord *obj,
+                              EOrmActiveRecord::RefreshMode mode)
+{
+    return QtConcurrent::run(EOrmAsync::threadPool(),
+                             EOrmAsyncWrite(obj, false, mode));
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, remove object asynchronously.
+ *
+ *  It is similar save(), object is removed by EOrmActiveRecord::remove().
+ * \param obj - object
+ * \return QFuture<bool>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, асинхронно удаляет объект.
+ *
+ *  Аналогична save(), объект удаляется функцией EOrmActiveRecord::remove().
+ * \param obj - объект
+ * \return QFuture<bool>
+ * \endlang
+ */
+QFuture<bool> EOrmAsync::remove(EOrmActiveRecord *obj)
+{
+    return QtConcurrent::run(EOrmAsync::threadPool(),
+                             EOrmAsyncWrite(obj, true,
+                                            EOrmActiveRecord::FullRefresh));
+}
+
+/*!
+ * \lang_en
+ * \brief Function move object to the calling thread and bind it to its
+ *  connection.
+ * \param obj - object
+ * \param thread - the calling thread
+ * \param db - connection of the calling thread
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция переносит объект в вызывающий поток и привязывает его к
+ *  соединению этого потока.
+ * \param obj - объект
+ * \param thread - вызывающий поток
+ * \param db - соединение вызывающего потока
+ * \endlang
+ */
+void EOrmAsync::rebind(EOrmActiveRecord *obj, QThread *thread,
+                       QSqlDatabase db)
+{
+    if (obj == 0) {
+        return;
+    }
+    obj->m_db = db;
+    obj->moveToThread(thread);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned copy of conditions of selection with the given
+ *  connection.
+ * \param find - conditions of selection
+ * \param db - a database object
+ * \return *EOrmFind
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает копию условий выборки с заданным соединением.
+ * \param find - условия выборки
+ * \param db - объект базы данных
+ * \return *EOrmFind
+ * \endlang
+ */
+EOrmFind *EOrmAsync::clone(EOrmFind *find, QSqlDatabase db)
+{
+    return find->clone(db);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned connection of conditions of selection.
+ * \param find - conditions of selection
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает соединение условий выборки.
+ * \param find - условия выборки
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmAsync::db(EOrmFind *find)
+{
+    return find->m_db;
+}
+
+/*!
+ * \lang_en
+ * \brief Function set connection of object without moving it.
+ * \param obj - object
+ * \param db - a database object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция устанавливает соединение объекта без его переноса.
+ * \param obj - объект
+ * \param db - объект базы данных
+ * \endlang
+ */
+void EOrmAsync::setDb(EOrmActiveRecord *obj, QSqlDatabase db)
+{
+    obj->m_db = db;
+}
+
+/*!
+ * \lang_en
+ * \brief Function release error of task and throw it as
+ *  EOrmAsyncException, which is stored in the future.
+ * \param e - exception
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция освобождает ошибку задачи и выбрасывает ее как
+ *  EOrmAsyncException, которое сохраняется в QFuture.
+ * \param e - исключение
+ * \endlang
+ */
+void EOrmAsync::raise(EOrmException *e)
+{
+    EOrmAsyncException error(e->code(), e->message());
+    delete e;
+    throw error;
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor.
+ * \param code - error code
+ * \param message - error message
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор.
+ * \param code - код ошибки
+ * \param message - сообщение об ошибке
+ * \endlang
+ */
+EOrmAsyncException::EOrmAsyncException(int code, const QString &message) :
+    m_code(code), m_message(message)
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Destructor.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Деструктор.
+ * \endlang
+ */
+EOrmAsyncException::~EOrmAsyncException() throw()
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Function return error code.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает код ошибки.
+ * \return int
+ * \endlang
+ */
+int EOrmAsyncException::code() const
+{
+    return this->m_code;
+}
+
+/*!
+ * \lang_en
+ * \brief Function return error message.
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает сообщение об ошибке.
+ * \return QString
+ * \endlang
+ */
+QString EOrmAsyncException::message() const
+{
+    return this->m_message;
+}
+
+/*!
+ * \lang_en
+ * \brief Function throw copy of the exception, it is used by QFuture.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция выбрасывает копию исключения, используется QFuture.
+ * \endlang
+ */
+void EOrmAsyncException::raise() const
+{
+    throw *this;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned copy of the exception, it is used by QFuture.
+ * \return *EOrmAsyncException
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает копию исключения, используется QFuture.
+ * \return *EOrmAsyncException
+ * \endlang
+ */
+EOrmAsyncException *EOrmAsyncException::clone() const
+{
+    return new EOrmAsyncException(*this);
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor.
+ * \param obj - object
+ * \param remove - remove object instead of saving
+ * \param mode - mode of refresh
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор.
+ * \param obj - объект
+ * \param remove - удалить объект вместо сохранения
+ * \param mode - режим обновления
+ * \endlang
+ */
+EOrmAsyncWrite::EOrmAsyncWrite(EOrmActiveRecord *obj, bool remove,
+                               EOrmActiveRecord::RefreshMode mode) :
+    m_object(obj), m_remove(remove), m_mode(mode)
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Function saves or removes object in the worker thread.
+ *
+ *  Object is bound to connection of the worker thread while it is written,
+ *  then its connection is restored. On error EOrmAsyncException is thrown,
+ *  it is stored in the future.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция сохраняет или удаляет объект в рабочем потоке.
+ *
+ *  На время записи объект привязывается к соединению рабочего потока, затем
+ *  его соединение восстанавливается. При ошибке выбрасывается
+ *  EOrmAsyncException, оно сохраняется в QFuture.
+ * \return bool
+ * \endlang
+ */
+bool EOrmAsyncWrite::operator()() const
+{
+    bool result = false;
+    QSqlDatabase db = this->m_object->db();
+    try {
+        EOrmConnectionLease lease;
+        if (lease.isValid()) {
+            EOrmAsync::setDb(this->m_object, lease.db());
+            try {
+                result = this->m_remove ? this->m_object->remove()
+                                        : this->m_object->save(this->m_mode);
+            } catch (EOrmException *e) {
+                EOrmAsync::setDb(this->m_object, db);
+                throw e;
+            }
+            EOrmAsync::setDb(this->m_object, db);
+        }
+    } catch (EOrmException *e) {
+        EOrmAsync::raise(e);
+    }
+    return result;
+}
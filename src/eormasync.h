@@ -0,0 +1,569 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMASYNC_H
+#define EORMASYNC_H
+
+#include "eorm_global.h"
+#include <QtConcurrent>
+#include <QException>
+#include <QFuture>
+#include <QThreadPool>
+#include "eormfind.h"
+#include "eormconnectionpool.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 4, 0)
+#error "EOrmAsync requires Qt 5.4 or later"
+#endif
+
+/*!
+ * \class EOrmAsync
+ *
+ * \lang_en
+ * \brief The static class, asynchronous execution of queries and saving of
+ *  objects.
+ *
+ *  Functions return QFuture at once, work is done in the dedicated thread
+ *  pool (see threadPool()). Every task takes connection of the current
+ *  thread from EOrmConnectionPool, so the pool source should be set. Objects
+ *  are filled in the worker thread, then they are moved to the thread which
+ *  started the task and bound to the connection of EOrmFind. Results are
+ *  received by QFutureWatcher signals, so event loop is not blocked.
+ *  Identity map of the calling thread is not used. Error of task is stored
+ *  in the future as EOrmAsyncException, which is thrown by
+ *  QFuture::result() or QFuture::waitForFinished() in the calling thread.
+ *  It requires Qt 5.4 or later. Example:
+ * \code
+ *  QFutureWatcher<QList<Test*> > *watcher = new QFutureWatcher<QList<Test*> >();
+ *  connect(watcher, SIGNAL(finished()), this, SLOT(showObjects()));
+ *  watcher->setFuture(EOrmAsync::all<Test>(EOrmFind::find()->where("id > 0")));
+ *  ...
+ *  try {
+ *      QList<Test*> lst = watcher->result();
+ *  } catch (EOrmAsyncException &e) {
+ *      qWarning() << e.code() << e.message();
+ *  }
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статический класс, асинхронное выполнение запросов и сохранение
+ *  объектов.
+ *
+ *  Функции сразу возвращают QFuture, работа выполняется в отдельном пуле
+ *  потоков (см. threadPool()). Каждая задача берет соединение текущего
+ *  потока из EOrmConnectionPool, поэтому исходное соединение пула должно
+ *  быть задано. Объекты заполняются в рабочем потоке, затем переносятся в
+ *  поток, запустивший задачу, и привязываются к соединению EOrmFind.
+ *  Результаты получаются по сигналам QFutureWatcher, поэтому цикл событий не
+ *  блокируется. Карта идентичности вызывающего потока не используется.
+ *  Ошибка задачи сохраняется в QFuture как EOrmAsyncException, которое
+ *  выбрасывается функциями QFuture::result() или QFuture::waitForFinished()
+ *  в вызывающем потоке. Требуется Qt 5.4 или новее. Пример:
+ * \code
+ *  QFutureWatcher<QList<Test*> > *watcher = new QFutureWatcher<QList<Test*> >();
+ *  connect(watcher, SIGNAL(finished()), this, SLOT(showObjects()));
+ *  watcher->setFuture(EOrmAsync::all<Test>(EOrmFind::find()->where("id > 0")));
+ *  ...
+ *  try {
+ *      QList<Test*> lst = watcher->result();
+ *  } catch (EOrmAsyncException &e) {
+ *      qWarning() << e.code() << e.message();
+ *  }
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmAsync
+{
+
+public:
+    static QThreadPool *threadPool();
+    template <typename T>
+    static QFuture<QList<T*> > all(EOrmFind *find);
+    template <typename T>
+    static QFuture<T*> one(EOrmFind *find);
+    template <typename T>
+    static QFuture<EOrmRowSet> rows(EOrmFind *find);
+    template <typename T>
+    static QFuture<int> count(EOrmFind *find);
+    static QFuture<bool> save(EOrmActiveRecord *obj,
+                              EOrmActiveRecord::RefreshMode mode =
+                              EOrmActiveRecord::FullRefresh);
+    static QFuture<bool> remove(EOrmActiveRecord *obj);
+
+private:
+    template <typename T>
+    static QList<T*> runAll(EOrmFind *find);
+    template <typename T>
+    static T *runOne(EOrmFind *find);
+    template <typename T>
+    static EOrmRowSet runRows(EOrmFind *find);
+    template <typename T>
+    static int runCount(EOrmFind *find);
+    template <typename T>
+    static void transfer(QList<T*> *objects, QThread *thread,
+                         QSqlDatabase db);
+    template <typename T>
+    static void transfer(T **obj, QThread *thread, QSqlDatabase db);
+    template <typename V>
+    static void transfer(V *value, QThread *thread, QSqlDatabase db);
+    static void rebind(EOrmActiveRecord *obj, QThread *thread,
+                       QSqlDatabase db);
+    static EOrmFind *clone(EOrmFind *find, QSqlDatabase db);
+    static QSqlDatabase db(EOrmFind *find);
+    static void setDb(EOrmActiveRecord *obj, QSqlDatabase db);
+    static void raise(EOrmException *e);
+
+    template <typename R>
+    friend class EOrmAsyncQuery;
+    friend class EOrmAsyncWrite;
+
+};
+
+/*!
+ * \class EOrmAsyncException
+ *
+ * \lang_en
+ * \brief The class, error of task of EOrmAsync.
+ *
+ *  EOrmException of the worker thread is converted to it, so QFuture can
+ *  store the error and throw it in the calling thread. It is thrown by value
+ *  and should be caught by reference.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс, ошибка задачи EOrmAsync.
+ *
+ *  В него преобразуется EOrmException рабочего потока, чтобы QFuture мог
+ *  сохранить ошибку и выбросить ее в вызывающем потоке. Выбрасывается по
+ *  значению и должно перехватываться по ссылке.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmAsyncException : public QException
+{
+
+public:
+    EOrmAsyncException(int code, const QString &message);
+    ~EOrmAsyncException() throw();
+    int code() const;
+    QString message() const;
+    void raise() const;
+    EOrmAsyncException *clone() const;
+
+private:
+    int m_code;
+    QString m_message;
+
+};
+
+/*!
+ * \class EOrmAsyncQuery
+ *
+ * \lang_en
+ * \brief The template class, task of EOrmAsync which executes query.
+ *
+ *  It keeps copy of conditions of EOrmFind made in the calling thread, so
+ *  EOrmFind can be changed or deleted after start of task.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонный класс, задача EOrmAsync, выполняющая запрос.
+ *
+ *  Хранит копию условий EOrmFind, сделанную в вызывающем потоке, поэтому
+ *  EOrmFind можно изменять или удалять после запуска задачи.
+ * \endlang
+ */
+template <typename R>
+class EOrmAsyncQuery
+{
+
+public:
+    typedef R result_type;
+    EOrmAsyncQuery(EOrmFind *find, R (*terminal)(EOrmFind*));
+    R operator()() const;
+
+private:
+    QSharedPointer<EOrmFind> m_find;
+    R (*m_terminal)(EOrmFind*);
+    QPointer<QThread> m_thread;
+    QSqlDatabase m_db;
+
+};
+
+/*!
+ * \class EOrmAsyncWrite
+ *
+ * \lang_en
+ * \brief The class, task of EOrmAsync which saves or removes object.
+ *
+ *  Object is not copied: the worker thread changes its values, primary key
+ *  and connection, while the object stays in the calling thread. So the
+ *  calling thread should not read, change or delete the object until the
+ *  future is finished, QFutureWatcher::finished() is the point where it can
+ *  be used again.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс, задача EOrmAsync, сохраняющая или удаляющая объект.
+ *
+ *  Объект не копируется: рабочий поток изменяет его значения, первичный ключ
+ *  и соединение, при этом объект остается в вызывающем потоке. Поэтому
+ *  вызывающий поток не должен читать, изменять или удалять объект до
+ *  завершения QFuture, после QFutureWatcher::finished() его снова можно
+ *  использовать.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmAsyncWrite
+{
+
+public:
+    typedef bool result_type;
+    EOrmAsyncWrite(EOrmActiveRecord *obj, bool remove,
+                   EOrmActiveRecord::RefreshMode mode);
+    bool operator()() const;
+
+private:
+    EOrmActiveRecord *m_object;
+    bool m_remove;
+    EOrmActiveRecord::RefreshMode m_mode;
+
+};
+
+/*!
+ * \lang_en
+ * \brief Template function, select objects list asynchronously.
+ *
+ *  It is similar EOrmFind::all(), objects are moved to the calling thread.
+ * \param find - conditions of selection
+ * \return QFuture<QList<T*> >
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, асинхронно выбирает множество объектов.
+ *
+ *  Аналогична EOrmFind::all(), объекты переносятся в вызывающий поток.
+ * \param find - условия выборки
+ * \return QFuture<QList<T*> >
+ * \endlang
+ */
+template <typename T>
+QFuture<QList<T*> > EOrmAsync::all(EOrmFind *find)
+{
+    return QtConcurrent::run(EOrmAsync::threadPool(),
+                             EOrmAsyncQuery<QList<T*> >(
+                                 find, &EOrmAsync::runAll<T>));
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, select one object asynchronously.
+ *
+ *  It is similar EOrmFind::one(), object is moved to the calling thread.
+ * \param find - conditions of selection
+ * \return QFuture<T*>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, асинхронно выбирает один объект.
+ *
+ *  Аналогична EOrmFind::one(), объект переносится в вызывающий поток.
+ * \param find - условия выборки
+ * \return QFuture<T*>
+ * \endlang
+ */
+template <typename T>
+QFuture<T*> EOrmAsync::one(EOrmFind *find)
+{
+    return QtConcurrent::run(EOrmAsync::threadPool(),
+                             EOrmAsyncQuery<T*>(find, &EOrmAsync::runOne<T>));
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, select rows of values asynchronously.
+ *
+ *  It is similar EOrmFind::rows().
+ * \param find - conditions of selection
+ * \return QFuture<EOrmRowSet>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, асинхронно выбирает строки значений.
+ *
+ *  Аналогична EOrmFind::rows().
+ * \param find - условия выборки
+ * \return QFuture<EOrmRowSet>
+ * \endlang
+ */
+template <typename T>
+QFuture<EOrmRowSet> EOrmAsync::rows(EOrmFind *find)
+{
+    return QtConcurrent::run(EOrmAsync::threadPool(),
+                             EOrmAsyncQuery<EOrmRowSet>(
+                                 find, &EOrmAsync::runRows<T>));
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, count objects asynchronously.
+ *
+ *  It is similar EOrmFind::count().
+ * \param find - conditions of selection
+ * \return QFuture<int>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, асинхронно подсчитывает объекты.
+ *
+ *  Аналогична EOrmFind::count().
+ * \param find - условия выборки
+ * \return QFuture<int>
+ * \endlang
+ */
+template <typename T>
+QFuture<int> EOrmAsync::count(EOrmFind *find)
+{
+    return QtConcurrent::run(EOrmAsync::threadPool(),
+                             EOrmAsyncQuery<int>(find,
+                                                 &EOrmAsync::runCount<T>));
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, terminal of task of all().
+ * \param find - conditions of selection
+ * \return QList<T*>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, завершение задачи all().
+ * \param find - условия выборки
+ * \return QList<T*>
+ * \endlang
+ */
+template <typename T>
+QList<T*> EOrmAsync::runAll(EOrmFind *find)
+{
+    return find->all<T>();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, terminal of task of one().
+ * \param find - conditions of selection
+ * \return *T
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, завершение задачи one().
+ * \param find - условия выборки
+ * \return *T
+ * \endlang
+ */
+template <typename T>
+T *EOrmAsync::runOne(EOrmFind *find)
+{
+    return find->one<T>();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, terminal of task of rows().
+ * \param find - conditions of selection
+ * \return EOrmRowSet
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, завершение задачи rows().
+ * \param find - условия выборки
+ * \return EOrmRowSet
+ * \endlang
+ */
+template <typename T>
+EOrmRowSet EOrmAsync::runRows(EOrmFind *find)
+{
+    return find->rows<T>();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, terminal of task of count().
+ * \param find - conditions of selection
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, завершение задачи count().
+ * \param find - условия выборки
+ * \return int
+ * \endlang
+ */
+template <typename T>
+int EOrmAsync::runCount(EOrmFind *find)
+{
+    return find->count<T>();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, move objects of result to the calling thread.
+ * \param objects - list of objects
+ * \param thread - the calling thread
+ * \param db - connection of the calling thread
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, переносит объекты результата в вызывающий
+ *  поток.
+ * \param objects - список объектов
+ * \param thread - вызывающий поток
+ * \param db - соединение вызывающего потока
+ * \endlang
+ */
+template <typename T>
+void EOrmAsync::transfer(QList<T*> *objects, QThread *thread, QSqlDatabase db)
+{
+    foreach (T *obj, *objects) {
+        EOrmAsync::rebind(obj, thread, db);
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, move object of result to the calling thread.
+ * \param obj - object
+ * \param thread - the calling thread
+ * \param db - connection of the calling thread
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, переносит объект результата в вызывающий поток.
+ * \param obj - объект
+ * \param thread - вызывающий поток
+ * \param db - соединение вызывающего потока
+ * \endlang
+ */
+template <typename T>
+void EOrmAsync::transfer(T **obj, QThread *thread, QSqlDatabase db)
+{
+    EOrmAsync::rebind(*obj, thread, db);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function for results without objects, does nothing.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция для результатов без объектов, ничего не делает.
+ * \endlang
+ */
+template <typename V>
+void EOrmAsync::transfer(V *value, QThread *thread, QSqlDatabase db)
+{
+    Q_UNUSED(value)
+    Q_UNUSED(thread)
+    Q_UNUSED(db)
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, copy conditions of selection.
+ * \param find - conditions of selection
+ * \param terminal - function which executes selection
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, копирует условия выборки.
+ * \param find - условия выборки
+ * \param terminal - функция, выполняющая выборку
+ * \endlang
+ */
+template <typename R>
+EOrmAsyncQuery<R>::EOrmAsyncQuery(EOrmFind *find, R (*terminal)(EOrmFind*)) :
+    m_terminal(terminal)
+{
+    this->m_find = QSharedPointer<EOrmFind>(
+                EOrmAsync::clone(find, QSqlDatabase()));
+    this->m_thread = QThread::currentThread();
+    this->m_db = EOrmAsync::db(find);
+}
+
+/*!
+ * \lang_en
+ * \brief Function executes selection in the worker thread.
+ *
+ *  On error EOrmAsyncException is thrown, it is stored in the future.
+ * \return R
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция выполняет выборку в рабочем потоке.
+ *
+ *  При ошибке выбрасывается EOrmAsyncException, оно сохраняется в QFuture.
+ * \return R
+ * \endlang
+ */
+template <typename R>
+R EOrmAsyncQuery<R>::operator()() const
+{
+    R result = R();
+    try {
+        EOrmConnectionLease lease;
+        if (lease.isValid()) {
+            EOrmFind *find = EOrmAsync::clone(this->m_find.data(),
+                                              lease.db());
+            try {
+                result = this->m_terminal(find);
+            } catch (EOrmException *e) {
+                delete find;
+                throw e;
+            }
+            delete find;
+        }
+    } catch (EOrmException *e) {
+        EOrmAsync::raise(e);
+    }
+    EOrmAsync::transfer(&result, this->m_thread.data(), this->m_db);
+    return result;
+}
+
+#endif // EORMASYNC_H
@@ -0,0 +1,740 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormconnectionpool.h"
+#include "eorm.h"
+#include "eormstatementcache.h"
+#include <climits>
+
+/*!
+ * \lang_en
+ * \brief Initialization of the pool. By default up to 8 connections are
+ *  opened, idle connection is closed after 60 seconds.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация пула. По-умолчанию открывается до 8 соединений,
+ *  простаивающее соединение закрывается через 60 секунд.
+ * \endlang
+ */
+QSqlDatabase EOrmConnectionPool::m_source;
+QList<EOrmConnectionPool::Connection> EOrmConnectionPool::m_connections;
+QHash<QString, QString> EOrmConnectionPool::m_origins;
+QThreadStorage<EOrmConnectionPool::ThreadData*> EOrmConnectionPool::m_threads;
+int EOrmConnectionPool::m_maxSize = 8;
+int EOrmConnectionPool::m_idleTimeout = 60000;
+int EOrmConnectionPool::m_serial = 0;
+qint64 EOrmConnectionPool::m_acquisitions = 0;
+qint64 EOrmConnectionPool::m_timeouts = 0;
+qint64 EOrmConnectionPool::m_waitTime = 0;
+qint64 EOrmConnectionPool::m_maxWaitTime = 0;
+QMutex EOrmConnectionPool::m_mutex;
+QWaitCondition EOrmConnectionPool::m_released;
+
+/*!
+ * \lang_en
+ * \brief Static function, returned the source connection of the pool.
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает исходное соединение пула.
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmConnectionPool::source()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_source;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set the source connection of the pool.
+ *
+ *  Connections of the pool are cloned from it with the same driver and
+ *  parameters. It should be called in the thread of the source connection
+ *  before the first acquire().
+ * \param db - a database object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает исходное соединение пула.
+ *
+ *  Соединения пула клонируются из него с тем же драйвером и параметрами.
+ *  Должна вызываться в потоке исходного соединения до первого вызова
+ *  acquire().
+ * \param db - объект базы данных
+ * \endlang
+ */
+void EOrmConnectionPool::setSource(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    EOrmConnectionPool::m_source = db;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned the maximum count of connections.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает максимальное количество соединений.
+ * \return int
+ * \endlang
+ */
+int EOrmConnectionPool::maxSize()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_maxSize;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set the maximum count of connections.
+ * \param size - count of connections
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает максимальное количество
+ *  соединений.
+ * \param size - количество соединений
+ * \endlang
+ */
+void EOrmConnectionPool::setMaxSize(int size)
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    EOrmConnectionPool::m_maxSize = qMax(1, size);
+    EOrmConnectionPool::m_released.wakeAll();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned time after which idle connection is
+ *  closed, in milliseconds.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает время, через которое простаивающее
+ *  соединение закрывается, в миллисекундах.
+ * \return int
+ * \endlang
+ */
+int EOrmConnectionPool::idleTimeout()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_idleTimeout;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set time after which idle connection is closed.
+ *
+ *  Idle connections of thread are checked at acquiring and releasing in this
+ *  thread, connection is closed by its thread only. Value -1 turns closing
+ *  off.
+ * \param msecs - time in milliseconds
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает время, через которое
+ *  простаивающее соединение закрывается.
+ *
+ *  Простаивающие соединения потока проверяются при взятии и освобождении в
+ *  этом потоке, соединение закрывается только его потоком. Значение -1
+ *  отключает закрытие.
+ * \param msecs - время в миллисекундах
+ * \endlang
+ */
+void EOrmConnectionPool::setIdleTimeout(int msecs)
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    EOrmConnectionPool::m_idleTimeout = msecs;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, take connection for the current thread.
+ *
+ *  If the current thread already holds connection, the same connection is
+ *  returned and count of its acquisitions is increased. Otherwise idle
+ *  connection of the current thread is returned if any, or new connection is
+ *  cloned from source. Connections of other threads are never taken: if the
+ *  pool is full, function waits for release not longer than timeout. Returned
+ *  invalid object on error. Every acquisition should be matched by release()
+ *  in the same thread.
+ * \param timeout - time of waiting in milliseconds, -1 to wait forever
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, берет соединение для текущего потока.
+ *
+ *  Если текущий поток уже держит соединение, возвращается это же соединение,
+ *  и количество его взятий увеличивается. Иначе возвращается простаивающее
+ *  соединение текущего потока, если оно есть, либо новое соединение
+ *  клонируется из исходного. Соединения других потоков никогда не берутся:
+ *  если пул заполнен, функция ожидает освобождения не дольше timeout. При
+ *  ошибке возвращает недействительный объект. Каждому взятию должен
+ *  соответствовать вызов release() в том же потоке.
+ * \param timeout - время ожидания в миллисекундах, -1 для ожидания без
+ *  ограничения
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmConnectionPool::acquire(int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    if (!EOrmConnectionPool::m_source.isValid()) {
+        EOrm::throwError(47, "Connection pool: Source connection is "
+                         "not valid");
+        return QSqlDatabase();
+    }
+    while (true) {
+        EOrmConnectionPool::evict();
+        for (int i = 0; i < EOrmConnectionPool::m_connections.count(); i++) {
+            Connection &connection = EOrmConnectionPool::m_connections[i];
+            if (connection.thread == thread && connection.leases > 0) {
+                return EOrmConnectionPool::take(connection, timer.elapsed());
+            }
+        }
+        for (int i = 0; i < EOrmConnectionPool::m_connections.count(); i++) {
+            Connection &connection = EOrmConnectionPool::m_connections[i];
+            if (connection.thread == thread && !connection.retired) {
+                return EOrmConnectionPool::take(connection, timer.elapsed());
+            }
+        }
+        if (EOrmConnectionPool::m_connections.count()
+                < EOrmConnectionPool::m_maxSize) {
+            break;
+        }
+        qint64 remaining = timeout - timer.elapsed();
+        if (timeout > -1 && remaining <= 0) {
+            EOrmConnectionPool::m_timeouts++;
+            EOrm::throwError(49, "Connection pool: Acquiring connection "
+                             "timed out");
+            return QSqlDatabase();
+        }
+        EOrmConnectionPool::m_released.wait(
+                    &EOrmConnectionPool::m_mutex,
+                    timeout > -1 ? (unsigned long)remaining : ULONG_MAX);
+    }
+    Connection connection;
+    connection.name = EOrmConnectionPool::m_source.connectionName()
+            + "/pool/" + QString::number(++EOrmConnectionPool::m_serial);
+    connection.db = QSqlDatabase::cloneDatabase(EOrmConnectionPool::m_source,
+                                                connection.name);
+    connection.thread = thread;
+    connection.leases = 0;
+    connection.retired = false;
+    EOrmConnectionPool::m_connections.append(connection);
+    EOrmConnectionPool::threadData()->owned.append(connection.name);
+    EOrmConnectionPool::m_origins.insert(
+                connection.name, EOrmConnectionPool::m_source.connectionName());
+    locker.unlock();
+    bool opened = connection.db.open();
+    locker.relock();
+    if (!opened) {
+        connection.db = QSqlDatabase();
+        for (int i = 0; i < EOrmConnectionPool::m_connections.count(); i++) {
+            if (EOrmConnectionPool::m_connections.at(i).name
+                    == connection.name) {
+                EOrmConnectionPool::close(
+                            EOrmConnectionPool::m_connections.takeAt(i));
+                break;
+            }
+        }
+        EOrmConnectionPool::threadData()->owned.removeAll(connection.name);
+        EOrmConnectionPool::m_released.wakeAll();
+        EOrm::throwError(48, "Connection pool: Opening connection failed");
+        return QSqlDatabase();
+    }
+    for (int i = 0; i < EOrmConnectionPool::m_connections.count(); i++) {
+        if (EOrmConnectionPool::m_connections.at(i).name == connection.name) {
+            return EOrmConnectionPool::take(
+                        EOrmConnectionPool::m_connections[i], timer.elapsed());
+        }
+    }
+    return QSqlDatabase();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, return connection into the pool.
+ *
+ *  Connection becomes idle when the last acquisition of the thread is
+ *  released. Expired and retired idle connections of the current thread are
+ *  closed.
+ * \param db - a database object taken by acquire()
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает соединение в пул.
+ *
+ *  Соединение начинает простаивать, когда освобождено последнее взятие
+ *  потока. Устаревшие и выведенные из пула простаивающие соединения текущего
+ *  потока закрываются.
+ * \param db - объект базы данных, взятый функцией acquire()
+ * \endlang
+ */
+void EOrmConnectionPool::release(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    for (int i = 0; i < EOrmConnectionPool::m_connections.count(); i++) {
+        Connection &connection = EOrmConnectionPool::m_connections[i];
+        if (connection.name == db.connectionName()) {
+            if (connection.leases > 0 && --connection.leases == 0) {
+                connection.idle.start();
+            }
+            break;
+        }
+    }
+    EOrmConnectionPool::evict();
+    EOrmConnectionPool::m_released.wakeAll();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned connection of the last lease of the
+ *  current thread.
+ *
+ *  Returned invalid object if there is no lease (see EOrmConnectionLease).
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает соединение последней аренды
+ *  текущего потока.
+ *
+ *  Возвращает недействительный объект, если аренды нет (см.
+ *  EOrmConnectionLease).
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmConnectionPool::current()
+{
+    if (!EOrmConnectionPool::m_threads.hasLocalData()
+            || EOrmConnectionPool::m_threads.localData()->leases.isEmpty()) {
+        return QSqlDatabase();
+    }
+    return QSqlDatabase::database(
+                EOrmConnectionPool::m_threads.localData()->leases.last(),
+                false);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned name of the source connection for
+ *  connection of the pool.
+ *
+ *  For other connections the name is returned as is.
+ * \param connectionName - name of connection
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает имя исходного соединения для
+ *  соединения пула.
+ *
+ *  Для других соединений имя возвращается как есть.
+ * \param connectionName - имя соединения
+ * \return QString
+ * \endlang
+ */
+QString EOrmConnectionPool::origin(const QString &connectionName)
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_origins.value(connectionName, connectionName);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, retire all connections of the pool.
+ *
+ *  Idle connections of the current thread are closed at once. Connections of
+ *  other threads and taken connections are only marked: they are not
+ *  returned any more and are closed by own thread at its next acquire() or
+ *  release() when idle, or when the thread finishes. It should be called
+ *  before removing of the source connection.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, выводит из пула все соединения.
+ *
+ *  Простаивающие соединения текущего потока закрываются сразу. Соединения
+ *  других потоков и взятые соединения только помечаются: они больше не
+ *  выдаются и закрываются своим потоком при следующем вызове acquire() или
+ *  release() после освобождения, либо при завершении потока. Должна
+ *  вызываться до удаления исходного соединения.
+ * \endlang
+ */
+void EOrmConnectionPool::clear()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    for (int i = 0; i < EOrmConnectionPool::m_connections.count(); i++) {
+        EOrmConnectionPool::m_connections[i].retired = true;
+    }
+    EOrmConnectionPool::evict();
+    EOrmConnectionPool::m_released.wakeAll();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of opened connections.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество открытых соединений.
+ * \return int
+ * \endlang
+ */
+int EOrmConnectionPool::size()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_connections.count();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of idle connections.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество простаивающих
+ *  соединений.
+ * \return int
+ * \endlang
+ */
+int EOrmConnectionPool::idleCount()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    int count = 0;
+    foreach (Connection connection, EOrmConnectionPool::m_connections) {
+        if (connection.leases == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of successful acquisitions.
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество успешных взятий
+ *  соединения.
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmConnectionPool::acquisitions()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_acquisitions;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of acquisitions failed by timeout.
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество взятий, не выполненных
+ *  по истечении времени ожидания.
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmConnectionPool::timeouts()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_timeouts;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned total time of successful acquisitions in
+ *  milliseconds, including opening of new connections.
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает общее время успешных взятий в
+ *  миллисекундах, включая открытие новых соединений.
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmConnectionPool::waitTime()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_waitTime;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned the longest time of acquisition in
+ *  milliseconds.
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает наибольшее время взятия в
+ *  миллисекундах.
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmConnectionPool::maxWaitTime()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    return EOrmConnectionPool::m_maxWaitTime;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned per-thread data of the pool, it is created at the
+ *  first call in thread.
+ * \return *ThreadData
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает данные пула текущего потока, они создаются при
+ *  первом вызове в потоке.
+ * \return *ThreadData
+ * \endlang
+ */
+EOrmConnectionPool::ThreadData *EOrmConnectionPool::threadData()
+{
+    if (!EOrmConnectionPool::m_threads.hasLocalData()) {
+        EOrmConnectionPool::m_threads.setLocalData(new ThreadData());
+    }
+    return EOrmConnectionPool::m_threads.localData();
+}
+
+/*!
+ * \lang_en
+ * \brief Function count acquisition of connection, the lock is held by
+ *  caller.
+ * \param connection - connection of the current thread
+ * \param wait - time of acquisition in milliseconds
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция учитывает взятие соединения, блокировка удерживается
+ *  вызывающей стороной.
+ * \param connection - соединение текущего потока
+ * \param wait - время взятия в миллисекундах
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmConnectionPool::take(Connection &connection, qint64 wait)
+{
+    connection.leases++;
+    EOrmConnectionPool::m_acquisitions++;
+    EOrmConnectionPool::m_waitTime += wait;
+    EOrmConnectionPool::m_maxWaitTime = qMax(EOrmConnectionPool::m_maxWaitTime,
+                                             wait);
+    return connection.db;
+}
+
+/*!
+ * \lang_en
+ * \brief Function close idle connections of the current thread which are
+ *  retired or idle longer than idleTimeout(), the lock is held by caller.
+ *
+ *  Connections of other threads are never closed here, Qt allows to close
+ *  connection only in its own thread.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция закрывает простаивающие соединения текущего потока,
+ *  выведенные из пула или простаивающие дольше idleTimeout(), блокировка
+ *  удерживается вызывающей стороной.
+ *
+ *  Соединения других потоков здесь никогда не закрываются, Qt позволяет
+ *  закрывать соединение только в его собственном потоке.
+ * \endlang
+ */
+void EOrmConnectionPool::evict()
+{
+    QThread *thread = QThread::currentThread();
+    for (int i = EOrmConnectionPool::m_connections.count() - 1; i >= 0; i--) {
+        const Connection &connection = EOrmConnectionPool::m_connections.at(i);
+        if (connection.leases > 0 || connection.thread != thread) {
+            continue;
+        }
+        bool expired = EOrmConnectionPool::m_idleTimeout > -1
+                && connection.idle.hasExpired(
+                    EOrmConnectionPool::m_idleTimeout);
+        if (connection.retired || expired) {
+            EOrmConnectionPool::threadData()->owned.removeAll(connection.name);
+            EOrmConnectionPool::close(
+                        EOrmConnectionPool::m_connections.takeAt(i));
+            EOrmConnectionPool::m_released.wakeAll();
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function close connection and release its statements, the lock is
+ *  held by caller.
+ * \param connection - connection of the pool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция закрывает соединение и освобождает его запросы, блокировка
+ *  удерживается вызывающей стороной.
+ * \param connection - соединение пула
+ * \endlang
+ */
+void EOrmConnectionPool::close(Connection connection)
+{
+    EOrmConnectionPool::m_origins.remove(connection.name);
+    EOrmStatementCache::clear(connection.db);
+    connection.db.close();
+    connection.db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connection.name);
+}
+
+/*!
+ * \lang_en
+ * \brief Destructor of per-thread data, it is called by finishing thread and
+ *  closes connections of the thread.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Деструктор данных потока, вызывается завершающимся потоком и
+ *  закрывает соединения потока.
+ * \endlang
+ */
+EOrmConnectionPool::ThreadData::~ThreadData()
+{
+    QMutexLocker locker(&EOrmConnectionPool::m_mutex);
+    for (int i = EOrmConnectionPool::m_connections.count() - 1; i >= 0; i--) {
+        if (this->owned.contains(EOrmConnectionPool::m_connections.at(i).name)) {
+            EOrmConnectionPool::close(
+                        EOrmConnectionPool::m_connections.takeAt(i));
+        }
+    }
+    EOrmConnectionPool::m_released.wakeAll();
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, take connection from the pool.
+ * \param timeout - time of waiting in milliseconds, -1 to wait forever
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, берет соединение из пула.
+ * \param timeout - время ожидания в миллисекундах, -1 для ожидания без
+ *  ограничения
+ * \endlang
+ */
+EOrmConnectionLease::EOrmConnectionLease(int timeout)
+{
+    this->m_db = EOrmConnectionPool::acquire(timeout);
+    if (this->m_db.isValid()) {
+        EOrmConnectionPool::threadData()->leases.append(
+                    this->m_db.connectionName());
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Destructor, return connection into the pool.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Деструктор, возвращает соединение в пул.
+ * \endlang
+ */
+EOrmConnectionLease::~EOrmConnectionLease()
+{
+    if (this->m_db.isValid()) {
+        QStringList &leases = EOrmConnectionPool::threadData()->leases;
+        leases.removeAt(leases.lastIndexOf(this->m_db.connectionName()));
+        EOrmConnectionPool::release(this->m_db);
+        this->m_db = QSqlDatabase();
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned TRUE if connection was taken.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает TRUE, если соединение было взято.
+ * \return bool
+ * \endlang
+ */
+bool EOrmConnectionLease::isValid() const
+{
+    return this->m_db.isValid();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned the leased connection.
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает арендованное соединение.
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmConnectionLease::db() const
+{
+    return this->m_db;
+}
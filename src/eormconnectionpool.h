@@ -0,0 +1,209 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMCONNECTIONPOOL_H
+#define EORMCONNECTIONPOOL_H
+
+#include "eorm_global.h"
+#include <QtSql>
+#include <QPointer>
+#include <QThreadStorage>
+#include <QWaitCondition>
+
+/*!
+ * \class EOrmConnectionPool
+ *
+ * \lang_en
+ * \brief The static class, bounded pool of database connections for threads.
+ *
+ *  Handle of QSqlDatabase can be used only in the thread that created it,
+ *  so the pool clones the source connection (see setSource()) for every
+ *  thread. Released connections are kept idle and returned again to the same
+ *  thread. Nested acquisitions in one thread share its leased connection.
+ *  Count of connections is limited by maxSize(), when it is reached
+ *  acquire() waits for release. Connection is closed only by its own thread:
+ *  after idleTimeout() at the next acquire() or release() of the thread, and
+ *  when the thread finishes. Usually connections are taken by
+ *  EOrmConnectionLease,
+ *  which is picked up by EOrm::activeConnection(), so EOrmFind and
+ *  EOrmActiveRecord use it without changes. Caches of objects are shared by
+ *  all connections of the pool (see EOrm::connectionKey()). Example:
+ * \code
+ *  // main thread
+ *  EOrmConnectionPool::setSource(QSqlDatabase::database());
+ *  EOrmConnectionPool::setMaxSize(4);
+ *
+ *  // worker thread
+ *  EOrmConnectionLease lease;
+ *  QList<Test*> lst = EOrmFind::find()->all<Test>();
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статический класс, ограниченный пул соединений с базой для потоков.
+ *
+ *  Объект QSqlDatabase можно использовать только в потоке, который его
+ *  создал, поэтому пул клонирует исходное соединение (см. setSource()) для
+ *  каждого потока. Освобожденные соединения простаивают и снова выдаются
+ *  тому же потоку. Вложенные взятия в одном потоке разделяют его
+ *  арендованное соединение. Количество соединений ограничено maxSize(), при
+ *  его достижении acquire() ожидает освобождения. Соединение закрывается
+ *  только своим потоком: через idleTimeout() при следующем вызове acquire()
+ *  или release() этого потока, а также при завершении потока. Обычно
+ *  соединения берутся с помощью
+ *  EOrmConnectionLease, которое подхватывает EOrm::activeConnection(),
+ *  поэтому EOrmFind и EOrmActiveRecord используют его без изменений. Кэши
+ *  объектов общие для всех соединений пула (см. EOrm::connectionKey()).
+ *  Пример:
+ * \code
+ *  // главный поток
+ *  EOrmConnectionPool::setSource(QSqlDatabase::database());
+ *  EOrmConnectionPool::setMaxSize(4);
+ *
+ *  // рабочий поток
+ *  EOrmConnectionLease lease;
+ *  QList<Test*> lst = EOrmFind::find()->all<Test>();
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmConnectionPool
+{
+
+public:
+    static QSqlDatabase source();
+    static void setSource(QSqlDatabase db);
+    static int maxSize();
+    static void setMaxSize(int size);
+    static int idleTimeout();
+    static void setIdleTimeout(int msecs);
+    static QSqlDatabase acquire(int timeout = 30000);
+    static void release(QSqlDatabase db);
+    static QSqlDatabase current();
+    static QString origin(const QString &connectionName);
+    static void clear();
+    static int size();
+    static int idleCount();
+    static qint64 acquisitions();
+    static qint64 timeouts();
+    static qint64 waitTime();
+    static qint64 maxWaitTime();
+
+private:
+    struct Connection {
+        QString name;
+        QSqlDatabase db;
+        QPointer<QThread> thread;
+        int leases;
+        bool retired;
+        QElapsedTimer idle;
+    };
+
+    class ThreadData
+    {
+
+    public:
+        ~ThreadData();
+        QStringList leases;
+        QStringList owned;
+
+    };
+
+    static ThreadData *threadData();
+    static QSqlDatabase take(Connection &connection, qint64 wait);
+    static void evict();
+    static void close(Connection connection);
+
+    static QSqlDatabase m_source;
+    static QList<Connection> m_connections;
+    static QHash<QString, QString> m_origins;
+    static QThreadStorage<ThreadData*> m_threads;
+    static int m_maxSize;
+    static int m_idleTimeout;
+    static int m_serial;
+    static qint64 m_acquisitions;
+    static qint64 m_timeouts;
+    static qint64 m_waitTime;
+    static qint64 m_maxWaitTime;
+    static QMutex m_mutex;
+    static QWaitCondition m_released;
+
+    friend class EOrmConnectionLease;
+
+};
+
+/*!
+ * \class EOrmConnectionLease
+ *
+ * \lang_en
+ * \brief The class, lease of pooled connection for the current scope.
+ *
+ *  Constructor acquires connection from EOrmConnectionPool, destructor
+ *  releases it. While lease exists, EOrm::activeConnection() returns its
+ *  connection in this thread. Leases can be nested, nested lease shares
+ *  connection of the outer one.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс, аренда соединения пула на время текущей области видимости.
+ *
+ *  Конструктор берет соединение из EOrmConnectionPool, деструктор его
+ *  освобождает. Пока аренда существует, EOrm::activeConnection() возвращает
+ *  ее соединение в данном потоке. Аренды могут быть вложенными, вложенная
+ *  аренда разделяет соединение внешней.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmConnectionLease
+{
+
+public:
+    explicit EOrmConnectionLease(int timeout = 30000);
+    ~EOrmConnectionLease();
+    bool isValid() const;
+    QSqlDatabase db() const;
+
+private:
+    Q_DISABLE_COPY(EOrmConnectionLease)
+
+    QSqlDatabase m_db;
+
+};
+
+#endif // EORMCONNECTIONPOOL_H
@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormcursor.h"
+
+/*!
+ * \lang_en
+ * \brief Constructor of base class.
+ * \param query - executed query or null pointer
+ * \param indexes - indexes of result columns
+ * \param reuse - fill the same object on every step
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор базового класса.
+ * \param query - выполненный запрос или нулевой указатель
+ * \param indexes - индексы столбцов результата
+ * \param reuse - заполнять один и тот же объект на каждом шаге
+ * \endlang
+ */
+EOrmCursorBase::EOrmCursorBase(QSharedPointer<QSqlQuery> query,
+                               const QVector<int> &indexes, bool reuse) :
+    m_state(new State())
+{
+    this->m_state->query = query;
+    this->m_state->indexes = indexes;
+    this->m_state->reuse = reuse;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if the query of cursor was executed successfully.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если запрос курсора успешно выполнен.
+ * \return bool
+ * \endlang
+ */
+bool EOrmCursorBase::isValid() const
+{
+    return !this->m_state->query.isNull();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if the same object is filled on every step.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если на каждом шаге заполняется один и тот же
+ *  объект.
+ * \return bool
+ * \endlang
+ */
+bool EOrmCursorBase::isReused() const
+{
+    return this->m_state->reuse;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned number of the current row, -1 before the first row.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает номер текущей строки, -1 до первой строки.
+ * \return int
+ * \endlang
+ */
+int EOrmCursorBase::position() const
+{
+    return this->m_state->position;
+}
+
+/*!
+ * \lang_en
+ * \brief Function move the query to the next row.
+ *
+ *  At the end of result the query is finished and released.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция перемещает запрос на следующую строку.
+ *
+ *  В конце результата запрос завершается и освобождается.
+ * \return bool
+ * \endlang
+ */
+bool EOrmCursorBase::step()
+{
+    this->m_state->current = 0;
+    if (this->m_state->query.isNull()) {
+        return false;
+    }
+    if (!this->m_state->query->next()) {
+        this->m_state->query->finish();
+        this->m_state->query.clear();
+        return false;
+    }
+    this->m_state->position++;
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function fill object from the current row and make it current.
+ * \param obj - object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция заполняет объект из текущей строки и делает его текущим.
+ * \param obj - объект
+ * \return bool
+ * \endlang
+ */
+bool EOrmCursorBase::fill(EOrmActiveRecord *obj)
+{
+    obj->hydrate(*this->m_state->query, this->m_state->indexes, true);
+    this->m_state->current = obj;
+    return true;
+}
@@ -0,0 +1,309 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMCURSOR_H
+#define EORMCURSOR_H
+
+#include "eorm_global.h"
+#include "eormactiverecord.h"
+
+/*!
+ * \class EOrmCursorBase
+ *
+ * \lang_en
+ * \brief Base class of cursor, keeps the forward-only query and fills objects
+ *  from its rows.
+ *
+ *  Copies of cursor share the whole state: the query, the current object and
+ *  the position, so the cursor can be returned by value and a step of one
+ *  copy moves all of them. Use EOrmCursor template class.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Базовый класс курсора, хранит однонаправленный запрос и заполняет
+ *  объекты из его строк.
+ *
+ *  Копии курсора разделяют все состояние: запрос, текущий объект и позицию,
+ *  поэтому курсор можно возвращать по значению, а шаг одной копии перемещает
+ *  их все. Используйте шаблонный класс EOrmCursor.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmCursorBase
+{
+
+public:
+    bool isValid() const;
+    bool isReused() const;
+    int position() const;
+
+protected:
+    EOrmCursorBase(QSharedPointer<QSqlQuery> query,
+                   const QVector<int> &indexes, bool reuse);
+    struct State
+    {
+        State() : current(0), reuse(false), position(-1) {}
+        QSharedPointer<QSqlQuery> query;
+        QSharedPointer<EOrmActiveRecord> record;
+        EOrmActiveRecord *current;
+        QVector<int> indexes;
+        bool reuse;
+        int position;
+    };
+
+    bool step();
+    bool fill(EOrmActiveRecord *obj);
+
+    QSharedPointer<State> m_state;
+
+};
+
+/*!
+ * \class EOrmCursor
+ *
+ * \lang_en
+ * \brief Template class of cursor, selects objects one by one.
+ *
+ *  Cursor is created by EOrmFind::cursor(). The query is executed in
+ *  forward-only mode and every call of next() fills only one object, so memory
+ *  does not grow with count of selected rows. By default every successful
+ *  next() creates a new object owned by the caller: the cursor never deletes
+ *  it, so the caller must take current() after every step and delete it.
+ *  If reuse is set, the only object owned by cursor is filled again on every
+ *  step, it must not be deleted or kept after the next step. Cursor can be
+ *  used with range-based for loop. Example:
+ * \code
+ *  EOrmCursor<Test> cursor = EOrmFind::find()->where("id > 0")
+ *                                            ->cursor<Test>(true);
+ *  while (cursor.next()) {
+ *      export(cursor.current());
+ *  }
+ *
+ *  EOrmCursor<Test> owned = EOrmFind::find()->cursor<Test>();
+ *  while (owned.next()) {
+ *      Test *obj = owned.current();
+ *      export(obj);
+ *      delete obj;
+ *  }
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонный класс курсора, выбирает объекты по одному.
+ *
+ *  Курсор создается функцией EOrmFind::cursor(). Запрос выполняется в
+ *  однонаправленном режиме и каждый вызов next() заполняет только один
+ *  объект, поэтому память не растет с количеством выбранных строк. По
+ *  умолчанию каждый успешный вызов next() создает новый объект, который
+ *  принадлежит вызывающей стороне: курсор никогда его не удаляет, поэтому
+ *  вызывающая сторона должна забирать current() после каждого шага и удалять
+ *  его. Если задано повторное использование, на каждом шаге заново
+ *  заполняется единственный объект, принадлежащий курсору, его нельзя удалять
+ *  или хранить после следующего шага. Курсор можно использовать в цикле for по
+ *  диапазону. Пример:
+ * \code
+ *  EOrmCursor<Test> cursor = EOrmFind::find()->where("id > 0")
+ *                                            ->cursor<Test>(true);
+ *  while (cursor.next()) {
+ *      export(cursor.current());
+ *  }
+ *
+ *  EOrmCursor<Test> owned = EOrmFind::find()->cursor<Test>();
+ *  while (owned.next()) {
+ *      Test *obj = owned.current();
+ *      export(obj);
+ *      delete obj;
+ *  }
+ * \endcode
+ * \endlang
+ */
+template <typename T>
+class EOrmCursor : public EOrmCursorBase
+{
+
+public:
+    class iterator
+    {
+
+    public:
+        iterator(EOrmCursor<T> *cursor = 0) : m_cursor(cursor) {}
+        T *operator*() const { return this->m_cursor->current(); }
+        iterator &operator++()
+        {
+            if (!this->m_cursor->next()) {
+                this->m_cursor = 0;
+            }
+            return *this;
+        }
+        bool operator==(const iterator &other) const
+        {
+            return this->m_cursor == other.m_cursor;
+        }
+        bool operator!=(const iterator &other) const
+        {
+            return this->m_cursor != other.m_cursor;
+        }
+
+    private:
+        EOrmCursor<T> *m_cursor;
+
+    };
+
+    EOrmCursor(QSharedPointer<QSqlQuery> query, const QVector<int> &indexes,
+               bool reuse);
+    bool next();
+    T *current() const;
+    iterator begin();
+    iterator end();
+
+};
+
+/*!
+ * \lang_en
+ * \brief Constructor, it is called by EOrmFind::cursor().
+ * \param query - executed query or null pointer
+ * \param indexes - indexes of result columns
+ * \param reuse - fill the same object on every step
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, вызывается функцией EOrmFind::cursor().
+ * \param query - выполненный запрос или нулевой указатель
+ * \param indexes - индексы столбцов результата
+ * \param reuse - заполнять один и тот же объект на каждом шаге
+ * \endlang
+ */
+template <typename T>
+EOrmCursor<T>::EOrmCursor(QSharedPointer<QSqlQuery> query,
+                          const QVector<int> &indexes, bool reuse) :
+    EOrmCursorBase(query, indexes, reuse)
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Function move cursor to the next row and fill object.
+ *
+ *  Returned FALSE at the end of result, the query is finished then.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция перемещает курсор на следующую строку и заполняет объект.
+ *
+ *  Возвращает FALSE в конце результата, при этом запрос завершается.
+ * \return bool
+ * \endlang
+ */
+template <typename T>
+bool EOrmCursor<T>::next()
+{
+    if (!this->step()) {
+        return false;
+    }
+    EOrmActiveRecord *obj = 0;
+    if (this->isReused()) {
+        if (this->m_state->record.isNull()) {
+            this->m_state->record = QSharedPointer<EOrmActiveRecord>(new T());
+        }
+        obj = this->m_state->record.data();
+    } else {
+        obj = new T();
+    }
+    return this->fill(obj);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned the object of the current row, 0 before the first or after
+ *  the last row.
+ * \return T*
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает объект текущей строки, 0 до первой или после последней
+ *  строки.
+ * \return T*
+ * \endlang
+ */
+template <typename T>
+T *EOrmCursor<T>::current() const
+{
+    return static_cast<T*>(this->m_state->current);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned iterator of the first row, the cursor is moved to it.
+ * \return iterator
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает итератор первой строки, курсор перемещается на нее.
+ * \return iterator
+ * \endlang
+ */
+template <typename T>
+typename EOrmCursor<T>::iterator EOrmCursor<T>::begin()
+{
+    if (this->m_state->current == 0 && !this->next()) {
+        return this->end();
+    }
+    return iterator(this);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned iterator after the last row.
+ * \return iterator
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает итератор после последней строки.
+ * \return iterator
+ * \endlang
+ */
+template <typename T>
+typename EOrmCursor<T>::iterator EOrmCursor<T>::end()
+{
+    return iterator();
+}
+
+#endif // EORMCURSOR_H
@@ -50,7 +50,8 @@
  * \brief Стандартный конструктор, создает пустой объект.
  * \endlang
  */
-EOrmFind::EOrmFind()
+EOrmFind::EOrmFind() :
+    m_isValid(false), m_limit(-1), m_offset(0), m_cacheTtl(-1)
 {
 }
 
@@ -68,10 +69,10 @@ EOrmFind::EOrmFind()
  * \endlang
  */
 EOrmFind::EOrmFind(QSqlDatabase db, QObject *parent) :
-    QObject(parent)
+    QObject(parent), m_isValid(true), m_limit(-1), m_offset(0),
+    m_cacheTtl(-1)
 {
     this->m_db = db;
-    this->m_sqlQuery << "SELECT %1 FROM %2";
 }
 
 /*!
@@ -114,8 +115,10 @@ EOrmFind *EOrmFind::find(QSqlDatabase db)
  * \lang_en
  * \brief Function created sql-unit WHERE.
  *
- *  It are possible to call once before orderBy() and limit(). Otherwise empty
- *  EOrmFind () will be return.
+ *  It are possible to call once before groupBy(), orderBy() and limit().
+ *  Otherwise empty EOrmFind () will be return. Expression is used as is:
+ *  it is not searched for placeholders and is executed without preparing,
+ *  so operators like "?" of PostgreSQL jsonb can be used in it.
  * \param sqlExpression - SQL expression WHERE
  * \return this
  * \endlang
@@ -123,16 +126,179 @@ EOrmFind *EOrmFind::find(QSqlDatabase db)
  * \lang_ru
  * \brief Функция создает sql-блок WHERE.
  *
- *  Можно вызвать единожды до вызова функций orderBy() и limit(). Иначе
- *  возвратится пустой EOrmFind().
+ *  Можно вызвать единожды до вызова функций groupBy(), orderBy() и limit().
+ *  Иначе возвратится пустой EOrmFind(). Выражение используется как есть: в
+ *  нем не ищутся плейсхолдеры, и оно выполняется без подготовки, поэтому в
+ *  нем можно использовать операторы вроде "?" для jsonb PostgreSQL.
  * \param sqlExpression - sql-выражение WHERE
  * \return this
  * \endlang
  */
 EOrmFind *EOrmFind::where(QString sqlExpression)
 {
-    if (this->m_sqlQuery.count() == 1) {
-        this->m_sqlQuery << QString("WHERE %1").arg(sqlExpression);
+    if (this->m_isValid && this->m_where.isEmpty()
+            && this->m_groupBy.isEmpty() && this->m_orderBy.isEmpty()
+            && this->m_limit < 0) {
+        this->m_where = sqlExpression;
+        this->m_params.clear();
+        return this;
+    }
+    return new EOrmFind();
+}
+
+/*!
+ * \lang_en
+ * \brief Function created sql-unit WHERE with bound values.
+ *
+ *  Values are substituted in placeholders "?" in order and are bound to
+ *  statement, they are never written into SQL code. So the code is the same
+ *  for any values, and the database can reuse the plan of statement. Count
+ *  of values should be equal to count of placeholders. It are possible to
+ *  call once before groupBy(), orderBy() and limit(), as where(). Example:
+ * \code
+ *  QList<Test*> lst = EOrmFind::find()->where("id > ? AND name = ?",
+ *                                             QVariantList() << 0 << "Victor")
+ *                                     ->all<Test>();
+ * \endcode
+ * \param sqlExpression - SQL expression WHERE with placeholders
+ * \param params - bound values
+ * \return this
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция создает sql-блок WHERE со значениями параметров.
+ *
+ *  Значения подставляются в плейсхолдеры "?" по порядку и передаются
+ *  параметрами запроса, в SQL-код они никогда не записываются. Поэтому код
+ *  одинаков при любых значениях, и база может повторно использовать план
+ *  запроса. Количество значений должно быть равно количеству плейсхолдеров.
+ *  Можно вызвать единожды до вызова функций groupBy(), orderBy() и limit(),
+ *  как и where(). Пример:
+ * \code
+ *  QList<Test*> lst = EOrmFind::find()->where("id > ? AND name = ?",
+ *                                             QVariantList() << 0 << "Victor")
+ *                                     ->all<Test>();
+ * \endcode
+ * \param sqlExpression - sql-выражение WHERE с плейсхолдерами
+ * \param params - значения параметров
+ * \return this
+ * \endlang
+ */
+EOrmFind *EOrmFind::where(QString sqlExpression, const QVariantList &params)
+{
+    if (this->m_isValid && this->m_where.isEmpty()
+            && this->m_groupBy.isEmpty() && this->m_orderBy.isEmpty()
+            && this->m_limit < 0) {
+        QString positional;
+        QStringList names = EOrmFind::placeholders(
+                    sqlExpression, this->m_db.driverName(), &positional);
+        if (names.count() != params.count()
+                || names.count() != names.count("?")) {
+            EOrm::throwError(45, "Where: Placeholders do not match "
+                             "bound values");
+            return new EOrmFind();
+        }
+        this->m_where = sqlExpression;
+        this->m_params = params;
+        return this;
+    }
+    return new EOrmFind();
+}
+
+/*!
+ * \lang_en
+ * \brief Function created sql-unit WHERE with named bound values.
+ *
+ *  It is similar where() with list of values, but placeholders are named as
+ *  ":name" and values are taken from map by name, with or without colon.
+ *  Placeholder can be used several times. Named placeholders are replaced by
+ *  "?", so they can not be mixed with "?" in one expression. Example:
+ * \code
+ *  QVariantMap params;
+ *  params.insert("name", "Victor");
+ *  QList<Test*> lst = EOrmFind::find()->where("name = :name OR alias = :name",
+ *                                             params)
+ *                                     ->all<Test>();
+ * \endcode
+ * \param sqlExpression - SQL expression WHERE with named placeholders
+ * \param params - bound values by names
+ * \return this
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция создает sql-блок WHERE с именованными значениями
+ *  параметров.
+ *
+ *  Аналогична where() со списком значений, но плейсхолдеры именуются как
+ *  ":name", и значения берутся из словаря по имени, с двоеточием или без.
+ *  Плейсхолдер можно использовать несколько раз. Именованные плейсхолдеры
+ *  заменяются на "?", поэтому в одном выражении их нельзя смешивать с "?".
+ *  Пример:
+ * \code
+ *  QVariantMap params;
+ *  params.insert("name", "Victor");
+ *  QList<Test*> lst = EOrmFind::find()->where("name = :name OR alias = :name",
+ *                                             params)
+ *                                     ->all<Test>();
+ * \endcode
+ * \param sqlExpression - sql-выражение WHERE с именованными плейсхолдерами
+ * \param params - значения параметров по именам
+ * \return this
+ * \endlang
+ */
+EOrmFind *EOrmFind::where(QString sqlExpression, const QVariantMap &params)
+{
+    QString positional;
+    QStringList names = EOrmFind::placeholders(
+                sqlExpression, this->m_db.driverName(), &positional);
+    QVariantList values;
+    foreach (QString name, names) {
+        if (name == QLatin1String("?")) {
+            EOrm::throwError(45, "Where: Placeholders do not match "
+                             "bound values");
+            return new EOrmFind();
+        }
+        if (params.contains(name)) {
+            values << params.value(name);
+        } else if (params.contains(":" + name)) {
+            values << params.value(":" + name);
+        } else {
+            EOrm::throwError(46, "Where: Named bound value is missing");
+            return new EOrmFind();
+        }
+    }
+    return this->where(positional, values);
+}
+
+/*!
+ * \lang_en
+ * \brief Function created sql-unit GROUP BY.
+ *
+ *  It is used only by aggregate() and grouped(), selection of objects or rows
+ *  by all(), one(), cursor(), page() and rows() raises error after it. It
+ *  are possible to call once before orderBy() and limit(), where() can not
+ *  be called after it. Otherwise empty EOrmFind() will be return.
+ * \param sqlExpression - SQL expression GROUP BY
+ * \return this
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция создает sql-блок GROUP BY.
+ *
+ *  Используется только функциями aggregate() и grouped(), выборка объектов
+ *  или строк функциями all(), one(), cursor(), page() и rows() после нее
+ *  вызывает ошибку. Можно вызвать единожды до вызова функций orderBy() и
+ *  limit(), после нее нельзя вызывать where(). Иначе возвратится пустой
+ *  EOrmFind().
+ * \param sqlExpression - sql-выражение GROUP BY
+ * \return this
+ * \endlang
+ */
+EOrmFind *EOrmFind::groupBy(QString sqlExpression)
+{
+    if (this->m_isValid && this->m_groupBy.isEmpty()
+            && this->m_orderBy.isEmpty() && this->m_limit < 0) {
+        this->m_groupBy = sqlExpression;
         return this;
     }
     return new EOrmFind();
@@ -142,8 +308,8 @@ EOrmFind *EOrmFind::where(QString sqlExpression)
  * \lang_en
  * \brief Function created sql-unit ORDER BY.
  *
- *  It are possible to call once before limit() and after a call of where().
- *  Otherwise empty EOrmFind() will be return.
+ *  It are possible to call once before limit(), where() can not be called
+ *  after it. Otherwise empty EOrmFind() will be return.
  * \param sqlExpression - SQL expression ORDER BY
  * \return this
  * \endlang
@@ -151,16 +317,16 @@ EOrmFind *EOrmFind::where(QString sqlExpression)
  * \lang_ru
  * \brief Функция создает sql-блок ORDER BY.
  *
- *  Можно вызвать единожды до вызова функций limit() и после вызова where().
- *  Иначе возвратится пустой EOrmFind().
+ *  Можно вызвать единожды до вызова функции limit(), после нее нельзя
+ *  вызывать where(). Иначе возвратится пустой EOrmFind().
  * \param sqlExpression - sql-выражение ORDER BY
  * \return this
  * \endlang
  */
 EOrmFind *EOrmFind::orderBy(QString sqlExpression)
 {
-    if (this->m_sqlQuery.count() == 2) {
-        this->m_sqlQuery << QString("ORDER BY %1").arg(sqlExpression);
+    if (this->m_isValid && this->m_orderBy.isEmpty() && this->m_limit < 0) {
+        this->m_orderBy = sqlExpression;
         return this;
     }
     return new EOrmFind();
@@ -189,9 +355,892 @@ EOrmFind *EOrmFind::orderBy(QString sqlExpression)
  */
 EOrmFind *EOrmFind::limit(int count, int offset)
 {
-    if (this->m_sqlQuery.count() != 0) {
-        this->m_sqlQuery << QString("LIMIT %1 OFFSET %2").arg(count).arg(offset);
+    if (this->m_isValid) {
+        this->m_limit = count;
+        this->m_offset = offset;
         return this;
     }
     return new EOrmFind();
 }
+
+/*!
+ * \lang_en
+ * \brief Function set columns which are selected for objects.
+ *
+ *  Primary key is always selected. Objects are loaded partially, not selected
+ *  columns are selected at the first reading and are not written by save()
+ *  unless they are set (see EOrmActiveRecord::isLoaded()). Objects returned
+ *  by all() or page() load such columns together: the first reading selects
+ *  them for the whole result by primary keys, so reading every object (for
+ *  example in a view) does not execute a statement per object. Objects of
+ *  cursor() load them one by one, EOrmModel joins objects of every fetched
+ *  chunk. It is possible to call once, otherwise empty EOrmFind() will be
+ *  return. Example:
+ * \code
+ *  QList<Test*> lst = EOrmFind::find()->select(QStringList() << "name")
+ *                                     ->where("id > 0")
+ *                                     ->all<Test>();
+ * \endcode
+ * \param columns - names of selected columns
+ * \return this
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция задает столбцы, выбираемые для объектов.
+ *
+ *  Первичный ключ выбирается всегда. Объекты загружаются частично,
+ *  невыбранные столбцы выбираются при первом чтении и не записываются
+ *  функцией save(), если их не установить (см.
+ *  EOrmActiveRecord::isLoaded()). Объекты, возвращенные all() или page(),
+ *  загружают такие столбцы вместе: первое чтение выбирает их для всего
+ *  результата по первичным ключам, поэтому чтение каждого объекта (например,
+ *  в представлении) не выполняет запрос на каждый объект. Объекты cursor()
+ *  загружают их по одному, EOrmModel объединяет объекты каждой загруженной
+ *  порции. Можно вызвать единожды, иначе возвратится пустой EOrmFind().
+ *  Пример:
+ * \code
+ *  QList<Test*> lst = EOrmFind::find()->select(QStringList() << "name")
+ *                                     ->where("id > 0")
+ *                                     ->all<Test>();
+ * \endcode
+ * \param columns - наименования выбираемых столбцов
+ * \return this
+ * \endlang
+ */
+EOrmFind *EOrmFind::select(QStringList columns)
+{
+    if (this->m_isValid && this->m_select.isEmpty() && !columns.isEmpty()) {
+        this->m_select = columns;
+        return this;
+    }
+    return new EOrmFind();
+}
+
+/*!
+ * \lang_en
+ * \brief Function turn on query cache for results of this query.
+ *
+ *  Results of all(), one(), rows(), count(), exists() and aggregates are
+ *  taken from EOrmQueryCache while they are not older than ttl and the table
+ *  is not changed through the ORM. Functions get(), cursor() and page() do
+ *  not use the cache. Result which expires at once is never taken from cache,
+ *  so ttl should be greater than 0. It is possible to call once, otherwise or
+ *  for ttl less than 1 empty EOrmFind() will be return. Example:
+ * \code
+ *  QList<Test*> lst = EOrmFind::find()->where("active = 1")
+ *                                     ->cache(60000)
+ *                                     ->all<Test>();
+ * \endcode
+ * \param ttl - time to live of results in milliseconds
+ * \return this
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция включает кэш запросов для результатов данного запроса.
+ *
+ *  Результаты all(), one(), rows(), count(), exists() и агрегатов берутся из
+ *  EOrmQueryCache, пока они не старше ttl и таблица не изменялась через ORM.
+ *  Функции get(), cursor() и page() кэш не используют. Результат, который
+ *  устаревает сразу, никогда не берется из кэша, поэтому ttl должно быть
+ *  больше 0. Можно вызвать единожды, иначе или при ttl меньше 1 возвратится
+ *  пустой EOrmFind(). Пример:
+ * \code
+ *  QList<Test*> lst = EOrmFind::find()->where("active = 1")
+ *                                     ->cache(60000)
+ *                                     ->all<Test>();
+ * \endcode
+ * \param ttl - время жизни результатов в миллисекундах
+ * \return this
+ * \endlang
+ */
+EOrmFind *EOrmFind::cache(int ttl)
+{
+    if (this->m_isValid && this->m_cacheTtl < 0 && ttl > 0) {
+        this->m_cacheTtl = ttl;
+        return this;
+    }
+    return new EOrmFind();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned copy of conditions with the given connection.
+ * \param db - a database object
+ * \return *EOrmFind
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает копию условий с заданным соединением.
+ * \param db - объект базы данных
+ * \return *EOrmFind
+ * \endlang
+ */
+EOrmFind *EOrmFind::clone(QSqlDatabase db) const
+{
+    EOrmFind *find = new EOrmFind(db);
+    find->m_isValid = this->m_isValid;
+    find->m_select = this->m_select;
+    find->m_where = this->m_where;
+    find->m_params = this->m_params;
+    find->m_groupBy = this->m_groupBy;
+    find->m_orderBy = this->m_orderBy;
+    find->m_limit = this->m_limit;
+    find->m_offset = this->m_offset;
+    find->m_cacheTtl = this->m_cacheTtl;
+    return find;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned key columns of page() for orderBy() of this query.
+ *
+ *  Every item of orderBy() should be column with optional ASC or DESC, all in
+ *  the same direction. Primary key is appended to columns if it is absent,
+ *  so keys are unique. Without orderBy() the key is primary key.
+ * \param pkName - name of primary key
+ * \param keys - key columns are written there
+ * \param descending - direction of sorting is written there
+ * \return FALSE if orderBy() can not be used as key of page
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает столбцы ключа page() для orderBy() этого запроса.
+ *
+ *  Каждый элемент orderBy() должен быть столбцом с необязательным ASC или
+ *  DESC, все в одном направлении. Первичный ключ добавляется к столбцам, если
+ *  его нет, поэтому ключи уникальны. Без orderBy() ключом является первичный
+ *  ключ.
+ * \param pkName - наименование первичного ключа
+ * \param keys - сюда записываются столбцы ключа
+ * \param descending - сюда записывается направление сортировки
+ * \return FALSE, если orderBy() нельзя использовать как ключ страницы
+ * \endlang
+ */
+bool EOrmFind::orderKeys(const QString &pkName, QStringList *keys,
+                         bool *descending) const
+{
+    QStringList columns;
+    bool desc = false;
+    QStringList items;
+    if (!this->m_orderBy.trimmed().isEmpty()) {
+        items = this->m_orderBy.split(',');
+    }
+    for (int i = 0; i < items.count(); i++) {
+        QStringList parts = items.at(i).simplified().split(' ');
+        if (parts.first().isEmpty() || parts.count() > 2) {
+            return false;
+        }
+        bool itemDesc = false;
+        if (parts.count() == 2) {
+            QString direction = parts.at(1).toUpper();
+            if (direction == "DESC") {
+                itemDesc = true;
+            } else if (direction != "ASC") {
+                return false;
+            }
+        }
+        if (i == 0) {
+            desc = itemDesc;
+        } else if (itemDesc != desc) {
+            return false;
+        }
+        columns << parts.first();
+    }
+    if (!columns.contains(pkName)) {
+        columns << pkName;
+    }
+    *keys = columns;
+    *descending = desc;
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned columns of object which are selected.
+ *
+ *  If select() was not called all columns are returned. Columns are listed in
+ *  database order, unknown columns cause an error.
+ * \param columns - columns of the table
+ * \param pkName - name of primary key
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает выбираемые столбцы объекта.
+ *
+ *  Если select() не вызывалась, возвращаются все столбцы. Столбцы
+ *  перечисляются в порядке базы, неизвестные столбцы приводят к ошибке.
+ * \param columns - столбцы таблицы
+ * \param pkName - наименование первичного ключа
+ * \return QStringList
+ * \endlang
+ */
+QStringList EOrmFind::selectedColumns(const QStringList &columns,
+                                      const QString &pkName) const
+{
+    if (this->m_select.isEmpty()) {
+        return columns;
+    }
+    foreach (QString column, this->m_select) {
+        if (!columns.contains(column)) {
+            EOrm::throwError(44, "Select: Object properties are missing "
+                             "in table");
+            return columns;
+        }
+    }
+    QStringList selected;
+    foreach (QString column, columns) {
+        if (column == pkName || this->m_select.contains(column)) {
+            selected << column;
+        }
+    }
+    return selected;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned object registered in current identity map.
+ *
+ *  Returned 0 if there is no current map or object is not registered.
+ * \param tableName - name of the table
+ * \param pk - primary key
+ * \return EOrmActiveRecord*
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает объект, зарегистрированный в текущей карте
+ *  идентичности.
+ *
+ *  Возвращает 0, если текущей карты нет или объект не зарегистрирован.
+ * \param tableName - имя таблицы
+ * \param pk - первичный ключ
+ * \return EOrmActiveRecord*
+ * \endlang
+ */
+EOrmActiveRecord *EOrmFind::identity(const QString &tableName,
+                                     const QVariant &pk)
+{
+    EOrmIdentityMap *map = EOrmIdentityMap::current();
+    if (map == 0) {
+        return 0;
+    }
+    return map->lookup(this->m_db, tableName, pk);
+}
+
+/*!
+ * \lang_en
+ * \brief Function resolve positions of columns in query result.
+ *
+ *  It is called once per query, so objects are filled by indexes without
+ *  search of column by name for every row.
+ * \param record - query result record
+ * \param columns - names of object columns
+ * \return QVector<int>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция определяет позиции столбцов в результате запроса.
+ *
+ *  Вызывается один раз на запрос, поэтому объекты заполняются по индексам,
+ *  без поиска столбца по имени для каждой строки.
+ * \param record - запись результата запроса
+ * \param columns - наименования столбцов объекта
+ * \return QVector<int>
+ * \endlang
+ */
+QVector<int> EOrmFind::columnIndexes(const QSqlRecord &record,
+                                     const QStringList &columns)
+{
+    QVector<int> indexes(columns.count());
+    for (int i = 0; i < columns.count(); i++) {
+        indexes[i] = record.indexOf(columns.at(i));
+    }
+    return indexes;
+}
+
+/*!
+ * \lang_en
+ * \brief Function determine positions of columns in rows of values.
+ * \param rows - rows of values
+ * \param columns - names of object columns
+ * \return QVector<int>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция определяет позиции столбцов в строках значений.
+ * \param rows - строки значений
+ * \param columns - наименования столбцов объекта
+ * \return QVector<int>
+ * \endlang
+ */
+QVector<int> EOrmFind::columnIndexes(const EOrmRowSet &rows,
+                                     const QStringList &columns)
+{
+    QVector<int> indexes(columns.count());
+    for (int i = 0; i < columns.count(); i++) {
+        indexes[i] = rows.indexOf(columns.at(i));
+    }
+    return indexes;
+}
+
+/*!
+ * \lang_en
+ * \brief Function find placeholders of SQL expression.
+ *
+ *  Returned placeholders in order: "?" for positional placeholder or name
+ *  for named placeholder ":name". String literals, quoted identifiers (by
+ *  double quotes, backticks or, for QSQLITE, QODBC and QTDS, brackets),
+ *  dollar-quoted strings "$tag$", comments and casts "::" are skipped. Other
+ *  drivers use brackets for array subscripts, which can contain
+ *  placeholders. Expression with named placeholders replaced by "?" is
+ *  written into positional.
+ * \param sqlExpression - SQL expression
+ * \param driverName - name of the driver of connection
+ * \param positional - expression with positional placeholders only
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция находит плейсхолдеры SQL-выражения.
+ *
+ *  Возвращает плейсхолдеры по порядку: "?" для позиционного плейсхолдера или
+ *  имя для именованного плейсхолдера ":name". Строковые литералы,
+ *  идентификаторы в кавычках (двойных, обратных или, для QSQLITE, QODBC и
+ *  QTDS, квадратных скобках), строки в долларовых кавычках "$tag$",
+ *  комментарии и приведения типов "::" пропускаются. Другие драйверы
+ *  используют квадратные скобки для индексов массивов, которые могут
+ *  содержать плейсхолдеры. Выражение, в котором именованные плейсхолдеры
+ *  заменены на "?", записывается в positional.
+ * \param sqlExpression - SQL-выражение
+ * \param driverName - имя драйвера соединения
+ * \param positional - выражение только с позиционными плейсхолдерами
+ * \return QStringList
+ * \endlang
+ */
+QStringList EOrmFind::placeholders(const QString &sqlExpression,
+                                   const QString &driverName,
+                                   QString *positional)
+{
+    QStringList names;
+    positional->clear();
+    bool brackets = (driverName == "QSQLITE" || driverName == "QODBC"
+                     || driverName == "QTDS");
+    int size = sqlExpression.size();
+    int i = 0;
+    while (i < size) {
+        QChar c = sqlExpression.at(i);
+        QChar next = (i + 1 < size) ? sqlExpression.at(i + 1) : QChar();
+        // end of the skipped text, -1 if text is not skipped
+        int end = -1;
+        if (c == QLatin1Char('\'') || c == QLatin1Char('"')
+                || c == QLatin1Char('`')
+                || (brackets && c == QLatin1Char('['))) {
+            QChar close = (c == QLatin1Char('[')) ? QChar(QLatin1Char(']'))
+                                                  : c;
+            end = sqlExpression.indexOf(close, i + 1);
+            end = (end < 0) ? size : end + 1;
+        } else if (c == QLatin1Char('-') && next == QLatin1Char('-')) {
+            end = sqlExpression.indexOf(QLatin1Char('\n'), i);
+            end = (end < 0) ? size : end;
+        } else if (c == QLatin1Char('/') && next == QLatin1Char('*')) {
+            end = sqlExpression.indexOf(QLatin1String("*/"), i + 2);
+            end = (end < 0) ? size : end + 2;
+        } else if (c == QLatin1Char('$')) {
+            int close = sqlExpression.indexOf(QLatin1Char('$'), i + 1);
+            bool tag = (close > i);
+            for (int j = i + 1; tag && j < close; j++) {
+                QChar t = sqlExpression.at(j);
+                tag = t.isLetter() || t == QLatin1Char('_')
+                        || (j > i + 1 && t.isLetterOrNumber());
+            }
+            if (tag) {
+                QString delimiter = sqlExpression.mid(i, close - i + 1);
+                end = sqlExpression.indexOf(delimiter, close + 1);
+                end = (end < 0) ? size : end + delimiter.size();
+            }
+        }
+        if (end > -1) {
+            positional->append(sqlExpression.mid(i, end - i));
+            i = end;
+        } else if (c == QLatin1Char('?')) {
+            names << QString(c);
+            positional->append(c);
+            i++;
+        } else if (c == QLatin1Char(':') && next == QLatin1Char(':')) {
+            positional->append(QLatin1String("::"));
+            i += 2;
+        } else if (c == QLatin1Char(':')
+                   && (next.isLetter() || next == QLatin1Char('_'))) {
+            int start = ++i;
+            while (i < size
+                   && (sqlExpression.at(i).isLetterOrNumber()
+                       || sqlExpression.at(i) == QLatin1Char('_'))) {
+                i++;
+            }
+            names << sqlExpression.mid(start, i - start);
+            positional->append(QLatin1Char('?'));
+        } else {
+            positional->append(c);
+            i++;
+        }
+    }
+    return names;
+}
+
+/*!
+ * \lang_en
+ * \brief Function generated SQL code of selection.
+ *
+ *  Objects and rows are not grouped, so error is raised if groupBy() was
+ *  called.
+ * \param columns - selected columns
+ * \param tableName - name of the table
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция формирует SQL-код выборки.
+ *
+ *  Объекты и строки не группируются, поэтому при вызове groupBy() возникает
+ *  ошибка.
+ * \param columns - выбираемые столбцы
+ * \param tableName - имя таблицы
+ * \return QString
+ * \endlang
+ */
+QString EOrmFind::selectSql(const QStringList &columns,
+                            const QString &tableName) const
+{
+    if (!this->m_groupBy.isEmpty()) {
+        EOrm::throwError(56, "Find: groupBy() is used only by aggregate() "
+                         "and grouped()");
+        return QString();
+    }
+    QStringList sql;
+    sql << "SELECT";
+    sql << columns.join(",");
+    sql << "FROM";
+    sql << tableName;
+    if (!this->m_where.isEmpty()) {
+        sql << "WHERE" << this->m_where;
+    }
+    if (!this->m_orderBy.isEmpty()) {
+        sql << "ORDER BY" << this->m_orderBy;
+    }
+    if (this->m_limit > -1) {
+        sql << QString("LIMIT %1 OFFSET %2").arg(this->m_limit)
+               .arg(this->m_offset);
+    }
+    return sql.join(" ");
+}
+
+/*!
+ * \lang_en
+ * \brief Function generated SQL code of selection of the page by key.
+ *
+ *  Condition on key is written as comparison of row values, placeholders of
+ *  values of key follow placeholders of where(). Error is raised if groupBy()
+ *  was called, as in selectSql().
+ * \param columns - selected columns
+ * \param tableName - name of the table
+ * \param keys - sort key columns
+ * \param token - page token
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция формирует SQL-код выборки страницы по ключу.
+ *
+ *  Условие на ключ записывается как сравнение строк значений, плейсхолдеры
+ *  значений ключа следуют за плейсхолдерами where(). При вызове groupBy()
+ *  возникает ошибка, как в selectSql().
+ * \param columns - выбираемые столбцы
+ * \param tableName - имя таблицы
+ * \param keys - столбцы ключа сортировки
+ * \param token - маркер страницы
+ * \return QString
+ * \endlang
+ */
+QString EOrmFind::pageSql(const QStringList &columns, const QString &tableName,
+                          const QStringList &keys,
+                          const EOrmPageToken &token) const
+{
+    if (!this->m_groupBy.isEmpty()) {
+        EOrm::throwError(56, "Find: groupBy() is used only by aggregate() "
+                         "and grouped()");
+        return QString();
+    }
+    QStringList sql;
+    sql << "SELECT";
+    sql << columns.join(",");
+    sql << "FROM";
+    sql << tableName;
+    QStringList conditions;
+    if (!this->m_where.isEmpty()) {
+        conditions << "(" + this->m_where + ")";
+    }
+    if (!token.isFirst()) {
+        QString op = token.isDescending() ? "<" : ">";
+        if (keys.count() == 1) {
+            conditions << keys.first() + " " + op + " ?";
+        } else {
+            conditions << "(" + keys.join(", ") + ") " + op + " ("
+                          + EOrmStatementCache::placeholders(keys.count())
+                          + ")";
+        }
+    }
+    if (!conditions.isEmpty()) {
+        sql << "WHERE" << conditions.join(" AND ");
+    }
+    QStringList order;
+    foreach (QString key, keys) {
+        order << (token.isDescending() ? key + " DESC" : key);
+    }
+    sql << "ORDER BY" << order.join(", ");
+    sql << QString("LIMIT %1").arg(token.count());
+    return sql.join(" ");
+}
+
+/*!
+ * \lang_en
+ * \brief Function execute selection and read rows of values.
+ *
+ *  If cache() was called, rows are taken from query cache when possible and
+ *  stored into it after selection.
+ * \param sql - SQL code of selection
+ * \param tableName - name of the table
+ * \param ok - if it is set, FALSE is written there on error
+ * \return EOrmRowSet
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция выполняет выборку и читает строки значений.
+ *
+ *  Если вызывалась cache(), строки по возможности берутся из кэша запросов и
+ *  помещаются в него после выборки.
+ * \param sql - SQL-код выборки
+ * \param tableName - имя таблицы
+ * \param ok - если задан, в него записывается FALSE при ошибке
+ * \return EOrmRowSet
+ * \endlang
+ */
+EOrmRowSet EOrmFind::rows(const QString &sql, const QString &tableName,
+                          bool *ok)
+{
+    EOrmRowSet result;
+    if (ok) {
+        *ok = true;
+    }
+    if (this->m_cacheTtl > -1
+            && EOrmQueryCache::fetch(this->m_db, tableName, sql,
+                                     this->m_params, &result)) {
+        return result;
+    }
+    quint64 generation = EOrmQueryCache::generation(this->m_db, tableName);
+    QSharedPointer<QSqlQuery> qr = this->execute(sql, this->m_params);
+    if (!qr.isNull()) {
+        result = EOrmRowSet::fromQuery(qr.data());
+        qr->finish();
+        if (this->m_cacheTtl > -1) {
+            EOrmQueryCache::store(this->m_db, tableName, sql, this->m_params,
+                                  result, this->m_cacheTtl, generation);
+        }
+    } else if (ok) {
+        *ok = false;
+    }
+    return result;
+}
+
+/*!
+ * \lang_en
+ * \brief Function execute selection with bound values.
+ *
+ *  Statement is taken from EOrmStatementCache, so it is prepared once per
+ *  connection and SQL code. Without bound values the SQL code is executed
+ *  by new QSqlQuery without preparing, so literal condition of where() is
+ *  neither parsed for placeholders by the driver nor kept in the cache.
+ *  Returned null pointer on error. Statement should be released by
+ *  QSqlQuery::finish() after reading.
+ * \param sql - SQL code of selection
+ * \param values - bound values
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция выполняет выборку со значениями параметров.
+ *
+ *  Запрос берется из EOrmStatementCache, поэтому подготавливается один раз
+ *  для соединения и SQL-кода. Без значений параметров SQL-код выполняется
+ *  новым QSqlQuery без подготовки, поэтому литеральное условие where() не
+ *  разбирается драйвером на плейсхолдеры и не хранится в кэше. При ошибке
+ *  возвращает нулевой указатель. После чтения запрос нужно освободить
+ *  функцией QSqlQuery::finish().
+ * \param sql - SQL-код выборки
+ * \param values - значения параметров
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ */
+QSharedPointer<QSqlQuery> EOrmFind::execute(const QString &sql,
+                                            const QVariantList &values)
+{
+    if (values.isEmpty()) {
+        QSharedPointer<QSqlQuery> qr(new QSqlQuery(this->m_db));
+        qr->setForwardOnly(true);
+        if (!qr->exec(sql)) {
+            return QSharedPointer<QSqlQuery>();
+        }
+        return qr;
+    }
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(this->m_db,
+                                                                 sql);
+    if (qr.isNull()) {
+        return qr;
+    }
+    qr->setForwardOnly(true);
+    for (int i = 0; i < values.count(); i++) {
+        qr->bindValue(i, values.at(i));
+    }
+    if (!qr->exec()) {
+        qr->finish();
+        return QSharedPointer<QSqlQuery>();
+    }
+    return qr;
+}
+
+/*!
+ * \lang_en
+ * \brief Function select one aggregate value by where() condition.
+ *
+ *  EOrmException* is thrown if groupBy() was called or the statement failed.
+ * \param tableName - name of the table
+ * \param sqlExpression - SQL expression of aggregate
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция выбирает одно агрегатное значение по условию where().
+ *
+ *  Если вызывалась groupBy() или запрос не выполнен, выбрасывается
+ *  EOrmException*.
+ * \param tableName - имя таблицы
+ * \param sqlExpression - SQL-выражение агрегата
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmFind::scalar(const QString &tableName,
+                          const QString &sqlExpression)
+{
+    if (!this->m_groupBy.isEmpty()) {
+        EOrm::throwError(52, "Aggregate: groupBy() is not used by single "
+                         "aggregate, use aggregate() instead");
+        return QVariant();
+    }
+    QStringList sql;
+    sql << "SELECT";
+    sql << sqlExpression;
+    sql << "FROM";
+    sql << tableName;
+    if (!this->m_where.isEmpty()) {
+        sql << "WHERE" << this->m_where;
+    }
+    bool ok = false;
+    EOrmRowSet result = this->rows(sql.join(" "), tableName, &ok);
+    if (!ok || result.isEmpty()) {
+        EOrm::throwError(51, "Aggregate: Execute query failed");
+        return QVariant();
+    }
+    return result.value(0, 0);
+}
+
+/*!
+ * \lang_en
+ * \brief Function check existence of rows by where() condition.
+ * \param tableName - name of the table
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет наличие строк по условию where().
+ * \param tableName - имя таблицы
+ * \return bool
+ * \endlang
+ */
+bool EOrmFind::exists(const QString &tableName)
+{
+    QStringList sql;
+    sql << "SELECT 1 FROM";
+    sql << tableName;
+    if (!this->m_where.isEmpty()) {
+        sql << "WHERE" << this->m_where;
+    }
+    sql << "LIMIT 1";
+    return !this->rows(sql.join(" "), tableName).isEmpty();
+}
+
+/*!
+ * \lang_en
+ * \brief Function generated SQL code of selection of aggregates by groups.
+ * \param tableName - name of the table
+ * \param sqlExpression - SQL expression of aggregates
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция формирует SQL-код выборки агрегатов по группам.
+ * \param tableName - имя таблицы
+ * \param sqlExpression - SQL-выражение агрегатов
+ * \return QString
+ * \endlang
+ */
+QString EOrmFind::aggregateSql(const QString &tableName,
+                               const QString &sqlExpression) const
+{
+    QStringList sql;
+    sql << "SELECT";
+    if (!this->m_groupBy.isEmpty()) {
+        sql << this->m_groupBy + ",";
+    }
+    sql << sqlExpression;
+    sql << "FROM";
+    sql << tableName;
+    if (!this->m_where.isEmpty()) {
+        sql << "WHERE" << this->m_where;
+    }
+    if (!this->m_groupBy.isEmpty()) {
+        sql << "GROUP BY" << this->m_groupBy;
+    }
+    if (!this->m_orderBy.isEmpty()) {
+        sql << "ORDER BY" << this->m_orderBy;
+    }
+    if (this->m_limit > -1) {
+        sql << QString("LIMIT %1 OFFSET %2").arg(this->m_limit)
+               .arg(this->m_offset);
+    }
+    return sql.join(" ");
+}
+
+/*!
+ * \lang_en
+ * \brief Function update rows of the table satisfacted to where() condition.
+ *
+ *  Columns are set in database order, unknown columns cause an error. Updated
+ *  columns of objects of the table in the current identity map are marked as
+ *  not loaded (see EOrmIdentityMap::refresh()).
+ * \param tableName - name of the table
+ * \param columns - columns of the table
+ * \param values - new values of columns
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция обновляет строки таблицы, удовлетворяющие условию where().
+ *
+ *  Столбцы устанавливаются в порядке базы, неизвестные столбцы приводят к
+ *  ошибке. Обновленные столбцы объектов таблицы в текущей карте
+ *  идентичности отмечаются незагруженными (см. EOrmIdentityMap::refresh()).
+ * \param tableName - имя таблицы
+ * \param columns - столбцы таблицы
+ * \param values - новые значения столбцов
+ * \return int
+ * \endlang
+ */
+int EOrmFind::updateAll(const QString &tableName, const QStringList &columns,
+                        QHash<QString, QVariant> values)
+{
+    if (values.isEmpty()) {
+        return 0;
+    }
+    QStringList setList;
+    QStringList updated;
+    QVariantList setValues;
+    foreach (QString column, columns) {
+        if (values.contains(column)) {
+            setList << column + " = ?";
+            updated << column;
+            setValues << values.take(column);
+        }
+    }
+    if (!values.isEmpty()) {
+        EOrm::throwError(29, "Update all: Object properties are missing "
+                         "in table");
+        return 0;
+    }
+    QStringList sql;
+    sql << "UPDATE";
+    sql << tableName;
+    sql << "SET";
+    sql << setList.join(", ");
+    if (!this->m_where.isEmpty()) {
+        sql << "WHERE" << this->m_where;
+    }
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                this->m_db, sql.join(" "));
+    if (!qr.isNull()) {
+        setValues << this->m_params;
+        for (int i = 0; i < setValues.count(); i++) {
+            qr->bindValue(i, setValues.at(i));
+        }
+        if (qr->exec()) {
+            int rowsAffected = qr->numRowsAffected();
+            qr->finish();
+            EOrmRecordCache::invalidate(this->m_db, tableName);
+            EOrmQueryCache::invalidate(this->m_db, tableName);
+            EOrmIdentityMap *map = EOrmIdentityMap::current();
+            if (map != 0) {
+                map->refresh(this->m_db, tableName, updated);
+            }
+            return rowsAffected;
+        } else {
+            qr->finish();
+            EOrm::throwError(31, "Update all: Execute query failed");
+        }
+    } else {
+        EOrm::throwError(30, "Update all: Prepare query failed");
+    }
+    return 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Function delete rows of the table satisfacted to where() condition.
+ *
+ *  Objects of the table in the current identity map are expired (see
+ *  EOrmIdentityMap::expire()).
+ * \param tableName - name of the table
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция удаляет строки таблицы, удовлетворяющие условию where().
+ *
+ *  Объекты таблицы в текущей карте идентичности становятся устаревшими (см.
+ *  EOrmIdentityMap::expire()).
+ * \param tableName - имя таблицы
+ * \return int
+ * \endlang
+ */
+int EOrmFind::deleteAll(const QString &tableName)
+{
+    QStringList sql;
+    sql << "DELETE FROM";
+    sql << tableName;
+    if (!this->m_where.isEmpty()) {
+        sql << "WHERE" << this->m_where;
+    }
+    QSharedPointer<QSqlQuery> qr = this->execute(sql.join(" "),
+                                                 this->m_params);
+    if (!qr.isNull()) {
+        int rowsAffected = qr->numRowsAffected();
+        qr->finish();
+        EOrmRecordCache::invalidate(this->m_db, tableName);
+        EOrmQueryCache::invalidate(this->m_db, tableName);
+        EOrmIdentityMap *map = EOrmIdentityMap::current();
+        if (map != 0) {
+            map->expire(this->m_db, tableName);
+        }
+        return rowsAffected;
+    } else {
+        EOrm::throwError(32, "Delete all: Execute query failed");
+    }
+    return 0;
+}
@@ -44,6 +44,14 @@
 
 #include "eorm_global.h"
 #include "eormactiverecord.h"
+#include "eormcursor.h"
+#include "eormpagetoken.h"
+#include "eormrowset.h"
+#include "eormidentitymap.h"
+#include "eormquerycache.h"
+
+template <typename T>
+class EOrmModelCursor;
 
 /*!
  * \class EOrmFind
@@ -65,6 +73,11 @@
  *
  *  // one object
  *  Test *testObj = EOrmFind::find()->where("othertable_id = 1")->one<Test>();
+ *
+ *  // bound values
+ *  lst = EOrmFind::find()->where("id > ? AND name = ?",
+ *                                QVariantList() << 0 << "Victor")
+ *                        ->all<Test>();
  * \endcode
  * \endlang
  *
@@ -84,12 +97,22 @@
  *
  *  // один объект
  *  Test *testObj = EOrmFind::find()->where("linkedtable_id = 1")->one<Test>();
+ *
+ *  // значения параметров
+ *  lst = EOrmFind::find()->where("id > ? AND name = ?",
+ *                                QVariantList() << 0 << "Victor")
+ *                        ->all<Test>();
  * \endcode
  * \endlang
  */
 class EORMSHARED_EXPORT EOrmFind : public QObject
 {
     Q_OBJECT
+    friend class EOrmAsync;
+    friend class EOrmModel;
+    template <typename T>
+    friend class EOrmModelCursor;
+    friend class tst_EOrmFind;
 
 public:
     explicit EOrmFind();
@@ -98,15 +121,96 @@ public:
     QList<T*> all();
     template <typename T>
     T *one();
+    template <typename T>
+    T *get(const QVariant &pk);
+    template <typename T>
+    EOrmCursor<T> cursor(bool reuse = false);
+    template <typename T>
+    QList<T*> page(EOrmPageToken *token);
+    template <typename T>
+    EOrmRowSet rows();
+    template <typename T>
+    int count();
+    template <typename T>
+    bool exists();
+    template <typename T>
+    QVariant sum(const QString &column);
+    template <typename T>
+    QVariant min(const QString &column);
+    template <typename T>
+    QVariant max(const QString &column);
+    template <typename T>
+    QVariant avg(const QString &column);
+    template <typename T>
+    EOrmRowSet aggregate(const QString &sqlExpression);
+    template <typename T>
+    QMap<QString, QVariant> grouped(const QString &sqlExpression);
+    template <typename T>
+    int updateAll(QHash<QString, QVariant> values);
+    template <typename T>
+    int deleteAll();
     static EOrmFind *find();
     static EOrmFind *find(QSqlDatabase db);
     EOrmFind *where(QString sqlExpression);
+    EOrmFind *where(QString sqlExpression, const QVariantList &params);
+    EOrmFind *where(QString sqlExpression, const QVariantMap &params);
+    EOrmFind *groupBy(QString sqlExpression);
     EOrmFind *orderBy(QString sqlExpression);
     EOrmFind *limit(int count, int offset = 0);
+    EOrmFind *select(QStringList columns);
+    EOrmFind *cache(int ttl);
 
 private:
+    template <typename T>
+    bool resolve(QString *tableName, QString *pkName, QStringList *columns);
+    template <typename T>
+    QVariant aggregate(const QString &function, const QString &column);
+    template <typename T>
+    T *record(const QSqlQuery &query, const QVector<int> &indexes,
+              const QString &tableName, int pkIndex);
+    template <typename T>
+    T *record(const EOrmRowSet &rows, int row, const QVector<int> &indexes,
+              const QString &tableName, int pkIndex);
+    EOrmActiveRecord *identity(const QString &tableName, const QVariant &pk);
+    EOrmFind *clone(QSqlDatabase db) const;
+    bool orderKeys(const QString &pkName, QStringList *keys,
+                   bool *descending) const;
+    QStringList selectedColumns(const QStringList &columns,
+                                const QString &pkName) const;
+    QString selectSql(const QStringList &columns,
+                      const QString &tableName) const;
+    QString pageSql(const QStringList &columns, const QString &tableName,
+                    const QStringList &keys,
+                    const EOrmPageToken &token) const;
+    int updateAll(const QString &tableName, const QStringList &columns,
+                  QHash<QString, QVariant> values);
+    int deleteAll(const QString &tableName);
+    QSharedPointer<QSqlQuery> execute(const QString &sql,
+                                      const QVariantList &values);
+    EOrmRowSet rows(const QString &sql, const QString &tableName,
+                    bool *ok = 0);
+    QVariant scalar(const QString &tableName, const QString &sqlExpression);
+    bool exists(const QString &tableName);
+    QString aggregateSql(const QString &tableName,
+                         const QString &sqlExpression) const;
+    static QVector<int> columnIndexes(const QSqlRecord &record,
+                                      const QStringList &columns);
+    static QVector<int> columnIndexes(const EOrmRowSet &rows,
+                                      const QStringList &columns);
+    static QStringList placeholders(const QString &sqlExpression,
+                                    const QString &driverName,
+                                    QString *positional);
+
     QSqlDatabase m_db;
-    QStringList m_sqlQuery;
+    bool m_isValid;
+    QStringList m_select;
+    QString m_where;
+    QVariantList m_params;
+    QString m_groupBy;
+    QString m_orderBy;
+    int m_limit;
+    int m_offset;
+    int m_cacheTtl;
 
 };
 
@@ -115,7 +219,9 @@ private:
  * \brief Template function, select objects list.
  *
  *  Execute generated SQL code, substitut a name of the table and
- *  primary key. Using for select multiple objects.
+ *  object columns. Using for select multiple objects. All objects are filled
+ *  from the one selection, without separate query per object. If cache() was
+ *  called, the selection can be taken from query cache, the same for one().
  * \return QList<T*>
  * \endlang
  *
@@ -123,7 +229,10 @@ private:
  * \brief Шаблонная функция выборки множества объектов.
  *
  *  Запускает сформированный SQL-код на выполнение, подставляя имя таблицы и
- *  первичный ключ. Используется для выборки множества объектов.
+ *  столбцы объекта. Используется для выборки множества объектов. Все объекты
+ *  заполняются из одной выборки, без отдельного запроса на каждый объект.
+ *  Если вызывалась cache(), выборка может браться из кэша запросов, так же
+ *  для one().
  * \return QList<T*>
  * \endlang
  */
@@ -131,23 +240,36 @@ template <typename T>
 QList<T*> EOrmFind::all()
 {
     QList<T*> objList;
-    QString sql = this->m_sqlQuery.join(" ");
-    if (sql.count() > 0) {
-        T *obj = new T();
-        if (obj->inherits("EOrmActiveRecord")) {
-            QString pkName = obj->primaryKeyName();
-            QString tableName = obj->tableName();
-            delete obj;
-            if (!pkName.isEmpty() && !tableName.isEmpty()) {
-                QSqlQuery qr(sql.arg(pkName).arg(tableName), this->m_db);
-                if (qr.isActive()) {
-                    while (qr.next()) {
-                        T *obj = new T(qr.record().value(pkName));
-                        objList.append(obj);
-                    }
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        QString sql = this->selectSql(this->selectedColumns(columns, pkName),
+                                      tableName);
+        int pkIndex = columns.indexOf(pkName);
+        if (this->m_cacheTtl > -1) {
+            EOrmRowSet rows = this->rows(sql, tableName);
+            QVector<int> indexes = EOrmFind::columnIndexes(rows, columns);
+            for (int i = 0; i < rows.count(); i++) {
+                objList.append(this->record<T>(rows, i, indexes, tableName,
+                                               pkIndex));
+            }
+        } else {
+            QSharedPointer<QSqlQuery> qr = this->execute(sql,
+                                                         this->m_params);
+            if (!qr.isNull()) {
+                QVector<int> indexes = EOrmFind::columnIndexes(qr->record(),
+                                                               columns);
+                while (qr->next()) {
+                    objList.append(this->record<T>(*qr, indexes, tableName,
+                                                   pkIndex));
                 }
+                qr->finish();
             }
         }
+        if (!this->m_select.isEmpty()) {
+            EOrmActiveRecord::share(objList);
+        }
     }
     return objList;
 }
@@ -156,8 +278,10 @@ QList<T*> EOrmFind::all()
  * \lang_en
  * \brief Template function, select one object.
  *
- *  Execute generated SQL code, substitut a name of the table and primary key.
- *  It is used for select of object, return the first satisfacted to conditions.
+ *  Execute generated SQL code, substitut a name of the table and object
+ *  columns. It is used for select of object, return the first satisfacted to
+ *  conditions. If identity map is current (see EOrmIdentityMap), already
+ *  registered object is returned, the same for all() and page().
  * \return *T
  * \endlang
  *
@@ -165,31 +289,765 @@ QList<T*> EOrmFind::all()
  * \brief Шаблонная функция выборки одного объекта.
  *
  *  Запускает сформированный SQL-код на выполнение, подставляя имя таблицы и
- *  первичный ключ. Используется для выборки одного объекта, возвращая первый
- *  удовлетворяющий условиям.
+ *  столбцы объекта. Используется для выборки одного объекта, возвращая первый
+ *  удовлетворяющий условиям. Если текущая карта идентичности задана (см.
+ *  EOrmIdentityMap), возвращается уже зарегистрированный объект, так же для
+ *  all() и page().
  * \return *T
  * \endlang
  */
 template <typename T>
 T *EOrmFind::one()
 {
-    QString sql = this->m_sqlQuery.join(" ");
-    if (sql.count() > 0) {
-        T *obj = new T();
-        if (obj->inherits("EOrmActiveRecord")) {
-            QString pkName = obj->primaryKeyName();
-            QString tableName = obj->tableName();
-            delete obj;
-            if (!pkName.isEmpty() && !tableName.isEmpty()) {
-                QSqlQuery qr(sql.arg(pkName).arg(tableName), this->m_db);
-                if (qr.isActive() && qr.next()) {
-                    T *obj = new T(qr.record().value(pkName));
-                    return obj;
-                }
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        QString sql = this->selectSql(this->selectedColumns(columns, pkName),
+                                      tableName);
+        if (this->m_cacheTtl > -1) {
+            EOrmRowSet rows = this->rows(sql, tableName);
+            if (!rows.isEmpty()) {
+                return this->record<T>(rows, 0,
+                                       EOrmFind::columnIndexes(rows, columns),
+                                       tableName, columns.indexOf(pkName));
+            }
+            return new T();
+        }
+        QSharedPointer<QSqlQuery> qr = this->execute(sql, this->m_params);
+        if (!qr.isNull()) {
+            T *obj = 0;
+            if (qr->next()) {
+                obj = this->record<T>(*qr,
+                                      EOrmFind::columnIndexes(qr->record(),
+                                                              columns),
+                                      tableName, columns.indexOf(pkName));
+            }
+            qr->finish();
+            if (obj != 0) {
+                return obj;
             }
         }
     }
     return new T();
 }
 
+/*!
+ * \lang_en
+ * \brief Template function, returned object by primary key.
+ *
+ *  If identity map is current and object is registered in it, object is
+ *  returned without query. Otherwise object is loaded and registered in the
+ *  current map. Conditions of EOrmFind are not used. Returned 0 if object
+ *  can not be loaded.
+ * \param pk - primary key
+ * \return *T
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает объект по первичному ключу.
+ *
+ *  Если текущая карта идентичности задана и объект в ней зарегистрирован,
+ *  объект возвращается без запроса. Иначе объект загружается и
+ *  регистрируется в текущей карте. Условия EOrmFind не используются.
+ *  Возвращает 0, если объект не удается загрузить.
+ * \param pk - первичный ключ
+ * \return *T
+ * \endlang
+ */
+template <typename T>
+T *EOrmFind::get(const QVariant &pk)
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (!this->resolve<T>(&tableName, &pkName, &columns)) {
+        return 0;
+    }
+    T *obj = dynamic_cast<T*>(this->identity(tableName, pk));
+    if (obj != 0) {
+        return obj;
+    }
+    obj = new T();
+    if (!static_cast<EOrmActiveRecord*>(obj)->load(pk)) {
+        delete obj;
+        return 0;
+    }
+    EOrmIdentityMap *map = EOrmIdentityMap::current();
+    if (map != 0) {
+        map->attach(obj);
+    }
+    return obj;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, select objects by cursor.
+ *
+ *  The query is executed in forward-only mode, objects are filled one by one
+ *  on every step of cursor (see EOrmCursor). It is used for scanning of large
+ *  selections, so identity map is not used. Example:
+ * \code
+ *  for (Test *obj : EOrmFind::find()->cursor<Test>(true)) { ... }
+ *  EOrmCursor<Test> cursor = EOrmFind::find()->orderBy("id")->cursor<Test>();
+ *  while (cursor.next()) {
+ *      Test *obj = cursor.current();
+ *      ...
+ *      delete obj;
+ *  }
+ * \endcode
+ * \param reuse - fill the same object on every step, FALSE by default
+ * \return EOrmCursor<T>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция выборки объектов курсором.
+ *
+ *  Запрос выполняется в однонаправленном режиме, объекты заполняются по
+ *  одному на каждом шаге курсора (см. EOrmCursor). Используется для просмотра
+ *  больших выборок, поэтому карта идентичности не используется. Пример:
+ * \code
+ *  for (Test *obj : EOrmFind::find()->cursor<Test>(true)) { ... }
+ *  EOrmCursor<Test> cursor = EOrmFind::find()->orderBy("id")->cursor<Test>();
+ *  while (cursor.next()) {
+ *      Test *obj = cursor.current();
+ *      ...
+ *      delete obj;
+ *  }
+ * \endcode
+ * \param reuse - заполнять один и тот же объект на каждом шаге, FALSE
+ *  по-умолчанию
+ * \return EOrmCursor<T>
+ * \endlang
+ */
+template <typename T>
+EOrmCursor<T> EOrmFind::cursor(bool reuse)
+{
+    QSharedPointer<QSqlQuery> qr;
+    QVector<int> indexes;
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        qr = QSharedPointer<QSqlQuery>(new QSqlQuery(this->m_db));
+        qr->setForwardOnly(true);
+        QString sql = this->selectSql(this->selectedColumns(columns, pkName),
+                                      tableName);
+        // literal condition of where() is executed without preparing
+        bool ok = this->m_params.isEmpty() ? qr->exec(sql)
+                                           : qr->prepare(sql);
+        for (int i = 0; ok && i < this->m_params.count(); i++) {
+            qr->bindValue(i, this->m_params.at(i));
+        }
+        if (ok && (this->m_params.isEmpty() || qr->exec())) {
+            indexes = EOrmFind::columnIndexes(qr->record(), columns);
+        } else {
+            qr.clear();
+        }
+    }
+    return EOrmCursor<T>(qr, indexes, reuse);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, select the next page of objects by key.
+ *
+ *  Objects are sorted by key columns of token and selected after the key
+ *  remembered in token, condition of where() is applied too. Functions
+ *  orderBy() and limit() are not used. After selection token remembers key of
+ *  the last object and is marked at end if page is not full. Key columns of
+ *  token should be columns of the table and its key values should match them,
+ *  otherwise error is raised, so token received from client can not change
+ *  SQL code. See EOrmPageToken.
+ * \param token - page token
+ * \return QList<T*>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция выборки следующей страницы объектов по ключу.
+ *
+ *  Объекты сортируются по столбцам ключа маркера и выбираются после ключа,
+ *  запомненного в маркере, также применяется условие из where(). Функции
+ *  orderBy() и limit() не используются. После выборки маркер запоминает ключ
+ *  последнего объекта и отмечается в конце, если страница неполная. Столбцы
+ *  ключа маркера должны быть столбцами таблицы, а значения ключа должны им
+ *  соответствовать, иначе возникает ошибка, поэтому маркер, полученный от
+ *  клиента, не может изменить SQL-код. См. EOrmPageToken.
+ * \param token - маркер страницы
+ * \return QList<T*>
+ * \endlang
+ */
+template <typename T>
+QList<T*> EOrmFind::page(EOrmPageToken *token)
+{
+    QList<T*> objList;
+    if (token == 0 || !token->isValid() || token->atEnd()) {
+        return objList;
+    }
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        QStringList keys = token->columns();
+        foreach (QString key, keys) {
+            if (!columns.contains(key)) {
+                EOrm::throwError(50, "Page: Unknown key column");
+                return objList;
+            }
+        }
+        if (!keys.contains(pkName)) {
+            keys << pkName;
+        }
+        if (!token->isFirst() && token->values().count() != keys.count()) {
+            EOrm::throwError(55, "Page: Key of token does not match columns");
+            return objList;
+        }
+        QStringList selected = this->selectedColumns(columns, pkName);
+        foreach (QString key, keys) {
+            if (!selected.contains(key)) {
+                selected << key;
+            }
+        }
+        QSharedPointer<QSqlQuery> qr = this->execute(
+                    this->pageSql(selected, tableName, keys, *token),
+                    this->m_params + token->values());
+        if (!qr.isNull()) {
+            QVector<int> indexes = EOrmFind::columnIndexes(qr->record(),
+                                                           columns);
+            int pkIndex = columns.indexOf(pkName);
+            while (qr->next()) {
+                objList.append(this->record<T>(*qr, indexes, tableName,
+                                               pkIndex));
+            }
+            qr->finish();
+            if (!this->m_select.isEmpty()) {
+                EOrmActiveRecord::share(objList);
+            }
+            QVariantList last;
+            if (!objList.isEmpty()) {
+                foreach (QString key, keys) {
+                    last << objList.last()->value(key);
+                }
+            }
+            token->advance(keys, last, objList.count() < token->count());
+        }
+    }
+    return objList;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, select rows of values without objects.
+ *
+ *  Table and columns are taken from objects of type T, conditions are set as
+ *  for all(), including select(). Objects are not created, values are read
+ *  into EOrmRowSet.
+ * \return EOrmRowSet
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция выборки строк значений без объектов.
+ *
+ *  Таблица и столбцы берутся у объектов типа T, условия задаются как для
+ *  all(), включая select(). Объекты не создаются, значения читаются в
+ *  EOrmRowSet.
+ * \return EOrmRowSet
+ * \endlang
+ */
+template <typename T>
+EOrmRowSet EOrmFind::rows()
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        QStringList selected = this->selectedColumns(columns, pkName);
+        return this->rows(this->selectSql(selected, tableName), tableName);
+    }
+    return EOrmRowSet();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned count over objects satisfacted to
+ *  conditions, see aggregate().
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает количество по объектам,
+ *  удовлетворяющим условиям, см. aggregate().
+ * \return int
+ * \endlang
+ */
+template <typename T>
+int EOrmFind::count()
+{
+    return this->aggregate<T>("COUNT", "*").toInt();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned TRUE if there is at least one object
+ *  satisfacted to conditions.
+ *
+ *  The statement selects one row only, objects are not loaded.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает TRUE, если есть хотя бы один объект,
+ *  удовлетворяющий условиям.
+ *
+ *  Запрос выбирает только одну строку, объекты не загружаются.
+ * \return bool
+ * \endlang
+ */
+template <typename T>
+bool EOrmFind::exists()
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        return this->exists(tableName);
+    }
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned sum of the column over objects
+ *  satisfacted to conditions, see aggregate().
+ * \param column - name of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает сумму столбца по объектам,
+ *  удовлетворяющим условиям, см. aggregate().
+ * \param column - наименование столбца
+ * \return QVariant
+ * \endlang
+ */
+template <typename T>
+QVariant EOrmFind::sum(const QString &column)
+{
+    return this->aggregate<T>("SUM", column);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned minimum of the column over objects
+ *  satisfacted to conditions, see aggregate().
+ * \param column - name of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает минимум столбца по объектам,
+ *  удовлетворяющим условиям, см. aggregate().
+ * \param column - наименование столбца
+ * \return QVariant
+ * \endlang
+ */
+template <typename T>
+QVariant EOrmFind::min(const QString &column)
+{
+    return this->aggregate<T>("MIN", column);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned maximum of the column over objects
+ *  satisfacted to conditions, see aggregate().
+ * \param column - name of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает максимум столбца по объектам,
+ *  удовлетворяющим условиям, см. aggregate().
+ * \param column - наименование столбца
+ * \return QVariant
+ * \endlang
+ */
+template <typename T>
+QVariant EOrmFind::max(const QString &column)
+{
+    return this->aggregate<T>("MAX", column);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned average of the column over objects
+ *  satisfacted to conditions, see aggregate().
+ * \param column - name of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает среднее значение столбца по объектам,
+ *  удовлетворяющим условиям, см. aggregate().
+ * \param column - наименование столбца
+ * \return QVariant
+ * \endlang
+ */
+template <typename T>
+QVariant EOrmFind::avg(const QString &column)
+{
+    return this->aggregate<T>("AVG", column);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned one aggregate over objects satisfacted
+ *  to conditions.
+ *
+ *  It is used by count(), sum(), min(), max() and avg(). Execute one
+ *  statement with the aggregate function of the column and condition of
+ *  where(), objects are not loaded. Functions orderBy() and limit() are not
+ *  used. Aggregates by groups are returned by aggregate() with expression or
+ *  grouped(), so EOrmException* is thrown if groupBy() was called.
+ *  EOrmException* is also thrown if column is not a column of the table,
+ *  so SQL code can not be passed as column, or if the statement failed. NULL
+ *  is returned by sum(), min(), max() and avg() if there are no objects.
+ * \param function - name of aggregate function
+ * \param column - name of column, "*" for COUNT
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает один агрегат по объектам,
+ *  удовлетворяющим условиям.
+ *
+ *  Используется функциями count(), sum(), min(), max() и avg(). Выполняет
+ *  один запрос с агрегатной функцией столбца и условием из where(), объекты
+ *  не загружаются. Функции orderBy() и limit() не используются. Агрегаты по
+ *  группам возвращают aggregate() с выражением или grouped(), поэтому при
+ *  вызове groupBy() выбрасывается EOrmException*. EOrmException*
+ *  выбрасывается также, если column не является столбцом таблицы, поэтому
+ *  вместо столбца нельзя передать SQL-код, или при ошибке запроса. Если
+ *  объектов нет, sum(), min(), max() и avg() возвращают NULL.
+ * \param function - имя агрегатной функции
+ * \param column - наименование столбца, "*" для COUNT
+ * \return QVariant
+ * \endlang
+ */
+template <typename T>
+QVariant EOrmFind::aggregate(const QString &function, const QString &column)
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (!this->resolve<T>(&tableName, &pkName, &columns)) {
+        EOrm::throwError(53, "Aggregate: Table of objects is not resolved");
+        return QVariant();
+    }
+    bool all = (function == "COUNT" && column == "*");
+    if (!all && !columns.contains(column)) {
+        EOrm::throwError(57, "Aggregate: Unknown column");
+        return QVariant();
+    }
+    return this->scalar(tableName, function + "(" + column + ")");
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned aggregates by groups.
+ *
+ *  Execute statement SELECT with expression of groupBy(), the given
+ *  expression, condition of where(), orderBy() and limit(). Columns of
+ *  result are group columns, then aggregates. Example:
+ * \code
+ *  EOrmRowSet rows = EOrmFind::find()->where("active = 1")
+ *                                    ->groupBy("region_id")
+ *                                    ->aggregate<Test>("COUNT(*), SUM(amount)");
+ * \endcode
+ * \param sqlExpression - SQL expression of aggregates
+ * \return EOrmRowSet
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает агрегаты по группам.
+ *
+ *  Выполняет запрос SELECT с выражением из groupBy(), заданным выражением,
+ *  условием из where(), orderBy() и limit(). Столбцы результата - столбцы
+ *  группы, затем агрегаты. Пример:
+ * \code
+ *  EOrmRowSet rows = EOrmFind::find()->where("active = 1")
+ *                                    ->groupBy("region_id")
+ *                                    ->aggregate<Test>("COUNT(*), SUM(amount)");
+ * \endcode
+ * \param sqlExpression - SQL-выражение агрегатов
+ * \return EOrmRowSet
+ * \endlang
+ */
+template <typename T>
+EOrmRowSet EOrmFind::aggregate(const QString &sqlExpression)
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        return this->rows(this->aggregateSql(tableName, sqlExpression),
+                          tableName);
+    }
+    return EOrmRowSet();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned one aggregate by groups as map.
+ *
+ *  It is similar aggregate(), keys of map are values of the first group
+ *  column converted to string. Example:
+ * \code
+ *  QMap<QString, QVariant> counts = EOrmFind::find()->groupBy("status")
+ *                                                   ->grouped<Test>("COUNT(*)");
+ * \endcode
+ * \param sqlExpression - SQL expression of aggregate
+ * \return QMap<QString, QVariant>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает один агрегат по группам в виде
+ *  словаря.
+ *
+ *  Аналогична aggregate(), ключи словаря - значения первого столбца группы,
+ *  преобразованные в строку. Пример:
+ * \code
+ *  QMap<QString, QVariant> counts = EOrmFind::find()->groupBy("status")
+ *                                                   ->grouped<Test>("COUNT(*)");
+ * \endcode
+ * \param sqlExpression - SQL-выражение агрегата
+ * \return QMap<QString, QVariant>
+ * \endlang
+ */
+template <typename T>
+QMap<QString, QVariant> EOrmFind::grouped(const QString &sqlExpression)
+{
+    QMap<QString, QVariant> result;
+    EOrmRowSet rows = this->aggregate<T>(sqlExpression);
+    int column = rows.columnCount() - 1;
+    if (column > 0) {
+        for (int i = 0; i < rows.count(); i++) {
+            result.insert(rows.value(i, 0).toString(), rows.value(i, column));
+        }
+    }
+    return result;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, update all objects satisfacted to conditions.
+ *
+ *  Execute one statement UPDATE with condition of where(), objects are not
+ *  loaded. Functions orderBy() and limit() are not used. Returned count of
+ *  updated objects. Example:
+ * \code
+ *  QHash<QString, QVariant> values;
+ *  values.insert("archived", true);
+ *  int count = EOrmFind::find()->where("created < '2013-01-01'")
+ *                              ->updateAll<Test>(values);
+ * \endcode
+ * \param values - new values of columns
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция обновления всех объектов, удовлетворяющих
+ *  условиям.
+ *
+ *  Выполняет один запрос UPDATE с условием из where(), объекты не
+ *  загружаются. Функции orderBy() и limit() не используются. Возвращает
+ *  количество обновленных объектов. Пример:
+ * \code
+ *  QHash<QString, QVariant> values;
+ *  values.insert("archived", true);
+ *  int count = EOrmFind::find()->where("created < '2013-01-01'")
+ *                              ->updateAll<Test>(values);
+ * \endcode
+ * \param values - новые значения столбцов
+ * \return int
+ * \endlang
+ */
+template <typename T>
+int EOrmFind::updateAll(QHash<QString, QVariant> values)
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        return this->updateAll(tableName, columns, values);
+    }
+    return 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, delete all objects satisfacted to conditions.
+ *
+ *  Execute one statement DELETE with condition of where(), objects are not
+ *  loaded. Functions orderBy() and limit() are not used. Returned count of
+ *  deleted objects.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция удаления всех объектов, удовлетворяющих условиям.
+ *
+ *  Выполняет один запрос DELETE с условием из where(), объекты не
+ *  загружаются. Функции orderBy() и limit() не используются. Возвращает
+ *  количество удаленных объектов.
+ * \return int
+ * \endlang
+ */
+template <typename T>
+int EOrmFind::deleteAll()
+{
+    QString tableName;
+    QString pkName;
+    QStringList columns;
+    if (this->resolve<T>(&tableName, &pkName, &columns)) {
+        return this->deleteAll(tableName);
+    }
+    return 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, resolve the table of objects.
+ *
+ *  Names of the table, primary key and columns are taken from the temporary
+ *  object. Returned FALSE if query is empty or names are not defined.
+ * \param tableName - name of the table
+ * \param pkName - name of primary key
+ * \param columns - names of columns
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция определения таблицы объектов.
+ *
+ *  Имена таблицы, первичного ключа и столбцов берутся у временного объекта.
+ *  Возвращает FALSE, если запрос пустой или имена не определены.
+ * \param tableName - имя таблицы
+ * \param pkName - наименование первичного ключа
+ * \param columns - наименования столбцов
+ * \return bool
+ * \endlang
+ */
+template <typename T>
+bool EOrmFind::resolve(QString *tableName, QString *pkName,
+                       QStringList *columns)
+{
+    if (!this->m_isValid) {
+        return false;
+    }
+    T *obj = new T();
+    *tableName = obj->tableName();
+    *pkName = obj->primaryKeyName();
+    *columns = static_cast<EOrmActiveRecord*>(obj)->columns();
+    delete obj;
+    return !tableName->isEmpty() && !pkName->isEmpty();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned object of the current row of query.
+ *
+ *  If object with primary key of the row is registered in current identity
+ *  map, it is returned as is. Otherwise new object is filled from the row and
+ *  registered in current map.
+ * \param query - positioned on a valid row query
+ * \param indexes - indexes of result columns
+ * \param tableName - name of the table
+ * \param pkIndex - ordinal of primary key in object columns
+ * \return *T
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает объект текущей строки запроса.
+ *
+ *  Если объект с первичным ключом строки зарегистрирован в текущей карте
+ *  идентичности, он возвращается как есть. Иначе новый объект заполняется из
+ *  строки и регистрируется в текущей карте.
+ * \param query - запрос, спозиционированный на строке
+ * \param indexes - индексы столбцов результата
+ * \param tableName - имя таблицы
+ * \param pkIndex - порядковый номер первичного ключа в столбцах объекта
+ * \return *T
+ * \endlang
+ */
+template <typename T>
+T *EOrmFind::record(const QSqlQuery &query, const QVector<int> &indexes,
+                    const QString &tableName, int pkIndex)
+{
+    EOrmIdentityMap *map = EOrmIdentityMap::current();
+    if (map != 0 && pkIndex > -1 && indexes.value(pkIndex, -1) > -1) {
+        T *obj = dynamic_cast<T*>(this->identity(
+                                      tableName,
+                                      query.value(indexes.at(pkIndex))));
+        if (obj != 0) {
+            return obj;
+        }
+    }
+    T *obj = new T();
+    static_cast<EOrmActiveRecord*>(obj)->hydrate(query, indexes, true);
+    if (map != 0) {
+        map->attach(obj);
+    }
+    return obj;
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, returned object of the row of values.
+ *
+ *  It is similar record() for query, it is used for results taken from query
+ *  cache.
+ * \param rows - rows of values
+ * \param row - ordinal of the row
+ * \param indexes - indexes of result columns
+ * \param tableName - name of the table
+ * \param pkIndex - ordinal of primary key in object columns
+ * \return *T
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, возвращает объект строки значений.
+ *
+ *  Аналогична record() для запроса, используется для результатов, взятых из
+ *  кэша запросов.
+ * \param rows - строки значений
+ * \param row - порядковый номер строки
+ * \param indexes - индексы столбцов результата
+ * \param tableName - имя таблицы
+ * \param pkIndex - порядковый номер первичного ключа в столбцах объекта
+ * \return *T
+ * \endlang
+ */
+template <typename T>
+T *EOrmFind::record(const EOrmRowSet &rows, int row,
+                    const QVector<int> &indexes, const QString &tableName,
+                    int pkIndex)
+{
+    EOrmIdentityMap *map = EOrmIdentityMap::current();
+    if (map != 0 && pkIndex > -1 && indexes.value(pkIndex, -1) > -1) {
+        T *obj = dynamic_cast<T*>(this->identity(
+                                      tableName,
+                                      rows.value(row, indexes.at(pkIndex))));
+        if (obj != 0) {
+            return obj;
+        }
+    }
+    T *obj = new T();
+    static_cast<EOrmActiveRecord*>(obj)->hydrate(rows, row, indexes, true);
+    if (map != 0) {
+        map->attach(obj);
+    }
+    return obj;
+}
+
 #endif // EORMFIND_H
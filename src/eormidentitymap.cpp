@@ -0,0 +1,421 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormidentitymap.h"
+
+/*!
+ * \lang_en
+ * \brief Initialization of current maps of threads.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация текущих карт потоков.
+ * \endlang
+ */
+QThreadStorage<QPointer<EOrmIdentityMap> *> EOrmIdentityMap::m_current;
+
+/*!
+ * \lang_en
+ * \brief Default constructor, create empty map.
+ * \param parent - parent QObject
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Стандартный конструктор, создает пустую карту.
+ * \param parent - родительский QObject
+ * \endlang
+ */
+EOrmIdentityMap::EOrmIdentityMap(QObject *parent) :
+    QObject(parent)
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned registered object by table and primary key.
+ *
+ *  Returned 0 if object is not registered, was deleted, removed from
+ *  database by EOrmActiveRecord::remove() or expired by expire().
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \param pk - primary key
+ * \return EOrmActiveRecord*
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает зарегистрированный объект по таблице и
+ *  первичному ключу.
+ *
+ *  Возвращает 0, если объект не зарегистрирован, был удален, удален из базы
+ *  функцией EOrmActiveRecord::remove() или устарел после expire().
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \param pk - первичный ключ
+ * \return EOrmActiveRecord*
+ * \endlang
+ */
+EOrmActiveRecord *EOrmIdentityMap::lookup(QSqlDatabase db,
+                                          const QString &tableName,
+                                          const QVariant &pk)
+{
+    if (!pk.isValid() || pk.isNull()) {
+        return 0;
+    }
+    QString key = EOrmIdentityMap::key(db, tableName, pk);
+    QHash<QString, QPointer<EOrmActiveRecord> >::iterator it =
+            this->m_records.find(key);
+    if (it == this->m_records.end()) {
+        return 0;
+    }
+    EOrmActiveRecord *obj = it.value();
+    if (obj == 0 || obj->isNew()) {
+        this->m_records.erase(it);
+        return 0;
+    }
+    return obj;
+}
+
+/*!
+ * \lang_en
+ * \brief Function register object.
+ *
+ *  If other object with the same table and primary key is registered already,
+ *  it is returned and the given object is not registered. Otherwise the given
+ *  object is registered, map becomes its parent, and it is returned. New
+ *  objects are not registered.
+ * \param obj - object
+ * \return EOrmActiveRecord*
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция регистрирует объект.
+ *
+ *  Если другой объект с той же таблицей и первичным ключом уже
+ *  зарегистрирован, возвращается он, а заданный объект не регистрируется.
+ *  Иначе заданный объект регистрируется, карта становится его родителем, и он
+ *  возвращается. Новые объекты не регистрируются.
+ * \param obj - объект
+ * \return EOrmActiveRecord*
+ * \endlang
+ */
+EOrmActiveRecord *EOrmIdentityMap::attach(EOrmActiveRecord *obj)
+{
+    if (obj == 0 || obj->isNew()) {
+        return obj;
+    }
+    QVariant pk = obj->pk();
+    EOrmActiveRecord *existing = this->lookup(obj->db(), obj->tableName(), pk);
+    if (existing != 0) {
+        return existing;
+    }
+    this->m_records.insert(EOrmIdentityMap::key(obj->db(), obj->tableName(),
+                                                pk), obj);
+    obj->setParent(this);
+    return obj;
+}
+
+/*!
+ * \lang_en
+ * \brief Function unregister object, it has no parent after that.
+ * \param obj - object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция снимает объект с регистрации, после этого у него нет
+ *  родителя.
+ * \param obj - объект
+ * \endlang
+ */
+void EOrmIdentityMap::detach(EOrmActiveRecord *obj)
+{
+    if (obj == 0) {
+        return;
+    }
+    QHash<QString, QPointer<EOrmActiveRecord> >::iterator it =
+            this->m_records.begin();
+    while (it != this->m_records.end()) {
+        if (it.value() == obj) {
+            it = this->m_records.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (obj->parent() == this) {
+        obj->setParent(0);
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function expire all registered objects of the table.
+ *
+ *  It is called by EOrmFind::deleteAll(), which does not know removed rows.
+ *  Objects are not returned by lookup() any more, so the next selection
+ *  creates new objects of rows which still exist. Expired objects still
+ *  belong to the map and are deleted by clear() or with the map, because
+ *  their users may keep pointers to them.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция делает устаревшими все зарегистрированные объекты таблицы.
+ *
+ *  Вызывается функцией EOrmFind::deleteAll(), которой неизвестны удаленные
+ *  строки. Объекты больше не возвращаются функцией lookup(), поэтому
+ *  следующая выборка создает новые объекты для оставшихся строк. Устаревшие
+ *  объекты по-прежнему принадлежат карте и удаляются функцией clear() или
+ *  вместе с картой, так как их пользователи могут хранить указатели на них.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \endlang
+ */
+void EOrmIdentityMap::expire(QSqlDatabase db, const QString &tableName)
+{
+    QString prefix = EOrm::connectionKey(db) + QLatin1Char('/') + tableName
+            + QLatin1Char('/');
+    QHash<QString, QPointer<EOrmActiveRecord> >::iterator it =
+            this->m_records.begin();
+    while (it != this->m_records.end()) {
+        if (it.key().startsWith(prefix)) {
+            if (!it.value().isNull()) {
+                this->m_expired << it.value();
+            }
+            it = this->m_records.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function expire the registered object.
+ *
+ *  It is called when the object is removed from database. As for the table,
+ *  the object is not returned by lookup() any more and still belongs to the
+ *  map.
+ * \param obj - object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция делает устаревшим зарегистрированный объект.
+ *
+ *  Вызывается при удалении объекта из базы. Как и для таблицы, объект больше
+ *  не возвращается функцией lookup() и по-прежнему принадлежит карте.
+ * \param obj - объект
+ * \endlang
+ */
+void EOrmIdentityMap::expire(EOrmActiveRecord *obj)
+{
+    if (obj == 0) {
+        return;
+    }
+    bool registered = false;
+    QHash<QString, QPointer<EOrmActiveRecord> >::iterator it =
+            this->m_records.begin();
+    while (it != this->m_records.end()) {
+        if (it.value() == obj) {
+            registered = true;
+            it = this->m_records.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (registered) {
+        this->m_expired << obj;
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function mark columns of all registered objects of the table as not
+ *  loaded.
+ *
+ *  It is called by EOrmFind::updateAll(), which does not know updated rows.
+ *  Objects keep their identity, the columns are selected again at the next
+ *  reading. Changed but not saved columns of objects are kept.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \param columns - updated columns
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция отмечает столбцы всех зарегистрированных объектов таблицы
+ *  незагруженными.
+ *
+ *  Вызывается функцией EOrmFind::updateAll(), которой неизвестны обновленные
+ *  строки. Объекты сохраняют идентичность, столбцы выбираются заново при
+ *  следующем чтении. Измененные, но не сохраненные столбцы объектов
+ *  сохраняются.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \param columns - обновленные столбцы
+ * \endlang
+ */
+void EOrmIdentityMap::refresh(QSqlDatabase db, const QString &tableName,
+                              const QStringList &columns)
+{
+    QString prefix = EOrm::connectionKey(db) + QLatin1Char('/') + tableName
+            + QLatin1Char('/');
+    QHash<QString, QPointer<EOrmActiveRecord> >::iterator it =
+            this->m_records.begin();
+    for (; it != this->m_records.end(); ++it) {
+        EOrmActiveRecord *obj = it.value();
+        if (obj == 0 || !it.key().startsWith(prefix)) {
+            continue;
+        }
+        QStringList stale;
+        foreach (QString column, columns) {
+            if (!obj->isDirty(column)) {
+                stale << column;
+            }
+        }
+        obj->invalidate(stale);
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function unregister and delete all registered and expired objects.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция снимает с регистрации и удаляет все зарегистрированные и
+ *  устаревшие объекты.
+ * \endlang
+ */
+void EOrmIdentityMap::clear()
+{
+    QList<QPointer<EOrmActiveRecord> > records = this->m_records.values();
+    records << this->m_expired;
+    this->m_records.clear();
+    this->m_expired.clear();
+    foreach (QPointer<EOrmActiveRecord> obj, records) {
+        if (!obj.isNull() && obj->parent() == this) {
+            delete obj.data();
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of registered objects.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество зарегистрированных объектов.
+ * \return int
+ * \endlang
+ */
+int EOrmIdentityMap::count() const
+{
+    return this->m_records.count();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned current map of the thread or 0.
+ * \return EOrmIdentityMap*
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает текущую карту потока или 0.
+ * \return EOrmIdentityMap*
+ * \endlang
+ */
+EOrmIdentityMap *EOrmIdentityMap::current()
+{
+    if (!EOrmIdentityMap::m_current.hasLocalData()) {
+        return 0;
+    }
+    QPointer<EOrmIdentityMap> *map = EOrmIdentityMap::m_current.localData();
+    return map != 0 ? map->data() : 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set current map of the thread.
+ *
+ *  The map is not current any more after its deletion.
+ * \param map - map or 0 to turn off
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает текущую карту потока.
+ *
+ *  После удаления карта перестает быть текущей.
+ * \param map - карта или 0 для отключения
+ * \endlang
+ */
+void EOrmIdentityMap::setCurrent(EOrmIdentityMap *map)
+{
+    if (!EOrmIdentityMap::m_current.hasLocalData()) {
+        EOrmIdentityMap::m_current.setLocalData(
+                    new QPointer<EOrmIdentityMap>());
+    }
+    *EOrmIdentityMap::m_current.localData() = map;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned the key of object in map.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \param pk - primary key
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает ключ объекта в карте.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \param pk - первичный ключ
+ * \return QString
+ * \endlang
+ */
+QString EOrmIdentityMap::key(QSqlDatabase db, const QString &tableName,
+                             const QVariant &pk)
+{
+    return EOrm::connectionKey(db) + QLatin1Char('/') + tableName
+            + QLatin1Char('/') + pk.toString();
+}
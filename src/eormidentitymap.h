@@ -0,0 +1,132 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMIDENTITYMAP_H
+#define EORMIDENTITYMAP_H
+
+#include "eorm_global.h"
+#include <QObject>
+#include <QPointer>
+#include <QThreadStorage>
+#include "eormactiverecord.h"
+
+/*!
+ * \class EOrmIdentityMap
+ *
+ * \lang_en
+ * \brief Identity map, keeps one object per row of table.
+ *
+ *  Objects are registered by pair (table, primary key) of connection. While
+ *  the map is current for the thread (see setCurrent()), EOrmFind returns
+ *  already registered objects instead of creating new ones, and
+ *  EOrmFind::get() returns them without any query. Registered objects belong
+ *  to the map and are deleted with it, they must not be deleted by the caller.
+ *  Changes of a registered object are visible for all its users. Objects
+ *  removed by EOrmActiveRecord::remove() drop out of the map at the next
+ *  lookup. EOrmFind::deleteAll() expires all objects of the table in the
+ *  current map, and EOrmFind::updateAll() marks updated columns of them as
+ *  not loaded, because rows changed by one statement are not known. Other
+ *  maps are not changed. The map is not thread-safe, it should be used in one
+ *  thread, for example by one request handler. Example:
+ * \code
+ *  EOrmIdentityMap map;
+ *  EOrmIdentityMap::setCurrent(&map);
+ *  Test *a = EOrmFind::find()->get<Test>(1);
+ *  Test *b = EOrmFind::find()->where("id = 1")->one<Test>(); // a == b
+ *  EOrmIdentityMap::setCurrent(0);
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Карта идентичности, хранит один объект на строку таблицы.
+ *
+ *  Объекты регистрируются по паре (таблица, первичный ключ) соединения. Пока
+ *  карта является текущей для потока (см. setCurrent()), EOrmFind возвращает
+ *  уже зарегистрированные объекты вместо создания новых, а EOrmFind::get()
+ *  возвращает их вообще без запроса. Зарегистрированные объекты принадлежат
+ *  карте и удаляются вместе с ней, вызывающая сторона не должна их удалять.
+ *  Изменения зарегистрированного объекта видны всем его пользователям.
+ *  Объекты, удаленные функцией EOrmActiveRecord::remove(), выпадают из карты
+ *  при следующем поиске. EOrmFind::deleteAll() делает устаревшими все объекты
+ *  таблицы в текущей карте, а EOrmFind::updateAll() отмечает их обновленные
+ *  столбцы незагруженными, так как строки, измененные одним запросом,
+ *  неизвестны. Другие карты не изменяются. Карта не потокобезопасна, ее
+ *  следует использовать в одном потоке, например, в одном обработчике
+ *  запроса. Пример:
+ * \code
+ *  EOrmIdentityMap map;
+ *  EOrmIdentityMap::setCurrent(&map);
+ *  Test *a = EOrmFind::find()->get<Test>(1);
+ *  Test *b = EOrmFind::find()->where("id = 1")->one<Test>(); // a == b
+ *  EOrmIdentityMap::setCurrent(0);
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmIdentityMap : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EOrmIdentityMap(QObject *parent = 0);
+    EOrmActiveRecord *lookup(QSqlDatabase db, const QString &tableName,
+                             const QVariant &pk);
+    EOrmActiveRecord *attach(EOrmActiveRecord *obj);
+    void detach(EOrmActiveRecord *obj);
+    void expire(QSqlDatabase db, const QString &tableName);
+    void expire(EOrmActiveRecord *obj);
+    void refresh(QSqlDatabase db, const QString &tableName,
+                 const QStringList &columns);
+    void clear();
+    int count() const;
+    static EOrmIdentityMap *current();
+    static void setCurrent(EOrmIdentityMap *map);
+
+private:
+    static QString key(QSqlDatabase db, const QString &tableName,
+                       const QVariant &pk);
+
+    QHash<QString, QPointer<EOrmActiveRecord> > m_records;
+    QList<QPointer<EOrmActiveRecord> > m_expired;
+    static QThreadStorage<QPointer<EOrmIdentityMap> *> m_current;
+
+};
+
+#endif // EORMIDENTITYMAP_H
@@ -0,0 +1,360 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormmetadata.h"
+#include "eorm.h"
+
+/*!
+ * \lang_en
+ * \brief Initialization of the registry of tables metadata.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация реестра метаданных таблиц.
+ * \endlang
+ */
+QHash<QString, QSharedPointer<const EOrmTableInfo> > EOrmMetadata::m_tables;
+QReadWriteLock EOrmMetadata::m_lock;
+
+/*!
+ * \lang_en
+ * \brief Default constructor, create empty description.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Стандартный конструктор, создает пустое описание.
+ * \endlang
+ */
+EOrmTableInfo::EOrmTableInfo()
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Returned the name of the table.
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает имя таблицы.
+ * \return QString
+ * \endlang
+ */
+QString EOrmTableInfo::tableName() const
+{
+    return this->m_tableName;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned the name of primary key column as in database.
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает наименование столбца первичного ключа, как в базе.
+ * \return QString
+ * \endlang
+ */
+QString EOrmTableInfo::primaryKeyName() const
+{
+    return this->m_primaryKeyName;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned names of the table columns in database order.
+ *
+ *  The list are shared by all objects of the table.
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает наименования столбцов таблицы в порядке базы.
+ *
+ *  Список является общим для всех объектов таблицы.
+ * \return QStringList
+ * \endlang
+ */
+QStringList EOrmTableInfo::columns() const
+{
+    return this->m_columns;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of the table columns.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество столбцов таблицы.
+ * \return int
+ * \endlang
+ */
+int EOrmTableInfo::count() const
+{
+    return this->m_columns.count();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned ordinal of the column, -1 if table has no such column.
+ * \param column - name of column
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает порядковый номер столбца, -1 если такого столбца нет.
+ * \param column - наименование столбца
+ * \return int
+ * \endlang
+ */
+int EOrmTableInfo::indexOf(const QString &column) const
+{
+    return this->m_indexes.value(column, -1);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned the name of column by ordinal.
+ * \param index - ordinal of column
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает наименование столбца по порядковому номеру.
+ * \param index - порядковый номер столбца
+ * \return QString
+ * \endlang
+ */
+QString EOrmTableInfo::column(int index) const
+{
+    return this->m_columns.value(index);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if column can not accept null value.
+ * \param index - ordinal of column
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если столбец не может принимать нулевое значение.
+ * \param index - порядковый номер столбца
+ * \return bool
+ * \endlang
+ */
+bool EOrmTableInfo::isRequired(int index) const
+{
+    return this->m_required.value(index, false);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned type of column values.
+ * \param index - ordinal of column
+ * \return QVariant::Type
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает тип значений столбца.
+ * \param index - порядковый номер столбца
+ * \return QVariant::Type
+ * \endlang
+ */
+QVariant::Type EOrmTableInfo::type(int index) const
+{
+    return this->m_types.value(index, QVariant::Invalid);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned description of the table.
+ *
+ *  At first call for the pair of connection and table the description are
+ *  read from database catalog, further calls do not query database. If the
+ *  table is missing in database, null pointer is returned.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return QSharedPointer<const EOrmTableInfo>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает описание таблицы.
+ *
+ *  При первом обращении к паре соединения и таблицы описание читается из
+ *  каталога базы, последующие вызовы к базе не обращаются. Если таблица в
+ *  базе отсутствует, возвращается нулевой указатель.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return QSharedPointer<const EOrmTableInfo>
+ * \endlang
+ */
+QSharedPointer<const EOrmTableInfo> EOrmMetadata::table(
+        QSqlDatabase db, const QString &tableName)
+{
+    QString tableKey = EOrmMetadata::key(db, tableName);
+    {
+        QReadLocker locker(&EOrmMetadata::m_lock);
+        QHash<QString, QSharedPointer<const EOrmTableInfo> >::const_iterator
+                it = EOrmMetadata::m_tables.constFind(tableKey);
+        if (it != EOrmMetadata::m_tables.constEnd()) {
+            return it.value();
+        }
+    }
+    QSharedPointer<const EOrmTableInfo> info = EOrmMetadata::introspect(
+                db, tableName);
+    if (!info.isNull() && info->count() > 0) {
+        QWriteLocker locker(&EOrmMetadata::m_lock);
+        if (EOrmMetadata::m_tables.contains(tableKey)) {
+            return EOrmMetadata::m_tables.value(tableKey);
+        }
+        EOrmMetadata::m_tables.insert(tableKey, info);
+    }
+    return info;
+}
+
+/*!
+ * \lang_en
+ * \brief Function removed description of the table from registry.
+ *
+ *  It should be called after change of the table structure.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция удаляет описание таблицы из реестра.
+ *
+ *  Должна вызываться после изменения структуры таблицы.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \endlang
+ */
+void EOrmMetadata::invalidate(QSqlDatabase db, const QString &tableName)
+{
+    QWriteLocker locker(&EOrmMetadata::m_lock);
+    EOrmMetadata::m_tables.remove(EOrmMetadata::key(db, tableName));
+}
+
+/*!
+ * \lang_en
+ * \brief Function removed all descriptions from registry.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция удаляет все описания из реестра.
+ * \endlang
+ */
+void EOrmMetadata::clear()
+{
+    QWriteLocker locker(&EOrmMetadata::m_lock);
+    EOrmMetadata::m_tables.clear();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned key of the table in registry.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает ключ таблицы в реестре.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return QString
+ * \endlang
+ */
+QString EOrmMetadata::key(QSqlDatabase db, const QString &tableName)
+{
+    return EOrm::connectionKey(db) + QLatin1Char('/') + tableName;
+}
+
+/*!
+ * \lang_en
+ * \brief Function read description of the table from database catalog.
+ *
+ *  The record of the table and primary index are requested once, names of
+ *  columns are stored in database order.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return QSharedPointer<const EOrmTableInfo>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция читает описание таблицы из каталога базы данных.
+ *
+ *  Запись таблицы и первичный индекс запрашиваются один раз, наименования
+ *  столбцов хранятся в порядке базы.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return QSharedPointer<const EOrmTableInfo>
+ * \endlang
+ */
+QSharedPointer<const EOrmTableInfo> EOrmMetadata::introspect(
+        QSqlDatabase db, const QString &tableName)
+{
+    if (!db.isOpen() || db.tables().indexOf(tableName) == -1) {
+        return QSharedPointer<const EOrmTableInfo>();
+    }
+    EOrmTableInfo *info = new EOrmTableInfo();
+    info->m_tableName = tableName;
+    QSqlRecord record = db.record(tableName);
+    int fields_count = record.count();
+    info->m_required.resize(fields_count);
+    info->m_types.resize(fields_count);
+    for (int i = 0; i < fields_count; i++) {
+        QSqlField fd = record.field(i);
+        info->m_columns << fd.name();
+        info->m_indexes.insert(fd.name(), i);
+        info->m_required[i] = (fd.requiredStatus() != 0);
+        info->m_types[i] = fd.type();
+    }
+    QSqlIndex primaryIndex = db.primaryIndex(tableName);
+    if (primaryIndex.count() > 0) {
+        info->m_primaryKeyName = primaryIndex.fieldName(0);
+    }
+    return QSharedPointer<const EOrmTableInfo>(info);
+}
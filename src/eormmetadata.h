@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMMETADATA_H
+#define EORMMETADATA_H
+
+#include "eorm_global.h"
+#include <QtSql>
+
+/*!
+ * \class EOrmTableInfo
+ *
+ * \lang_en
+ * \brief Description of table columns, shared by all objects of the table.
+ *
+ *  Object are created once by EOrmMetadata and are not changed later, so it
+ *  can be read from any thread without locks.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Описание столбцов таблицы, общее для всех объектов таблицы.
+ *
+ *  Объект создается один раз в EOrmMetadata и далее не изменяется, поэтому
+ *  может читаться из любого потока без блокировок.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmTableInfo
+{
+
+public:
+    EOrmTableInfo();
+    QString tableName() const;
+    QString primaryKeyName() const;
+    QStringList columns() const;
+    int count() const;
+    int indexOf(const QString &column) const;
+    QString column(int index) const;
+    bool isRequired(int index) const;
+    QVariant::Type type(int index) const;
+
+private:
+    friend class EOrmMetadata;
+
+    QString m_tableName;
+    QString m_primaryKeyName;
+    QStringList m_columns;
+    QHash<QString, int> m_indexes;
+    QVector<bool> m_required;
+    QVector<QVariant::Type> m_types;
+
+};
+
+/*!
+ * \class EOrmMetadata
+ *
+ * \lang_en
+ * \brief The static class, process-wide registry of tables metadata.
+ *
+ *  Description of the table are read from the database catalog at first
+ *  request for pair (connection, table) and then are returned from memory.
+ *  Access to the registry are thread-safe.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статический класс, общий для процесса реестр метаданных таблиц.
+ *
+ *  Описание таблицы читается из каталога базы данных при первом обращении к
+ *  паре (соединение, таблица) и далее возвращается из памяти. Доступ к
+ *  реестру потокобезопасен.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmMetadata
+{
+
+public:
+    static QSharedPointer<const EOrmTableInfo> table(QSqlDatabase db,
+                                                     const QString &tableName);
+    static void invalidate(QSqlDatabase db, const QString &tableName);
+    static void clear();
+
+private:
+    static QString key(QSqlDatabase db, const QString &tableName);
+    static QSharedPointer<const EOrmTableInfo> introspect(
+            QSqlDatabase db, const QString &tableName);
+
+    static QHash<QString, QSharedPointer<const EOrmTableInfo> > m_tables;
+    static QReadWriteLock m_lock;
+
+};
+
+#endif // EORMMETADATA_H
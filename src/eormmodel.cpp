@@ -53,10 +53,25 @@
  * \endlang
  */
 EOrmModel::EOrmModel(QObject *parent) :
-    QAbstractItemModel(parent)
+    QAbstractItemModel(parent), m_pkColumn(-1), m_sortColumn(-1),
+    m_sortOrder(Qt::AscendingOrder), m_chunkSize(256), m_atEnd(true)
 {
 }
 
+/*!
+ * \lang_en
+ * \brief Destructor, delete objects of model.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Деструктор, удаляет объекты модели.
+ * \endlang
+ */
+EOrmModel::~EOrmModel()
+{
+    this->clearObjects();
+}
+
 /*!
  * \lang_en
  * \brief Redefine function. Create an index on a line and a column.
@@ -137,6 +152,9 @@ int EOrmModel::columnCount(const QModelIndex &parent) const
 /*!
  * \lang_en
  * \brief Redefine function. Returned cell value by index.
+ *
+ *  Value is read from values of object by column ordinal resolved in
+ *  setColumns(), so names of columns are not looked up on repaint.
  * \param index - an index
  * \param role - type of display
  * \return QVariant
@@ -144,6 +162,9 @@ int EOrmModel::columnCount(const QModelIndex &parent) const
  *
  * \lang_ru
  * \brief Переопределенная функция. Возвращает значение ячейки по индексу.
+ *
+ *  Значение читается из значений объекта по номеру столбца, определенному в
+ *  setColumns(), поэтому при перерисовке имена столбцов не ищутся.
  * \param index - индекс
  * \param role - тип отображения
  * \return QVariant
@@ -152,17 +173,157 @@ int EOrmModel::columnCount(const QModelIndex &parent) const
 QVariant EOrmModel::data(const QModelIndex &index, int role) const
 {
     if (index.isValid()) {
-        if (index.row() < this->m_objList.size()) {
-            if (role == Qt::DisplayRole) {
+        if (index.row() < this->m_objList.size()
+                && index.column() < this->m_columns.count()) {
+            if (role == Qt::DisplayRole || role == Qt::EditRole) {
                 EOrmActiveRecord *obj = this->m_objList.at(index.row());
-                return obj->property(this->m_fieldsList.at(
-                                         index.column()).toUtf8());
+                return obj->value(this->m_columns.at(index.column()));
             }
         }
     }
     return QVariant();
 }
 
+/*!
+ * \lang_en
+ * \brief Redefine function. Returned flags of cell, all columns except the
+ *  primary key are editable.
+ * \param index - an index
+ * \return Qt::ItemFlags
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Переопределенная функция. Возвращает флаги ячейки, все столбцы,
+ *  кроме первичного ключа, редактируемые.
+ * \param index - индекс
+ * \return Qt::ItemFlags
+ * \endlang
+ */
+Qt::ItemFlags EOrmModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    Qt::ItemFlags result = Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+    if (index.column() != this->m_pkColumn) {
+        result |= Qt::ItemIsEditable;
+    }
+    return result;
+}
+
+/*!
+ * \lang_en
+ * \brief Redefine function. Write the edited value of cell to object.
+ *
+ *  Column of object is marked as changed, object is remembered and is
+ *  written to database by submit() or by save() of object.
+ * \param index - an index
+ * \param value - new value
+ * \param role - type of edit, only Qt::EditRole is supported
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Переопределенная функция. Записывает отредактированное значение
+ *  ячейки в объект.
+ *
+ *  Столбец объекта отмечается как измененный, объект запоминается и
+ *  записывается в базу функцией submit() или функцией save() объекта.
+ * \param index - индекс
+ * \param value - новое значение
+ * \param role - тип редактирования, поддерживается только Qt::EditRole
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::setData(const QModelIndex &index, const QVariant &value,
+                        int role)
+{
+    if (!index.isValid() || role != Qt::EditRole
+            || index.row() >= this->m_objList.size()
+            || index.column() >= this->m_columns.count()
+            || index.column() == this->m_pkColumn) {
+        return false;
+    }
+    EOrmActiveRecord *obj = this->m_objList.at(index.row());
+    if (!obj->setValue(this->m_columns.at(index.column()), value)) {
+        return false;
+    }
+    if (!this->m_edited.contains(obj)) {
+        this->m_edited << obj;
+    }
+    emit this->dataChanged(index, index);
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Redefine function. Save objects edited by setData() to database.
+ *
+ *  It is called by view when editing of cell is finished, so only objects
+ *  edited since the last call are saved, other rows are not scanned.
+ *  Exceptions are not passed to the event loop: returned FALSE if any object
+ *  was not saved, the error is available by lastError() and the object is
+ *  saved again by the next call.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Переопределенная функция. Сохраняет в базу объекты, измененные
+ *  функцией setData().
+ *
+ *  Вызывается представлением по окончании редактирования ячейки, поэтому
+ *  сохраняются только объекты, измененные с прошлого вызова, остальные
+ *  строки не просматриваются. Исключения не передаются в цикл событий:
+ *  возвращает FALSE, если какой-либо объект не сохранен, ошибка доступна
+ *  через lastError(), и объект сохраняется повторно следующим вызовом.
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::submit()
+{
+    bool result = true;
+    this->m_lastError.clear();
+    QList<QPointer<EOrmActiveRecord> > edited = this->m_edited;
+    this->m_edited.clear();
+    foreach (QPointer<EOrmActiveRecord> obj, edited) {
+        // object could be deleted by the model after editing
+        if (obj.isNull() || !obj->isDirty()) {
+            continue;
+        }
+        try {
+            if (!obj->save(false)) {
+                this->m_lastError = "Submit: Object is not saved";
+                this->m_edited << obj;
+                result = false;
+            }
+        } catch (EOrmException *e) {
+            this->m_lastError = e->message();
+            delete e;
+            this->m_edited << obj;
+            result = false;
+        }
+    }
+    return result;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned message of the last error of submit(), empty
+ *  string if all objects were saved.
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает сообщение о последней ошибке submit(), пустую
+ *  строку, если все объекты сохранены.
+ * \return QString
+ * \endlang
+ */
+QString EOrmModel::lastError() const
+{
+    return this->m_lastError;
+}
+
 /*!
  * \lang_en
  * \brief Redefine function. Returned a column header.
@@ -190,3 +351,809 @@ QVariant EOrmModel::headerData(int section,
     }
     return QVariant();
 }
+
+/*!
+ * \lang_en
+ * \brief Redefine function. Returned TRUE if query of model has not loaded
+ *  objects.
+ * \param parent - a parent index
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Переопределенная функция. Возвращает TRUE, если у запроса модели
+ *  есть незагруженные объекты.
+ * \param parent - родительский индекс
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !this->m_source.isNull() && !this->m_atEnd;
+}
+
+/*!
+ * \lang_en
+ * \brief Redefine function. Load the next chunk of objects of query.
+ *
+ *  It is called by view when it needs more rows, rows are appended at the
+ *  end of model. Partially loaded objects of the chunk are joined, so not
+ *  loaded columns are selected once for the whole chunk. Objects of rows
+ *  which are already in the model are skipped and deleted, unless source
+ *  returned the same instance from identity map.
+ * \param parent - a parent index
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Переопределенная функция. Загружает следующую порцию объектов
+ *  запроса.
+ *
+ *  Вызывается представлением, когда ему нужно больше строк, строки
+ *  добавляются в конец модели. Частично загруженные объекты порции
+ *  объединяются, поэтому незагруженные столбцы выбираются один раз для всей
+ *  порции. Объекты строк, которые уже есть в модели, пропускаются и
+ *  удаляются, если только источник не вернул тот же экземпляр из карты
+ *  идентичности.
+ * \param parent - родительский индекс
+ * \endlang
+ */
+void EOrmModel::fetchMore(const QModelIndex &parent)
+{
+    if (!this->canFetchMore(parent)) {
+        return;
+    }
+    QList<EOrmActiveRecord*> chunk;
+    QStringList keys;
+    while (chunk.count() < this->m_chunkSize) {
+        EOrmActiveRecord *obj = this->m_source->next();
+        if (obj == 0) {
+            this->m_atEnd = true;
+            break;
+        }
+        // row could be already added by insertObject() or refresh()
+        QString objKey = this->key(obj);
+        if (!objKey.isEmpty() && (this->m_rows.contains(objKey)
+                                  || keys.contains(objKey))) {
+            // identity map returns the instance which the model holds
+            EOrmActiveRecord *held = this->m_rows.contains(objKey)
+                    ? this->m_objList.at(this->m_rows.value(objKey))
+                    : chunk.at(keys.indexOf(objKey));
+            if (obj != held) {
+                delete obj;
+            }
+            continue;
+        }
+        chunk << obj;
+        keys << objKey;
+    }
+    if (!chunk.isEmpty()) {
+        EOrmActiveRecord::share(chunk);
+        int first = this->m_objList.count();
+        this->beginInsertRows(QModelIndex(), first,
+                              first + chunk.count() - 1);
+        this->m_objList << chunk;
+        for (int i = 0; i < keys.count(); i++) {
+            if (!keys.at(i).isEmpty()) {
+                this->m_rows.insert(keys.at(i), first + i);
+            }
+        }
+        this->endInsertRows();
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned count of objects loaded by one fetchMore().
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает количество объектов, загружаемых одним вызовом
+ *  fetchMore().
+ * \return int
+ * \endlang
+ */
+int EOrmModel::chunkSize() const
+{
+    return this->m_chunkSize;
+}
+
+/*!
+ * \lang_en
+ * \brief Function set count of objects loaded by one fetchMore().
+ * \param chunkSize - count of objects
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция устанавливает количество объектов, загружаемых одним
+ *  вызовом fetchMore().
+ * \param chunkSize - количество объектов
+ * \endlang
+ */
+void EOrmModel::setChunkSize(int chunkSize)
+{
+    this->m_chunkSize = qMax(1, chunkSize);
+}
+
+/*!
+ * \lang_en
+ * \brief Redefine function. Sort model by column.
+ *
+ *  If model is bound to query, ORDER BY of query is replaced by column, the
+ *  primary key is added for stable order, and objects are reloaded, so
+ *  indexes of database are used and objects are not sorted in memory.
+ *  Otherwise nothing is done.
+ * \param column - column number
+ * \param order - sort order
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Переопределенная функция. Сортирует модель по столбцу.
+ *
+ *  Если модель связана с запросом, ORDER BY запроса заменяется столбцом,
+ *  для устойчивого порядка добавляется первичный ключ, и объекты
+ *  перезагружаются, поэтому используются индексы базы, а объекты не
+ *  сортируются в памяти. Иначе ничего не выполняется.
+ * \param column - номер столбца
+ * \param order - порядок сортировки
+ * \endlang
+ */
+void EOrmModel::sort(int column, Qt::SortOrder order)
+{
+    if (this->m_query.isNull() || column >= this->m_fieldsList.count()) {
+        return;
+    }
+    this->m_sortColumn = column;
+    this->m_sortOrder = order;
+    this->select();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned SQL expression of filter of model.
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает SQL-выражение фильтра модели.
+ * \return QString
+ * \endlang
+ */
+QString EOrmModel::filter() const
+{
+    return this->m_filter;
+}
+
+/*!
+ * \lang_en
+ * \brief Function set filter of model and reload objects.
+ *
+ *  Filter is SQL expression with placeholders "?", as in EOrmFind::where().
+ *  It is added to WHERE of query by AND, so rows are filtered by database.
+ *  Empty expression removes filter. Returned FALSE if model is not bound to
+ *  query or expression is invalid. Example:
+ * \code
+ *  model->setFilter("name LIKE ?", QVariantList() << "Vic%");
+ * \endcode
+ * \param sqlExpression - SQL expression with placeholders
+ * \param params - bound values
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция устанавливает фильтр модели и перезагружает объекты.
+ *
+ *  Фильтр - это SQL-выражение с плейсхолдерами "?", как в
+ *  EOrmFind::where(). Он добавляется к WHERE запроса через AND, поэтому
+ *  строки фильтруются базой. Пустое выражение удаляет фильтр. Возвращает
+ *  FALSE, если модель не связана с запросом или выражение неверно. Пример:
+ * \code
+ *  model->setFilter("name LIKE ?", QVariantList() << "Vic%");
+ * \endcode
+ * \param sqlExpression - SQL-выражение с плейсхолдерами
+ * \param params - значения параметров
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::setFilter(const QString &sqlExpression,
+                          const QVariantList &params)
+{
+    if (this->m_query.isNull()) {
+        return false;
+    }
+    EOrmFind find(this->m_query->m_db);
+    if (sqlExpression.isEmpty()) {
+        return this->applyFilter(&find, &find);
+    }
+    return this->applyFilter(&find, find.where(sqlExpression, params));
+}
+
+/*!
+ * \lang_en
+ * \brief Function set filter of model with named bound values and reload
+ *  objects.
+ *
+ *  It is similar setFilter() with list of values, placeholders are named as
+ *  in EOrmFind::where() with map of values.
+ * \param sqlExpression - SQL expression with named placeholders
+ * \param params - bound values by names
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция устанавливает фильтр модели с именованными параметрами и
+ *  перезагружает объекты.
+ *
+ *  Аналогична setFilter() со списком значений, плейсхолдеры именуются как в
+ *  EOrmFind::where() со словарем значений.
+ * \param sqlExpression - SQL-выражение с именованными плейсхолдерами
+ * \param params - значения параметров по именам
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::setFilter(const QString &sqlExpression,
+                          const QVariantMap &params)
+{
+    if (this->m_query.isNull()) {
+        return false;
+    }
+    EOrmFind find(this->m_query->m_db);
+    if (sqlExpression.isEmpty()) {
+        return this->applyFilter(&find, &find);
+    }
+    return this->applyFilter(&find, find.where(sqlExpression, params));
+}
+
+/*!
+ * \lang_en
+ * \brief Function execute query of model again with current filter and
+ *  sorting.
+ *
+ *  Model is reset, then as many objects as were loaded are read again, so
+ *  visible rows of view remain filled. Returned FALSE if model is not bound
+ *  to query.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция повторно выполняет запрос модели с текущими фильтром и
+ *  сортировкой.
+ *
+ *  Модель сбрасывается, затем заново читается столько объектов, сколько
+ *  было загружено, поэтому видимые строки представления остаются
+ *  заполненными. Возвращает FALSE, если модель не связана с запросом.
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::select()
+{
+    if (this->m_query.isNull() || this->m_source.isNull()) {
+        return false;
+    }
+    int loaded = this->m_objList.count();
+    this->setSource(this->m_source->clone(this->query()));
+    while (this->m_objList.count() < loaded
+           && this->canFetchMore(QModelIndex())) {
+        this->fetchMore(QModelIndex());
+    }
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned row of object with primary key or -1.
+ * \param primaryKey - value of primary key
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает строку объекта с первичным ключом либо -1.
+ * \param primaryKey - значение первичного ключа
+ * \return int
+ * \endlang
+ */
+int EOrmModel::row(const QVariant &primaryKey) const
+{
+    if (primaryKey.isNull()) {
+        return -1;
+    }
+    return this->m_rows.value(primaryKey.toString(), -1);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned object of row or 0.
+ * \param row - row number
+ * \return *EOrmActiveRecord
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает объект строки либо 0.
+ * \param row - номер строки
+ * \return *EOrmActiveRecord
+ * \endlang
+ */
+EOrmActiveRecord *EOrmModel::object(int row) const
+{
+    if (row < 0 || row >= this->m_objList.count()) {
+        return 0;
+    }
+    return this->m_objList.at(row);
+}
+
+/*!
+ * \lang_en
+ * \brief Function append row of object.
+ *
+ *  If model already has row with primary key of object, the row is updated
+ *  instead (see updateObject()). Model takes ownership of object.
+ * \param obj - object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция добавляет строку объекта.
+ *
+ *  Если в модели уже есть строка с первичным ключом объекта, вместо этого
+ *  строка обновляется (см. updateObject()). Модель становится владельцем
+ *  объекта.
+ * \param obj - объект
+ * \endlang
+ */
+void EOrmModel::insertObject(EOrmActiveRecord *obj)
+{
+    if (obj == 0 || this->updateObject(obj)) {
+        return;
+    }
+    if (this->m_fieldsList.isEmpty()) {
+        this->beginResetModel();
+        this->setColumns(obj);
+        this->m_objList << obj;
+        this->reindex();
+        this->endResetModel();
+        return;
+    }
+    int row = this->m_objList.count();
+    this->beginInsertRows(QModelIndex(), row, row);
+    this->m_objList << obj;
+    QString objKey = this->key(obj);
+    if (!objKey.isEmpty()) {
+        this->m_rows.insert(objKey, row);
+    }
+    this->endInsertRows();
+}
+
+/*!
+ * \lang_en
+ * \brief Function update row of object with the same primary key.
+ *
+ *  Object of row is replaced by given one and deleted, model takes ownership
+ *  of given object. View repaints only this row. Returned FALSE if model has
+ *  no row with primary key of object, then ownership is not taken.
+ * \param obj - object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция обновляет строку объекта с тем же первичным ключом.
+ *
+ *  Объект строки заменяется переданным и уничтожается, модель становится
+ *  владельцем переданного объекта. Представление перерисовывает только эту
+ *  строку. Возвращает FALSE, если в модели нет строки с первичным ключом
+ *  объекта, тогда владение не передается.
+ * \param obj - объект
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::updateObject(EOrmActiveRecord *obj)
+{
+    if (obj == 0) {
+        return false;
+    }
+    QString objKey = this->key(obj);
+    int row = objKey.isEmpty() ? this->m_objList.indexOf(obj)
+                               : this->m_rows.value(objKey, -1);
+    if (row < 0) {
+        return false;
+    }
+    EOrmActiveRecord *old = this->m_objList.at(row);
+    if (old != obj) {
+        this->m_objList[row] = obj;
+        delete old;
+    }
+    emit this->dataChanged(this->index(row, 0, QModelIndex()),
+                           this->index(row, this->columnCount() - 1,
+                                       QModelIndex()));
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function remove row of object.
+ *
+ *  Row is found by pointer, then by primary key, so object removed from
+ *  database is accepted too. Object of the row is deleted, so if it is the
+ *  given object, it should not be used after the call. Given object which is
+ *  not shown by the model stays owned by the caller. Returned FALSE if model
+ *  has no such row.
+ * \param obj - object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция удаляет строку объекта.
+ *
+ *  Строка ищется по указателю, затем по первичному ключу, поэтому
+ *  допускается и объект, удаленный из базы. Объект строки уничтожается,
+ *  поэтому, если это переданный объект, его нельзя использовать после
+ *  вызова. Переданный объект, который не показывается моделью, остается во
+ *  владении вызывающей стороны. Возвращает FALSE, если в модели нет такой
+ *  строки.
+ * \param obj - объект
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::removeObject(EOrmActiveRecord *obj)
+{
+    if (obj == 0) {
+        return false;
+    }
+    int row = this->m_objList.indexOf(obj);
+    if (row < 0) {
+        row = this->m_rows.value(this->key(obj), -1);
+    }
+    if (row < 0) {
+        return false;
+    }
+    this->beginRemoveRows(QModelIndex(), row, row);
+    delete this->m_objList.takeAt(row);
+    this->reindex();
+    this->endRemoveRows();
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function replace source of objects and reset model.
+ *
+ *  Columns are determined by empty object of source. Objects are loaded
+ *  later by fetchMore().
+ * \param source - source of objects, 0 to unbind query
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция заменяет источник объектов и сбрасывает модель.
+ *
+ *  Столбцы определяются по пустому объекту источника. Объекты загружаются
+ *  позднее функцией fetchMore().
+ * \param source - источник объектов, 0 для отвязки запроса
+ * \endlang
+ */
+void EOrmModel::setSource(EOrmModelSource *source)
+{
+    this->beginResetModel();
+    this->clearObjects();
+    this->m_source = QSharedPointer<EOrmModelSource>(source);
+    this->m_atEnd = (source == 0);
+    if (source != 0) {
+        EOrmActiveRecord *obj = source->create();
+        this->setColumns(obj);
+        delete obj;
+    } else {
+        this->setColumns(0);
+    }
+    this->endResetModel();
+}
+
+/*!
+ * \lang_en
+ * \brief Function determine columns of model by object.
+ *
+ *  The primary key is the first, other columns follow in order of table.
+ *  Ordinals of columns in values of object are resolved once here and are
+ *  used by data() and setData().
+ * \param obj - object, 0 to remove columns
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция определяет столбцы модели по объекту.
+ *
+ *  Первичный ключ первый, остальные столбцы следуют в порядке таблицы.
+ *  Номера столбцов в значениях объекта определяются здесь один раз и
+ *  используются функциями data() и setData().
+ * \param obj - объект, 0 для удаления столбцов
+ * \endlang
+ */
+void EOrmModel::setColumns(EOrmActiveRecord *obj)
+{
+    this->m_fieldsList.clear();
+    this->m_columns.clear();
+    this->m_pkColumn = -1;
+    if (obj == 0) {
+        return;
+    }
+    QStringList columns = obj->columns();
+    int pkIndex = columns.indexOf(obj->primaryKeyName());
+    if (pkIndex > -1) {
+        this->m_pkColumn = 0;
+        this->m_fieldsList << columns.at(pkIndex);
+        this->m_columns << pkIndex;
+    }
+    for (int i = 0; i < columns.count(); i++) {
+        if (i != pkIndex) {
+            this->m_fieldsList << columns.at(i);
+            this->m_columns << i;
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function remove and delete objects of model.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция удаляет из модели и уничтожает ее объекты.
+ * \endlang
+ */
+void EOrmModel::clearObjects()
+{
+    qDeleteAll(this->m_objList);
+    this->m_objList.clear();
+    this->m_rows.clear();
+}
+
+/*!
+ * \lang_en
+ * \brief Function apply refreshed list of objects to model by primary keys,
+ *  it is called by refresh().
+ *
+ *  Removed rows are signalled by contiguous ranges, changed rows by
+ *  dataChanged(), new objects are appended by one insertion.
+ * \param objList - refreshed list of objects
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция применяет к модели обновленный список объектов по
+ *  первичным ключам, вызывается функцией refresh().
+ *
+ *  Об удаленных строках сообщается непрерывными диапазонами, об измененных
+ *  строках сигналом dataChanged(), новые объекты добавляются одной вставкой.
+ * \param objList - обновленный список объектов
+ * \endlang
+ */
+void EOrmModel::merge(QList<EOrmActiveRecord*> objList)
+{
+    if (this->m_fieldsList.isEmpty()) {
+        if (objList.isEmpty()) {
+            return;
+        }
+        this->beginResetModel();
+        this->clearObjects();
+        this->setColumns(objList.first());
+        this->m_objList = objList;
+        this->reindex();
+        this->endResetModel();
+        return;
+    }
+    QHash<QString, EOrmActiveRecord*> fresh;
+    QSet<EOrmActiveRecord*> incoming;
+    foreach (EOrmActiveRecord *obj, objList) {
+        QString objKey = this->key(obj);
+        if (!objKey.isEmpty()) {
+            fresh.insert(objKey, obj);
+        }
+        incoming << obj;
+    }
+    // removed rows, from the end by contiguous ranges
+    int row = this->m_objList.count() - 1;
+    while (row >= 0) {
+        if (fresh.contains(this->key(this->m_objList.at(row)))) {
+            row--;
+            continue;
+        }
+        int last = row;
+        while (row > 0
+               && !fresh.contains(this->key(this->m_objList.at(row - 1)))) {
+            row--;
+        }
+        this->beginRemoveRows(QModelIndex(), row, last);
+        for (int i = last; i >= row; i--) {
+            // object of the list could change its primary key
+            EOrmActiveRecord *old = this->m_objList.takeAt(i);
+            if (!incoming.contains(old)) {
+                delete old;
+            }
+        }
+        this->reindex();
+        this->endRemoveRows();
+        row--;
+    }
+    // changed rows
+    QSet<EOrmActiveRecord*> kept;
+    for (int i = 0; i < this->m_objList.count(); i++) {
+        EOrmActiveRecord *old = this->m_objList.at(i);
+        EOrmActiveRecord *obj = fresh.take(this->key(old));
+        if (obj == 0) {
+            continue;
+        }
+        kept << obj;
+        if (obj == old) {
+            continue;
+        }
+        bool changed = !this->isEqual(old, obj);
+        this->m_objList[i] = obj;
+        delete old;
+        if (changed) {
+            emit this->dataChanged(this->index(i, 0, QModelIndex()),
+                                   this->index(i, this->columnCount() - 1,
+                                               QModelIndex()));
+        }
+    }
+    // new rows
+    QList<EOrmActiveRecord*> added;
+    foreach (EOrmActiveRecord *obj, objList) {
+        QString objKey = this->key(obj);
+        if (objKey.isEmpty() || fresh.value(objKey) == obj) {
+            fresh.remove(objKey);
+            added << obj;
+            kept << obj;
+        }
+    }
+    if (!added.isEmpty()) {
+        int first = this->m_objList.count();
+        this->beginInsertRows(QModelIndex(), first,
+                              first + added.count() - 1);
+        this->m_objList << added;
+        this->reindex();
+        this->endInsertRows();
+    }
+    // duplicates of primary key are not shown
+    foreach (EOrmActiveRecord *obj, objList) {
+        if (!kept.contains(obj)) {
+            kept << obj;
+            delete obj;
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function rebuild hash of rows by primary keys.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция перестраивает хеш строк по первичным ключам.
+ * \endlang
+ */
+void EOrmModel::reindex()
+{
+    this->m_rows.clear();
+    for (int i = 0; i < this->m_objList.count(); i++) {
+        QString objKey = this->key(this->m_objList.at(i));
+        if (!objKey.isEmpty()) {
+            this->m_rows.insert(objKey, i);
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned primary key of object as key of hash of rows,
+ *  empty string if object has no primary key.
+ * \param obj - object
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает первичный ключ объекта как ключ хеша строк,
+ *  пустую строку, если у объекта нет первичного ключа.
+ * \param obj - объект
+ * \return QString
+ * \endlang
+ */
+QString EOrmModel::key(EOrmActiveRecord *obj) const
+{
+    if (this->m_pkColumn < 0) {
+        return QString();
+    }
+    QVariant value = obj->value(this->m_columns.at(this->m_pkColumn));
+    if (value.isNull()) {
+        return QString();
+    }
+    return value.toString();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned TRUE if values of columns of model are equal for
+ *  both objects.
+ * \param obj - object
+ * \param other - other object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает TRUE, если значения столбцов модели у обоих
+ *  объектов равны.
+ * \param obj - объект
+ * \param other - другой объект
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::isEqual(EOrmActiveRecord *obj, EOrmActiveRecord *other) const
+{
+    foreach (int column, this->m_columns) {
+        if (obj->value(column) != other->value(column)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function take filter from checked find and reload objects.
+ * \param find - find used to check expression of filter
+ * \param result - result of where() of find, other object on error
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция берет фильтр из проверенного find и перезагружает объекты.
+ * \param find - find, использованный для проверки выражения фильтра
+ * \param result - результат where() у find, другой объект при ошибке
+ * \return bool
+ * \endlang
+ */
+bool EOrmModel::applyFilter(EOrmFind *find, EOrmFind *result)
+{
+    if (result != find) {
+        delete result;
+        return false;
+    }
+    this->m_filter = find->m_where;
+    this->m_filterParams = find->m_params;
+    return this->select();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned new query of model, conditions of bound query
+ *  with filter and sorting of model.
+ * \return *EOrmFind
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает новый запрос модели, условия связанного
+ *  запроса с фильтром и сортировкой модели.
+ * \return *EOrmFind
+ * \endlang
+ */
+EOrmFind *EOrmModel::query() const
+{
+    EOrmFind *find = this->m_query->clone(this->m_query->m_db);
+    if (!this->m_filter.isEmpty()) {
+        if (find->m_where.isEmpty()) {
+            find->m_where = this->m_filter;
+        } else {
+            find->m_where = "(" + find->m_where + ") AND ("
+                    + this->m_filter + ")";
+        }
+        find->m_params << this->m_filterParams;
+    }
+    if (this->m_sortColumn > -1
+            && this->m_sortColumn < this->m_fieldsList.count()) {
+        QString direction;
+        if (this->m_sortOrder == Qt::DescendingOrder) {
+            direction = " DESC";
+        }
+        QString orderBy = this->m_fieldsList.at(this->m_sortColumn)
+                + direction;
+        if (this->m_pkColumn > -1 && this->m_pkColumn != this->m_sortColumn) {
+            orderBy += ", " + this->m_fieldsList.at(this->m_pkColumn)
+                    + direction;
+        }
+        find->m_orderBy = orderBy;
+    }
+    return find;
+}
@@ -44,6 +44,135 @@
 
 #include "eorm_global.h"
 #include "eormactiverecord.h"
+#include "eormfind.h"
+
+/*!
+ * \class EOrmModelSource
+ *
+ * \lang_en
+ * \brief The abstract class, source of objects of EOrmModel.
+ *
+ *  It hides type of objects, so EOrmModel loads objects of any type by
+ *  chunks.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Абстрактный класс, источник объектов EOrmModel.
+ *
+ *  Скрывает тип объектов, поэтому EOrmModel загружает объекты любого типа
+ *  порциями.
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmModelSource
+{
+
+public:
+    virtual ~EOrmModelSource() {}
+    /*!
+     * \lang_en
+     * \brief Pure virtual function which should return the next object or 0
+     *  at the end of selection.
+     * \return *EOrmActiveRecord
+     * \endlang
+     *
+     * \lang_ru
+     * \brief Чистая виртуальная функция, которая должна возвращать следующий
+     *  объект либо 0 в конце выборки.
+     * \return *EOrmActiveRecord
+     * \endlang
+     */
+    virtual EOrmActiveRecord *next() =0;
+    /*!
+     * \lang_en
+     * \brief Pure virtual function which should return new empty object,
+     *  it is used to determine columns.
+     * \return *EOrmActiveRecord
+     * \endlang
+     *
+     * \lang_ru
+     * \brief Чистая виртуальная функция, которая должна возвращать новый
+     *  пустой объект, используется для определения столбцов.
+     * \return *EOrmActiveRecord
+     * \endlang
+     */
+    virtual EOrmActiveRecord *create() const =0;
+    /*!
+     * \lang_en
+     * \brief Pure virtual function which should return new source of the
+     *  same type of objects reading given query, it is used to reload model.
+     * \param find - conditions of selection, source takes ownership
+     * \return *EOrmModelSource
+     * \endlang
+     *
+     * \lang_ru
+     * \brief Чистая виртуальная функция, которая должна возвращать новый
+     *  источник объектов того же типа, читающий переданный запрос,
+     *  используется для перезагрузки модели.
+     * \param find - условия выборки, источник становится владельцем
+     * \return *EOrmModelSource
+     * \endlang
+     */
+    virtual EOrmModelSource *clone(EOrmFind *find) const =0;
+
+};
+
+/*!
+ * \class EOrmModelCursor
+ *
+ * \lang_en
+ * \brief The template class, source of EOrmModel reading objects by cursor
+ *  of EOrmFind.
+ *
+ *  Objects are selected by pages of chunkSize rows with EOrmFind::page(),
+ *  the first page is selected at the first request of object. Every page
+ *  continues after the key of the last object of the previous one, so its
+ *  cost does not grow with the count of loaded rows as with OFFSET. Keys are
+ *  columns of orderBy() followed by primary key, or primary key without
+ *  orderBy(); orderBy() should be a list of columns sorted in one direction,
+ *  otherwise error is raised. limit() of the query is kept, its offset() is
+ *  not used. Every page is read to the end, so no statement stays open on
+ *  the connection between fetchMore() calls: SQLite writers are not blocked
+ *  by an unfinished read, QPSQL driver buffers only one page instead of the
+ *  whole result.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонный класс, источник EOrmModel, читающий объекты курсором
+ *  EOrmFind.
+ *
+ *  Объекты выбираются страницами по chunkSize строк функцией
+ *  EOrmFind::page(), первая страница выбирается при первом запросе объекта.
+ *  Каждая страница продолжается после ключа последнего объекта предыдущей,
+ *  поэтому ее стоимость не растет с количеством загруженных строк, как с
+ *  OFFSET. Ключ составляют столбцы orderBy() и первичный ключ, или первичный
+ *  ключ без orderBy(); orderBy() должна быть списком столбцов, сортируемых в
+ *  одном направлении, иначе возникает ошибка. limit() запроса сохраняется,
+ *  его offset() не используется. Каждая страница читается до конца, поэтому
+ *  между вызовами fetchMore() на соединении не остается открытых запросов:
+ *  незавершенное чтение не блокирует запись в SQLite, драйвер QPSQL
+ *  буферизует только одну страницу вместо всего результата.
+ * \endlang
+ */
+template <typename T>
+class EOrmModelCursor : public EOrmModelSource
+{
+
+public:
+    explicit EOrmModelCursor(EOrmFind *find, int chunkSize = 256);
+    ~EOrmModelCursor();
+    EOrmActiveRecord *next();
+    EOrmActiveRecord *create() const;
+    EOrmModelSource *clone(EOrmFind *find) const;
+
+private:
+    QSharedPointer<EOrmFind> m_find;
+    EOrmPageToken m_token;
+    QList<T*> m_window;
+    int m_chunkSize;
+    int m_remaining;
+    bool m_atEnd;
+
+};
 
 /*!
  * \class EOrmModel
@@ -59,6 +188,22 @@
  *  EOrmModel *model = new EOrmModel;
  *  model->setData(lst);
  * \endcode
+ *  Cells are editable except the primary key, objects edited by setData()
+ *  are written to database by submit().
+ *  Model can be bound to query by setQuery(), then objects are loaded by
+ *  chunks while view is scrolled (see fetchMore()):
+ * \code
+ *  model->setQuery<Test>(EOrmFind::find()->orderBy("name"), 500);
+ * \endcode
+ *  Sorting by sort() and filtering by setFilter() of such model are executed
+ *  by database: the query is rewritten and loaded objects are reloaded.
+ *
+ *  Model owns every object it shows, however it was added: by setData(),
+ *  setQuery(), insertObject(), updateObject() or refresh(). Objects are
+ *  deleted by the model when their rows are removed or replaced, when model
+ *  is reset and when it is destroyed. So objects passed to the model should
+ *  not be deleted by the caller, and pointers returned by object() are valid
+ *  only while their rows are shown.
  * \endlang
  *
  * \lang_ru
@@ -72,6 +217,23 @@
  *  EOrmModel *model = new EOrmModel;
  *  model->setData(lst);
  * \endcode
+ *  Ячейки редактируемые, кроме первичного ключа, объекты, измененные
+ *  функцией setData(), записываются в базу функцией submit().
+ *  Модель можно связать с запросом функцией setQuery(), тогда объекты
+ *  загружаются порциями по мере прокрутки представления (см. fetchMore()):
+ * \code
+ *  model->setQuery<Test>(EOrmFind::find()->orderBy("name"), 500);
+ * \endcode
+ *  Сортировка функцией sort() и фильтрация функцией setFilter() такой
+ *  модели выполняются базой: запрос переписывается, и загруженные объекты
+ *  перезагружаются.
+ *
+ *  Модель владеет каждым показываемым объектом, как бы он ни был добавлен:
+ *  функциями setData(), setQuery(), insertObject(), updateObject() или
+ *  refresh(). Объекты уничтожаются моделью при удалении или замене их строк,
+ *  при сбросе модели и при ее уничтожении. Поэтому переданные модели объекты
+ *  не должны удаляться вызывающей стороной, а указатели, возвращаемые
+ *  object(), действительны только пока показываются их строки.
  * \endlang
  */
 class EORMSHARED_EXPORT EOrmModel : public QAbstractItemModel
@@ -80,43 +242,313 @@ class EORMSHARED_EXPORT EOrmModel : public QAbstractItemModel
 
 public:
     explicit EOrmModel(QObject *parent = 0);
+    ~EOrmModel();
     QModelIndex index(int row, int column, const QModelIndex &parent) const;
     QModelIndex parent(const QModelIndex &child) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+    bool setData(const QModelIndex &index, const QVariant &value,
+                 int role = Qt::EditRole);
+    bool submit();
+    QString lastError() const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
     template <typename T>
     void setData(QList<T*> objList);
+    template <typename T>
+    void setQuery(EOrmFind *find, int chunkSize = 256);
+    int chunkSize() const;
+    void setChunkSize(int chunkSize);
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+    QString filter() const;
+    bool setFilter(const QString &sqlExpression,
+                   const QVariantList &params = QVariantList());
+    bool setFilter(const QString &sqlExpression, const QVariantMap &params);
+    bool select();
+    int row(const QVariant &primaryKey) const;
+    EOrmActiveRecord *object(int row) const;
+    void insertObject(EOrmActiveRecord *obj);
+    bool updateObject(EOrmActiveRecord *obj);
+    bool removeObject(EOrmActiveRecord *obj);
+    template <typename T>
+    void refresh(QList<T*> objList);
 
 private:
+    void setSource(EOrmModelSource *source);
+    bool applyFilter(EOrmFind *find, EOrmFind *result);
+    EOrmFind *query() const;
+    void setColumns(EOrmActiveRecord *obj);
+    void clearObjects();
+    void merge(QList<EOrmActiveRecord*> objList);
+    void reindex();
+    QString key(EOrmActiveRecord *obj) const;
+    bool isEqual(EOrmActiveRecord *obj, EOrmActiveRecord *other) const;
+
     QList<EOrmActiveRecord*> m_objList;
     QList<QString> m_fieldsList;
+    QVector<int> m_columns;
+    int m_pkColumn;
+    QHash<QString, int> m_rows;
+    QSharedPointer<EOrmModelSource> m_source;
+    QSharedPointer<EOrmFind> m_query;
+    QString m_filter;
+    QVariantList m_filterParams;
+    int m_sortColumn;
+    Qt::SortOrder m_sortOrder;
+    int m_chunkSize;
+    bool m_atEnd;
+    QList<QPointer<EOrmActiveRecord> > m_edited;
+    QString m_lastError;
 
 };
 
 /*!
  * \lang_en
  * \brief Template function for loading of the object list in model for display
+ *
+ *  Previous objects and query of model are replaced, previous objects absent
+ *  in the list are deleted. Model takes ownership of objects of the list.
  * \endlang
  *
  * \lang_ru
  * \brief Шаблонная функция загрузки списка объектов в модель для отображения
+ *
+ *  Прежние объекты и запрос модели заменяются, прежние объекты, отсутствующие
+ *  в списке, уничтожаются. Модель становится владельцем объектов списка.
  * \endlang
  */
 template <typename T>
 void EOrmModel::setData(QList<T*> objList)
 {
-    T *firstObj = objList.at(0);
-    this->m_objList << firstObj;
-    this->m_fieldsList = firstObj->properties().keys();
-    this->m_fieldsList.removeAt(this->m_fieldsList.indexOf(firstObj->
-                                                           primaryKeyName()));
-    this->m_fieldsList.prepend(firstObj->primaryKeyName());
-    for (int i = 1; i < objList.count(); i++) {
-        T * obj = objList.at(i);
-        this->m_objList << obj;
+    this->beginResetModel();
+    QSet<EOrmActiveRecord*> kept;
+    for (int i = 0; i < objList.count(); i++) {
+        kept << objList.at(i);
+    }
+    foreach (EOrmActiveRecord *old, this->m_objList) {
+        if (!kept.contains(old)) {
+            delete old;
+        }
+    }
+    this->m_objList.clear();
+    this->m_rows.clear();
+    this->m_source.clear();
+    this->m_query.clear();
+    this->m_atEnd = true;
+    this->setColumns(0);
+    if (!objList.isEmpty()) {
+        this->setColumns(objList.first());
+        for (int i = 0; i < objList.count(); i++) {
+            T * obj = objList.at(i);
+            this->m_objList << obj;
+        }
+    }
+    this->reindex();
+    this->endResetModel();
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, apply refreshed list of objects to model.
+ *
+ *  Objects are matched with rows by primary key: rows absent in the list are
+ *  removed, changed rows are replaced in place, new objects are appended.
+ *  Only affected rows are signalled, so view keeps selection and scroll
+ *  position. Order of existing rows is kept. Model takes ownership of objects
+ *  of the list: replaced and removed objects and duplicates of primary key
+ *  are deleted.
+ * \param objList - refreshed list of objects
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, применяет к модели обновленный список объектов.
+ *
+ *  Объекты сопоставляются со строками по первичному ключу: строки,
+ *  отсутствующие в списке, удаляются, измененные строки заменяются на месте,
+ *  новые объекты добавляются в конец. Сигналы отправляются только для
+ *  затронутых строк, поэтому представление сохраняет выделение и позицию
+ *  прокрутки. Порядок существующих строк сохраняется. Модель становится
+ *  владельцем объектов списка: замененные и удаленные объекты, а также
+ *  дубликаты первичного ключа уничтожаются.
+ * \param objList - обновленный список объектов
+ * \endlang
+ */
+template <typename T>
+void EOrmModel::refresh(QList<T*> objList)
+{
+    QList<EOrmActiveRecord*> list;
+    for (int i = 0; i < objList.count(); i++) {
+        list << objList.at(i);
     }
+    this->merge(list);
+}
+
+/*!
+ * \lang_en
+ * \brief Template function, bind model to query.
+ *
+ *  Model takes ownership of find and of loaded objects. Objects are not
+ *  loaded at once: view requests them by fetchMore() by chunkSize objects,
+ *  so the first chunk is shown without waiting for the whole selection.
+ *  Filter and sorting of model are reset.
+ * \param find - conditions of selection
+ * \param chunkSize - count of objects loaded by one fetchMore() and selected
+ *  by one statement (see EOrmModelCursor)
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Шаблонная функция, связывает модель с запросом.
+ *
+ *  Модель становится владельцем find и загруженных объектов. Объекты не
+ *  загружаются сразу: представление запрашивает их функцией fetchMore() по
+ *  chunkSize объектов, поэтому первая порция показывается без ожидания всей
+ *  выборки. Фильтр и сортировка модели сбрасываются.
+ * \param find - условия выборки
+ * \param chunkSize - количество объектов, загружаемых одним вызовом
+ *  fetchMore() и выбираемых одним запросом (см. EOrmModelCursor)
+ * \endlang
+ */
+template <typename T>
+void EOrmModel::setQuery(EOrmFind *find, int chunkSize)
+{
+    this->setChunkSize(chunkSize);
+    this->m_query = QSharedPointer<EOrmFind>(find);
+    this->m_filter.clear();
+    this->m_filterParams.clear();
+    this->m_sortColumn = -1;
+    this->m_sortOrder = Qt::AscendingOrder;
+    this->setSource(new EOrmModelCursor<T>(this->query(),
+                                           this->m_chunkSize));
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, take ownership of conditions of selection.
+ *
+ *  Key columns of pages are resolved here once from orderBy() and primary
+ *  key of type T.
+ * \param find - conditions of selection
+ * \param chunkSize - count of rows of one page
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, становится владельцем условий выборки.
+ *
+ *  Здесь один раз определяются столбцы ключа страниц по orderBy() и
+ *  первичному ключу типа T.
+ * \param find - условия выборки
+ * \param chunkSize - количество строк одной страницы
+ * \endlang
+ */
+template <typename T>
+EOrmModelCursor<T>::EOrmModelCursor(EOrmFind *find, int chunkSize) :
+    m_find(find), m_chunkSize(qMax(1, chunkSize)),
+    m_remaining(find->m_limit), m_atEnd(false)
+{
+    T *obj = new T();
+    QString pkName = obj->primaryKeyName();
+    delete obj;
+    QStringList keys;
+    bool descending = false;
+    if (!this->m_find->orderKeys(pkName, &keys, &descending)) {
+        this->m_atEnd = true;
+        EOrm::throwError(54, "Model: Order of query is not a list of columns");
+        return;
+    }
+    this->m_token = EOrmPageToken(keys, this->m_chunkSize, descending);
+}
+
+/*!
+ * \lang_en
+ * \brief Destructor, delete selected objects which were not returned.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Деструктор, удаляет выбранные, но не возвращенные объекты.
+ * \endlang
+ */
+template <typename T>
+EOrmModelCursor<T>::~EOrmModelCursor()
+{
+    qDeleteAll(this->m_window);
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned the next object of selection, the next page is
+ *  selected when objects of the previous one are returned.
+ * \return *EOrmActiveRecord
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает следующий объект выборки, следующая страница
+ *  выбирается, когда объекты предыдущей возвращены.
+ * \return *EOrmActiveRecord
+ * \endlang
+ */
+template <typename T>
+EOrmActiveRecord *EOrmModelCursor<T>::next()
+{
+    if (this->m_window.isEmpty() && !this->m_atEnd) {
+        if (this->m_remaining > -1
+                && this->m_remaining < this->m_token.m_count) {
+            this->m_token.m_count = this->m_remaining;
+        }
+        if (!this->m_token.isValid()) {
+            this->m_atEnd = true;
+            return 0;
+        }
+        this->m_window = this->m_find->template page<T>(&this->m_token);
+        if (this->m_remaining > -1) {
+            this->m_remaining -= this->m_window.count();
+        }
+        this->m_atEnd = this->m_token.atEnd();
+    }
+    if (this->m_window.isEmpty()) {
+        return 0;
+    }
+    return this->m_window.takeFirst();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned new empty object.
+ * \return *EOrmActiveRecord
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает новый пустой объект.
+ * \return *EOrmActiveRecord
+ * \endlang
+ */
+template <typename T>
+EOrmActiveRecord *EOrmModelCursor<T>::create() const
+{
+    return new T();
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned new source of objects of type T reading given
+ *  query.
+ * \param find - conditions of selection
+ * \return *EOrmModelSource
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает новый источник объектов типа T, читающий
+ *  переданный запрос.
+ * \param find - условия выборки
+ * \return *EOrmModelSource
+ * \endlang
+ */
+template <typename T>
+EOrmModelSource *EOrmModelCursor<T>::clone(EOrmFind *find) const
+{
+    return new EOrmModelCursor<T>(find, this->m_chunkSize);
 }
 
 #endif // EORMMODEL_H
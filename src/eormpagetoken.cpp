@@ -0,0 +1,420 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormpagetoken.h"
+
+/*!
+ * \lang_en
+ * \brief Initialization of secret key of signature of tokens.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация секретного ключа подписи маркеров.
+ * \endlang
+ */
+QByteArray EOrmPageToken::m_secret;
+QMutex EOrmPageToken::m_secretMutex;
+
+/*!
+ * \lang_en
+ * \brief Default constructor, create invalid token.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Стандартный конструктор, создает недействительный маркер.
+ * \endlang
+ */
+EOrmPageToken::EOrmPageToken() :
+    m_count(0), m_descending(false), m_atEnd(false)
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, create token of the first page.
+ * \param columns - sort key columns
+ * \param count - count of objects on page
+ * \param descending - sort in descending order, FALSE by default
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, создает маркер первой страницы.
+ * \param columns - столбцы ключа сортировки
+ * \param count - количество объектов на странице
+ * \param descending - сортировка по убыванию, FALSE по-умолчанию
+ * \endlang
+ */
+EOrmPageToken::EOrmPageToken(const QStringList &columns, int count,
+                             bool descending) :
+    m_count(qMin(count, EOrmPageToken::maxCount())),
+    m_descending(descending), m_atEnd(false)
+{
+    this->m_columns = columns;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if page size is set.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если задан размер страницы.
+ * \return bool
+ * \endlang
+ */
+bool EOrmPageToken::isValid() const
+{
+    return this->m_count > 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned sort key columns.
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает столбцы ключа сортировки.
+ * \return QStringList
+ * \endlang
+ */
+QStringList EOrmPageToken::columns() const
+{
+    return this->m_columns;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned values of key of the last selected object.
+ * \return QVariantList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает значения ключа последнего выбранного объекта.
+ * \return QVariantList
+ * \endlang
+ */
+QVariantList EOrmPageToken::values() const
+{
+    return this->m_values;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of objects on page.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество объектов на странице.
+ * \return int
+ * \endlang
+ */
+int EOrmPageToken::count() const
+{
+    return this->m_count;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if objects are sorted in descending order.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если объекты сортируются по убыванию.
+ * \return bool
+ * \endlang
+ */
+bool EOrmPageToken::isDescending() const
+{
+    return this->m_descending;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if token points to the first page.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если маркер указывает на первую страницу.
+ * \return bool
+ * \endlang
+ */
+bool EOrmPageToken::isFirst() const
+{
+    return this->m_values.isEmpty();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if the last page was selected.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если выбрана последняя страница.
+ * \return bool
+ * \endlang
+ */
+bool EOrmPageToken::atEnd() const
+{
+    return this->m_atEnd;
+}
+
+/*!
+ * \lang_en
+ * \brief Function return token to the first page.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает маркер на первую страницу.
+ * \endlang
+ */
+void EOrmPageToken::reset()
+{
+    this->m_values.clear();
+    this->m_atEnd = false;
+}
+
+/*!
+ * \lang_en
+ * \brief Function convert token to string.
+ *
+ *  If secret is set, signature of data is appended after point.
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция преобразует маркер в строку.
+ *
+ *  Если задан секрет, после точки добавляется подпись данных.
+ * \return QString
+ * \endlang
+ */
+QString EOrmPageToken::toString() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << this->m_columns << this->m_values << qint32(this->m_count)
+           << this->m_descending << this->m_atEnd;
+    QByteArray result = data.toBase64();
+    QByteArray sign = EOrmPageToken::signature(data);
+    if (!sign.isEmpty()) {
+        result += "." + sign.toBase64();
+    }
+    return QString::fromLatin1(result);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, restore token from string.
+ *
+ *  Only signed strings are restored, so secret should be set by setSecret().
+ *  Returned invalid token if secret is not set, signature does not match or
+ *  string is damaged: data is deserialized only after signature is checked.
+ *  Page size is limited by maxCount().
+ * \param token - string created by toString()
+ * \return EOrmPageToken
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, восстанавливает маркер из строки.
+ *
+ *  Восстанавливаются только подписанные строки, поэтому секрет должен быть
+ *  задан функцией setSecret(). Возвращает недействительный маркер, если
+ *  секрет не задан, подпись не совпадает или строка повреждена: данные
+ *  десериализуются только после проверки подписи. Размер страницы
+ *  ограничивается maxCount().
+ * \param token - строка, созданная функцией toString()
+ * \return EOrmPageToken
+ * \endlang
+ */
+EOrmPageToken EOrmPageToken::fromString(const QString &token)
+{
+    EOrmPageToken result;
+    qint32 count = 0;
+    QList<QByteArray> parts = token.toLatin1().split('.');
+    if (parts.count() != 2) {
+        return EOrmPageToken();
+    }
+    QByteArray data = QByteArray::fromBase64(parts.first());
+    QByteArray sign = EOrmPageToken::signature(data);
+    if (sign.isEmpty() || !EOrmPageToken::equals(
+                QByteArray::fromBase64(parts.last()), sign)) {
+        return EOrmPageToken();
+    }
+    QDataStream stream(data);
+    stream >> result.m_columns >> result.m_values >> count
+           >> result.m_descending >> result.m_atEnd;
+    if (stream.status() != QDataStream::Ok
+            || (!result.m_values.isEmpty()
+                && result.m_values.count() != result.m_columns.count())) {
+        return EOrmPageToken();
+    }
+    result.m_count = qMin(int(count), EOrmPageToken::maxCount());
+    return result;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function returned the maximum count of objects on page.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция возвращает максимальное количество объектов на
+ *  странице.
+ * \return int
+ * \endlang
+ */
+int EOrmPageToken::maxCount()
+{
+    return 10000;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function set secret key of signature of tokens.
+ *
+ *  Strings created by toString() are signed by HMAC with this key, and
+ *  fromString() rejects strings without valid signature. Empty key turns off
+ *  signing, then fromString() rejects all strings.
+ * \param secret - secret key
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция устанавливает секретный ключ подписи маркеров.
+ *
+ *  Строки, созданные функцией toString(), подписываются HMAC с этим ключом, и
+ *  fromString() отклоняет строки без верной подписи. Пустой ключ отключает
+ *  подпись, тогда fromString() отклоняет все строки.
+ * \param secret - секретный ключ
+ * \endlang
+ */
+void EOrmPageToken::setSecret(const QByteArray &secret)
+{
+    QMutexLocker locker(&EOrmPageToken::m_secretMutex);
+    EOrmPageToken::m_secret = secret;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function returned HMAC-SHA1 signature of data, empty array
+ *  if secret is not set.
+ * \param data - serialized token
+ * \return QByteArray
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция возвращает подпись HMAC-SHA1 данных, пустой
+ *  массив, если секрет не задан.
+ * \param data - сериализованный маркер
+ * \return QByteArray
+ * \endlang
+ */
+QByteArray EOrmPageToken::signature(const QByteArray &data)
+{
+    QMutexLocker locker(&EOrmPageToken::m_secretMutex);
+    QByteArray key = EOrmPageToken::m_secret;
+    locker.unlock();
+    if (key.isEmpty()) {
+        return QByteArray();
+    }
+    return QMessageAuthenticationCode::hash(data, key,
+                                            QCryptographicHash::Sha1);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function compare signatures in constant time, so time of
+ *  comparison does not tell how many bytes of forged signature are right.
+ * \param first - the first signature
+ * \param second - the second signature
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция сравнивает подписи за постоянное время, поэтому
+ *  время сравнения не выдает, сколько байт поддельной подписи верны.
+ * \param first - первая подпись
+ * \param second - вторая подпись
+ * \return bool
+ * \endlang
+ */
+bool EOrmPageToken::equals(const QByteArray &first, const QByteArray &second)
+{
+    if (first.size() != second.size()) {
+        return false;
+    }
+    char diff = 0;
+    for (int i = 0; i < first.size(); i++) {
+        diff |= char(first.at(i) ^ second.at(i));
+    }
+    return diff == 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Function remember key of the last selected object.
+ * \param columns - sort key columns
+ * \param values - values of key
+ * \param atEnd - is the last page selected
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция запоминает ключ последнего выбранного объекта.
+ * \param columns - столбцы ключа сортировки
+ * \param values - значения ключа
+ * \param atEnd - выбрана ли последняя страница
+ * \endlang
+ */
+void EOrmPageToken::advance(const QStringList &columns,
+                            const QVariantList &values, bool atEnd)
+{
+    this->m_columns = columns;
+    if (!values.isEmpty()) {
+        this->m_values = values;
+    }
+    this->m_atEnd = atEnd;
+}
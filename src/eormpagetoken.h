@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMPAGETOKEN_H
+#define EORMPAGETOKEN_H
+
+#include "eorm_global.h"
+#include <QtCore>
+
+template <typename T>
+class EOrmModelCursor;
+
+/*!
+ * \class EOrmPageToken
+ *
+ * \lang_en
+ * \brief Class of the page token for keyset pagination.
+ *
+ *  The token describes sort key columns and page size and remembers values of
+ *  key of the last selected object. It is passed to EOrmFind::page(), which
+ *  selects the next page by condition on the key instead of OFFSET, so every
+ *  page is selected equally fast. Primary key is appended to key columns if
+ *  it is missing, so the key is unique. Key columns should not contain NULL.
+ *  The token can be converted to string by toString() and restored by
+ *  fromString(), for example to pass it to a client. String is signed with
+ *  secret set by setSecret(), and fromString() restores only strings with
+ *  valid signature, so secret is required to restore tokens and tokens
+ *  changed by client are rejected. Restored token is checked too: key
+ *  columns are checked by EOrmFind::page() against columns of the table,
+ *  page size is limited by maxCount().
+ *  Example:
+ * \code
+ *  EOrmPageToken token(QStringList() << "name", 50);
+ *  while (!token.atEnd()) {
+ *      QList<Test*> lst = EOrmFind::find()->where("active = 1")
+ *                                         ->page<Test>(&token);
+ *      ...
+ *  }
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс маркера страницы для постраничной выборки по ключу.
+ *
+ *  Маркер описывает столбцы ключа сортировки и размер страницы и запоминает
+ *  значения ключа последнего выбранного объекта. Он передается в
+ *  EOrmFind::page(), которая выбирает следующую страницу по условию на ключ
+ *  вместо OFFSET, поэтому каждая страница выбирается одинаково быстро.
+ *  Первичный ключ добавляется к столбцам ключа, если его там нет, поэтому ключ
+ *  уникален. Столбцы ключа не должны содержать NULL. Маркер можно
+ *  преобразовать в строку функцией toString() и восстановить функцией
+ *  fromString(), например, чтобы передать его клиенту. Строка подписывается
+ *  секретом, заданным функцией setSecret(), и fromString() восстанавливает
+ *  только строки с верной подписью, поэтому секрет необходим для
+ *  восстановления маркеров, а измененные клиентом маркеры отклоняются.
+ *  Восстановленный маркер также проверяется: столбцы ключа проверяются
+ *  функцией EOrmFind::page() по столбцам таблицы, размер страницы ограничен
+ *  maxCount(). Пример:
+ * \code
+ *  EOrmPageToken token(QStringList() << "name", 50);
+ *  while (!token.atEnd()) {
+ *      QList<Test*> lst = EOrmFind::find()->where("active = 1")
+ *                                         ->page<Test>(&token);
+ *      ...
+ *  }
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmPageToken
+{
+    friend class EOrmFind;
+    template <typename T>
+    friend class EOrmModelCursor;
+
+public:
+    EOrmPageToken();
+    EOrmPageToken(const QStringList &columns, int count,
+                  bool descending = false);
+    bool isValid() const;
+    QStringList columns() const;
+    QVariantList values() const;
+    int count() const;
+    bool isDescending() const;
+    bool isFirst() const;
+    bool atEnd() const;
+    void reset();
+    QString toString() const;
+    static EOrmPageToken fromString(const QString &token);
+    static int maxCount();
+    static void setSecret(const QByteArray &secret);
+
+private:
+    void advance(const QStringList &columns, const QVariantList &values,
+                 bool atEnd);
+    static QByteArray signature(const QByteArray &data);
+    static bool equals(const QByteArray &first, const QByteArray &second);
+
+    static QByteArray m_secret;
+    static QMutex m_secretMutex;
+
+    QStringList m_columns;
+    QVariantList m_values;
+    int m_count;
+    bool m_descending;
+    bool m_atEnd;
+
+};
+
+#endif // EORMPAGETOKEN_H
@@ -0,0 +1,427 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormquerycache.h"
+#include "eorm.h"
+
+/*!
+ * \lang_en
+ * \brief Initialization of cached results, generations of tables, tables
+ *  changed by open transactions and statistics. Memory budget is 16 MB.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация закэшированных результатов, поколений таблиц,
+ *  таблиц, измененных открытыми транзакциями, и статистики. Бюджет памяти
+ *  16 МБ.
+ * \endlang
+ */
+QCache<QString, EOrmQueryCache::Entry> EOrmQueryCache::m_entries(
+        16 * 1024 * 1024);
+QHash<QString, quint64> EOrmQueryCache::m_generations;
+QHash<QString, QSet<QString> > EOrmQueryCache::m_pending;
+qint64 EOrmQueryCache::m_hits = 0;
+qint64 EOrmQueryCache::m_misses = 0;
+QMutex EOrmQueryCache::m_mutex;
+
+/*!
+ * \lang_en
+ * \brief Static function, take result of query from cache.
+ *
+ *  Returned FALSE if result is not cached, is expired or the table was
+ *  changed after caching.
+ * \param db - a database object
+ * \param tableName - name of the table of query
+ * \param sql - SQL code of query
+ * \param values - bound values
+ * \param rows - result of query
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, берет результат запроса из кэша.
+ *
+ *  Возвращает FALSE, если результат не закэширован, устарел или таблица
+ *  изменилась после кэширования.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы запроса
+ * \param sql - SQL-код запроса
+ * \param values - значения параметров
+ * \param rows - результат запроса
+ * \return bool
+ * \endlang
+ */
+bool EOrmQueryCache::fetch(QSqlDatabase db, const QString &tableName,
+                           const QString &sql, const QVariantList &values,
+                           EOrmRowSet *rows)
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    QString key = EOrmQueryCache::key(db, sql, values);
+    Entry *entry = EOrmQueryCache::m_entries.object(key);
+    if (entry != 0) {
+        quint64 generation = EOrmQueryCache::m_generations.value(
+                    EOrm::connectionKey(db) + QLatin1Char('/') + tableName);
+        if (entry->generation == generation
+                && !entry->timer.hasExpired(entry->ttl)) {
+            EOrmQueryCache::m_hits++;
+            *rows = entry->rows;
+            return true;
+        }
+        EOrmQueryCache::m_entries.remove(key);
+    }
+    EOrmQueryCache::m_misses++;
+    return false;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned generation of the table.
+ *
+ *  It should be read before the query is executed and passed to store(), so
+ *  the result is not cached if the table was changed meanwhile.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return quint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает поколение таблицы.
+ *
+ *  Его следует прочитать до выполнения запроса и передать в store(), чтобы
+ *  результат не кэшировался, если таблица за это время изменилась.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return quint64
+ * \endlang
+ */
+quint64 EOrmQueryCache::generation(QSqlDatabase db, const QString &tableName)
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    return EOrmQueryCache::m_generations.value(EOrm::connectionKey(db)
+                                               + QLatin1Char('/') + tableName);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, put result of query into cache.
+ *
+ *  Nothing is done if ttl is less than 1, if the table was changed after
+ *  generation was read or a transaction is open on the connection: rows read
+ *  in it can be rolled back.
+ * \param db - a database object
+ * \param tableName - name of the table of query
+ * \param sql - SQL code of query
+ * \param values - bound values
+ * \param rows - result of query
+ * \param ttl - time to live in milliseconds
+ * \param generation - generation of the table read by generation() before
+ *  the query
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, помещает результат запроса в кэш.
+ *
+ *  Ничего не делает, если ttl меньше 1, если таблица изменилась после
+ *  чтения поколения или на соединении открыта транзакция: прочитанные в ней
+ *  строки могут быть отменены.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы запроса
+ * \param sql - SQL-код запроса
+ * \param values - значения параметров
+ * \param rows - результат запроса
+ * \param ttl - время жизни в миллисекундах
+ * \param generation - поколение таблицы, прочитанное generation() до
+ *  выполнения запроса
+ * \endlang
+ */
+void EOrmQueryCache::store(QSqlDatabase db, const QString &tableName,
+                           const QString &sql, const QVariantList &values,
+                           const EOrmRowSet &rows, int ttl,
+                           quint64 generation)
+{
+    if (ttl < 1 || EOrm::transactionDepth(db) > 0) {
+        return;
+    }
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    QString tableKey = EOrm::connectionKey(db) + QLatin1Char('/') + tableName;
+    if (EOrmQueryCache::m_generations.value(tableKey) != generation) {
+        return;
+    }
+    Entry *entry = new Entry;
+    entry->rows = rows;
+    entry->tableKey = tableKey;
+    entry->generation = generation;
+    entry->ttl = ttl;
+    entry->timer.start();
+    EOrmQueryCache::m_entries.insert(EOrmQueryCache::key(db, sql, values),
+                                     entry, EOrmQueryCache::cost(rows));
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, drop all results of queries of the table.
+ *
+ *  Results are not removed at once, the generation of table is increased
+ *  and old results are dropped at lookup. If a transaction is open on the
+ *  connection, the generation is increased once more when the outer
+ *  transaction is finished, because other connections can cache old rows
+ *  until then.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, сбрасывает все результаты запросов таблицы.
+ *
+ *  Результаты не удаляются сразу, увеличивается поколение таблицы, и старые
+ *  результаты сбрасываются при обращении. Если на соединении открыта
+ *  транзакция, поколение повторно увеличивается при завершении внешней
+ *  транзакции, так как до этого другие соединения могут закэшировать старые
+ *  строки.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \endlang
+ */
+void EOrmQueryCache::invalidate(QSqlDatabase db, const QString &tableName)
+{
+    bool deferred = EOrm::transactionDepth(db) > 0;
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    QString tableKey = EOrm::connectionKey(db) + QLatin1Char('/') + tableName;
+    EOrmQueryCache::m_generations[tableKey]++;
+    if (deferred) {
+        EOrmQueryCache::m_pending[db.connectionName()].insert(tableKey);
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, remove all results from cache and reset
+ *  statistics.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, удаляет все результаты из кэша и сбрасывает
+ *  статистику.
+ * \endlang
+ */
+void EOrmQueryCache::clear()
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    EOrmQueryCache::m_entries.clear();
+    EOrmQueryCache::m_hits = 0;
+    EOrmQueryCache::m_misses = 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned memory budget of cache in bytes.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает бюджет памяти кэша в байтах.
+ * \return int
+ * \endlang
+ */
+int EOrmQueryCache::maxCost()
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    return EOrmQueryCache::m_entries.maxCost();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set memory budget of cache in bytes.
+ * \param bytes - memory budget
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает бюджет памяти кэша в байтах.
+ * \param bytes - бюджет памяти
+ * \endlang
+ */
+void EOrmQueryCache::setMaxCost(int bytes)
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    EOrmQueryCache::m_entries.setMaxCost(bytes);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of queries found in cache.
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество запросов, найденных в
+ *  кэше.
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmQueryCache::hits()
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    return EOrmQueryCache::m_hits;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of queries not found in cache.
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество запросов, не найденных в
+ *  кэше.
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmQueryCache::misses()
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    return EOrmQueryCache::m_misses;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned share of queries found in cache, from 0
+ *  to 1.
+ * \return double
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает долю запросов, найденных в кэше, от
+ *  0 до 1.
+ * \return double
+ * \endlang
+ */
+double EOrmQueryCache::hitRate()
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    qint64 total = EOrmQueryCache::m_hits + EOrmQueryCache::m_misses;
+    return total > 0 ? double(EOrmQueryCache::m_hits) / total : 0.0;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned the key of query in cache.
+ *
+ *  SQL code is taken as is: whitespaces are not normalized, because they can
+ *  be a part of string literal. Bound values are written with their types.
+ * \param db - a database object
+ * \param sql - SQL code of query
+ * \param values - bound values
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает ключ запроса в кэше.
+ *
+ *  SQL-код берется как есть: пробелы не нормализуются, так как они могут
+ *  быть частью строкового литерала. Значения параметров записываются вместе
+ *  с их типами.
+ * \param db - объект базы данных
+ * \param sql - SQL-код запроса
+ * \param values - значения параметров
+ * \return QString
+ * \endlang
+ */
+QString EOrmQueryCache::key(QSqlDatabase db, const QString &sql,
+                            const QVariantList &values)
+{
+    QStringList key;
+    key << EOrm::connectionKey(db) << sql;
+    foreach (QVariant value, values) {
+        key << QString::fromLatin1(value.typeName()) + QLatin1Char(':')
+               + value.toString();
+    }
+    return key.join(QString(QChar(0)));
+}
+
+/*!
+ * \lang_en
+ * \brief Function estimate memory used by result in bytes.
+ * \param rows - result of query
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция оценивает память, занимаемую результатом, в байтах.
+ * \param rows - результат запроса
+ * \return int
+ * \endlang
+ */
+int EOrmQueryCache::cost(const EOrmRowSet &rows)
+{
+    int bytes = sizeof(Entry) + rows.values().count() * sizeof(QVariant);
+    foreach (QVariant value, rows.values()) {
+        if (value.type() == QVariant::String) {
+            bytes += value.toString().size() * sizeof(QChar);
+        } else if (value.type() == QVariant::ByteArray) {
+            bytes += value.toByteArray().size();
+        }
+    }
+    return bytes;
+}
+
+/*!
+ * \lang_en
+ * \brief Function increase once more generations of tables changed by the
+ *  transaction of connection, it is called by EOrm when the outer transaction
+ *  is committed or rolled back.
+ * \param db - a database object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция повторно увеличивает поколения таблиц, измененных
+ *  транзакцией соединения, вызывается EOrm при фиксации или отмене внешней
+ *  транзакции.
+ * \param db - объект базы данных
+ * \endlang
+ */
+void EOrmQueryCache::finishTransaction(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmQueryCache::m_mutex);
+    foreach (QString tableKey,
+             EOrmQueryCache::m_pending.take(db.connectionName())) {
+        EOrmQueryCache::m_generations[tableKey]++;
+    }
+}
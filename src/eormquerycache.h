@@ -0,0 +1,137 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMQUERYCACHE_H
+#define EORMQUERYCACHE_H
+
+#include "eorm_global.h"
+#include <QtSql>
+#include "eormrowset.h"
+
+/*!
+ * \class EOrmQueryCache
+ *
+ * \lang_en
+ * \brief The static class, process-wide cache of query results.
+ *
+ *  Results are cached as EOrmRowSet by connection, exact SQL code and bound
+ *  values. It is used by EOrmFind for queries marked by
+ *  EOrmFind::cache(). Every result lives not longer than its time to live and
+ *  is dropped at once when the table of the query is changed through the ORM:
+ *  save(), remove(), insertAll(), removeAll(), updateAll() or deleteAll().
+ *  If the table is changed inside a transaction, its results are dropped once
+ *  more when the outer transaction is committed or rolled back, and results
+ *  read inside a transaction are not cached. A result is not cached if the
+ *  table was changed while the query was executed. Changes of the table made
+ *  bypassing the ORM are seen only after time to live. The least recently
+ *  used results are evicted if memory budget (see setMaxCost()) is exceeded.
+ *  Access to the cache is thread-safe. Example:
+ * \code
+ *  int count = EOrmFind::find()->where("active = 1")->cache(5000)
+ *                              ->count<Test>();
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статический класс, общий для процесса кэш результатов запросов.
+ *
+ *  Результаты кэшируются в виде EOrmRowSet по соединению, точному SQL-коду и
+ *  значениям параметров. Используется в EOrmFind для запросов,
+ *  отмеченных EOrmFind::cache(). Каждый результат живет не дольше своего
+ *  времени жизни и сразу сбрасывается при изменении таблицы запроса через
+ *  ORM: save(), remove(), insertAll(), removeAll(), updateAll() или
+ *  deleteAll(). Если таблица изменена внутри транзакции, ее результаты
+ *  повторно сбрасываются при фиксации или отмене внешней транзакции, а
+ *  результаты, прочитанные внутри транзакции, не кэшируются. Результат не
+ *  кэшируется, если таблица изменилась во время выполнения запроса.
+ *  Изменения таблицы в обход ORM видны только по истечении времени жизни.
+ *  Давно не используемые результаты вытесняются при превышении бюджета памяти
+ *  (см. setMaxCost()). Доступ к кэшу потокобезопасен. Пример:
+ * \code
+ *  int count = EOrmFind::find()->where("active = 1")->cache(5000)
+ *                              ->count<Test>();
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmQueryCache
+{
+    friend class EOrm;
+
+public:
+    static bool fetch(QSqlDatabase db, const QString &tableName,
+                      const QString &sql, const QVariantList &values,
+                      EOrmRowSet *rows);
+    static quint64 generation(QSqlDatabase db, const QString &tableName);
+    static void store(QSqlDatabase db, const QString &tableName,
+                      const QString &sql, const QVariantList &values,
+                      const EOrmRowSet &rows, int ttl, quint64 generation);
+    static void invalidate(QSqlDatabase db, const QString &tableName);
+    static void clear();
+    static int maxCost();
+    static void setMaxCost(int bytes);
+    static qint64 hits();
+    static qint64 misses();
+    static double hitRate();
+
+private:
+    struct Entry {
+        EOrmRowSet rows;
+        QString tableKey;
+        quint64 generation;
+        int ttl;
+        QElapsedTimer timer;
+    };
+
+    static QString key(QSqlDatabase db, const QString &sql,
+                       const QVariantList &values);
+    static int cost(const EOrmRowSet &rows);
+    static void finishTransaction(QSqlDatabase db);
+
+    static QCache<QString, Entry> m_entries;
+    static QHash<QString, quint64> m_generations;
+    static QHash<QString, QSet<QString> > m_pending;
+    static qint64 m_hits;
+    static qint64 m_misses;
+    static QMutex m_mutex;
+
+};
+
+#endif // EORMQUERYCACHE_H
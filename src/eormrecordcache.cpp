@@ -0,0 +1,624 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormrecordcache.h"
+#include "eorm.h"
+
+/*!
+ * \lang_en
+ * \brief Initialization of cached records, enabled tables, versions of
+ *  SQLite databases and records changed by open transactions. Memory budget
+ *  is 16 MB, data version is checked once per second.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация закэшированных записей, включенных таблиц, версий
+ *  баз SQLite и записей, измененных открытыми транзакциями. Бюджет памяти
+ *  16 МБ, версия данных проверяется раз в секунду.
+ * \endlang
+ */
+QCache<QString, QVector<QVariant> > EOrmRecordCache::m_records(16 * 1024 * 1024);
+QHash<QString, EOrmRecordCache::Stats> EOrmRecordCache::m_tables;
+QHash<QString, EOrmRecordCache::DataVersion> EOrmRecordCache::m_versions;
+QHash<QString, EOrmRecordCache::Pending> EOrmRecordCache::m_pending;
+int EOrmRecordCache::m_checkInterval = 1000;
+QMutex EOrmRecordCache::m_mutex;
+
+/*!
+ * \lang_en
+ * \brief Static function, turn on cache for the table of connection.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, включает кэш для таблицы соединения.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \endlang
+ */
+void EOrmRecordCache::enable(QSqlDatabase db, const QString &tableName)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    QString tableKey = EOrmRecordCache::key(db, tableName);
+    if (!EOrmRecordCache::m_tables.contains(tableKey)) {
+        EOrmRecordCache::m_tables.insert(tableKey, Stats());
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, turn off cache for the table of connection and
+ *  remove its records.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, выключает кэш для таблицы соединения и удаляет
+ *  ее записи.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \endlang
+ */
+void EOrmRecordCache::disable(QSqlDatabase db, const QString &tableName)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    QString tableKey = EOrmRecordCache::key(db, tableName);
+    EOrmRecordCache::m_tables.remove(tableKey);
+    EOrmRecordCache::removeTable(tableKey);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned TRUE if cache is turned on for the table.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает TRUE, если кэш включен для таблицы.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return bool
+ * \endlang
+ */
+bool EOrmRecordCache::isEnabled(QSqlDatabase db, const QString &tableName)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    return EOrmRecordCache::m_tables.contains(EOrmRecordCache::key(db,
+                                                                   tableName));
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, take values of record from cache.
+ *
+ *  Returned FALSE if cache is turned off for the table or record is not
+ *  cached.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \param pk - primary key
+ * \param values - values of columns
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, берет значения записи из кэша.
+ *
+ *  Возвращает FALSE, если кэш выключен для таблицы или запись не
+ *  закэширована.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \param pk - первичный ключ
+ * \param values - значения столбцов
+ * \return bool
+ * \endlang
+ */
+bool EOrmRecordCache::fetch(QSqlDatabase db, const QString &tableName,
+                            const QVariant &pk, QVector<QVariant> *values)
+{
+    qint64 version = EOrmRecordCache::dataVersion(db, tableName);
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    QString tableKey = EOrmRecordCache::key(db, tableName);
+    QHash<QString, Stats>::iterator stats =
+            EOrmRecordCache::m_tables.find(tableKey);
+    if (stats == EOrmRecordCache::m_tables.end()) {
+        return false;
+    }
+    EOrmRecordCache::checkDataVersion(db, version);
+    QVector<QVariant> *cached = EOrmRecordCache::m_records.object(
+                tableKey + QLatin1Char('/') + pk.toString());
+    if (cached == 0) {
+        stats.value().misses++;
+        return false;
+    }
+    stats.value().hits++;
+    *values = *cached;
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, put values of record into cache.
+ *
+ *  Nothing is done if cache is turned off for the table or a transaction is
+ *  open on the connection: values read in it can be rolled back.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \param pk - primary key
+ * \param values - values of columns
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, помещает значения записи в кэш.
+ *
+ *  Ничего не делает, если кэш выключен для таблицы или на соединении открыта
+ *  транзакция: прочитанные в ней значения могут быть отменены.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \param pk - первичный ключ
+ * \param values - значения столбцов
+ * \endlang
+ */
+void EOrmRecordCache::store(QSqlDatabase db, const QString &tableName,
+                            const QVariant &pk,
+                            const QVector<QVariant> &values)
+{
+    if (EOrm::transactionDepth(db) > 0) {
+        return;
+    }
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    QString tableKey = EOrmRecordCache::key(db, tableName);
+    if (!EOrmRecordCache::m_tables.contains(tableKey)) {
+        return;
+    }
+    EOrmRecordCache::m_records.insert(tableKey + QLatin1Char('/')
+                                      + pk.toString(),
+                                      new QVector<QVariant>(values),
+                                      EOrmRecordCache::cost(values));
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, remove record from cache.
+ *
+ *  If a transaction is open on the connection, the record is removed once
+ *  more when the outer transaction is finished, because other connections
+ *  can cache its old values until then.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \param pk - primary key
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, удаляет запись из кэша.
+ *
+ *  Если на соединении открыта транзакция, запись повторно удаляется при
+ *  завершении внешней транзакции, так как до этого другие соединения могут
+ *  закэшировать ее старые значения.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \param pk - первичный ключ
+ * \endlang
+ */
+void EOrmRecordCache::invalidate(QSqlDatabase db, const QString &tableName,
+                                 const QVariant &pk)
+{
+    bool deferred = EOrm::transactionDepth(db) > 0;
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    QString tableKey = EOrmRecordCache::key(db, tableName);
+    if (EOrmRecordCache::m_tables.contains(tableKey)) {
+        QString recordKey = tableKey + QLatin1Char('/') + pk.toString();
+        EOrmRecordCache::m_records.remove(recordKey);
+        if (deferred) {
+            EOrmRecordCache::m_pending[db.connectionName()].records
+                    .insert(recordKey);
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, remove all records of the table from cache.
+ *
+ *  If a transaction is open on the connection, records are removed once more
+ *  when the outer transaction is finished.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, удаляет из кэша все записи таблицы.
+ *
+ *  Если на соединении открыта транзакция, записи повторно удаляются при
+ *  завершении внешней транзакции.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \endlang
+ */
+void EOrmRecordCache::invalidate(QSqlDatabase db, const QString &tableName)
+{
+    bool deferred = EOrm::transactionDepth(db) > 0;
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    QString tableKey = EOrmRecordCache::key(db, tableName);
+    if (EOrmRecordCache::m_tables.contains(tableKey)) {
+        EOrmRecordCache::removeTable(tableKey);
+        if (deferred) {
+            EOrmRecordCache::m_pending[db.connectionName()].tables
+                    .insert(tableKey);
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, remove all records from cache.
+ *
+ *  Tables stay enabled, statistics are reset.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, удаляет все записи из кэша.
+ *
+ *  Таблицы остаются включенными, статистика сбрасывается.
+ * \endlang
+ */
+void EOrmRecordCache::clear()
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    EOrmRecordCache::m_records.clear();
+    QHash<QString, Stats>::iterator it = EOrmRecordCache::m_tables.begin();
+    for (; it != EOrmRecordCache::m_tables.end(); ++it) {
+        it.value() = Stats();
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned memory budget of cache in bytes.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает бюджет памяти кэша в байтах.
+ * \return int
+ * \endlang
+ */
+int EOrmRecordCache::maxCost()
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    return EOrmRecordCache::m_records.maxCost();
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set memory budget of cache in bytes.
+ *
+ *  The least recently used records are evicted if it is exceeded.
+ * \param bytes - memory budget
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает бюджет памяти кэша в байтах.
+ *
+ *  При его превышении вытесняются давно не используемые записи.
+ * \param bytes - бюджет памяти
+ * \endlang
+ */
+void EOrmRecordCache::setMaxCost(int bytes)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    EOrmRecordCache::m_records.setMaxCost(bytes);
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned interval of check of SQLite data version
+ *  in milliseconds.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает интервал проверки версии данных
+ *  SQLite в миллисекундах.
+ * \return int
+ * \endlang
+ */
+int EOrmRecordCache::checkInterval()
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    return EOrmRecordCache::m_checkInterval;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, set interval of check of SQLite data version.
+ *
+ *  0 means check at every lookup, negative value turns check off.
+ * \param msecs - interval in milliseconds
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, устанавливает интервал проверки версии данных
+ *  SQLite.
+ *
+ *  0 означает проверку при каждом обращении, отрицательное значение выключает
+ *  проверку.
+ * \param msecs - интервал в миллисекундах
+ * \endlang
+ */
+void EOrmRecordCache::setCheckInterval(int msecs)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    EOrmRecordCache::m_checkInterval = msecs;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of lookups found in cache.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество обращений, найденных в
+ *  кэше.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmRecordCache::hits(QSqlDatabase db, const QString &tableName)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    return EOrmRecordCache::m_tables.value(EOrmRecordCache::key(db, tableName))
+            .hits;
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, returned count of lookups not found in cache.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, возвращает количество обращений, не найденных
+ *  в кэше.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmRecordCache::misses(QSqlDatabase db, const QString &tableName)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    return EOrmRecordCache::m_tables.value(EOrmRecordCache::key(db, tableName))
+            .misses;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned the key of the table in cache.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает ключ таблицы в кэше.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return QString
+ * \endlang
+ */
+QString EOrmRecordCache::key(QSqlDatabase db, const QString &tableName)
+{
+    return EOrm::connectionKey(db) + QLatin1Char('/') + tableName;
+}
+
+/*!
+ * \lang_en
+ * \brief Function remove all records of the table, the lock is held by
+ *  caller.
+ * \param tableKey - key of the table
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция удаляет все записи таблицы, блокировка удерживается
+ *  вызывающей стороной.
+ * \param tableKey - ключ таблицы
+ * \endlang
+ */
+void EOrmRecordCache::removeTable(const QString &tableKey)
+{
+    QString prefix = tableKey + QLatin1Char('/');
+    foreach (QString recordKey, EOrmRecordCache::m_records.keys()) {
+        if (recordKey.startsWith(prefix)) {
+            EOrmRecordCache::m_records.remove(recordKey);
+        }
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function read data version of SQLite database when it is time to
+ *  check it.
+ *
+ *  The lock is taken only to check the interval, PRAGMA data_version is run
+ *  without it, so a slow connection does not block the cache for other
+ *  threads. Returned -1 if version should not be checked now.
+ * \param db - a database object
+ * \param tableName - name of the table
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция читает версию данных базы SQLite, когда пора ее проверить.
+ *
+ *  Блокировка берется только для проверки интервала, PRAGMA data_version
+ *  выполняется без нее, поэтому медленное соединение не блокирует кэш для
+ *  других потоков. Возвращает -1, если версию сейчас проверять не нужно.
+ * \param db - объект базы данных
+ * \param tableName - имя таблицы
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmRecordCache::dataVersion(QSqlDatabase db, const QString &tableName)
+{
+    if (db.driverName() != "QSQLITE") {
+        return -1;
+    }
+    {
+        QMutexLocker locker(&EOrmRecordCache::m_mutex);
+        if (EOrmRecordCache::m_checkInterval < 0
+                || !EOrmRecordCache::m_tables.contains(
+                    EOrmRecordCache::key(db, tableName))) {
+            return -1;
+        }
+        DataVersion &current =
+                EOrmRecordCache::m_versions[db.connectionName()];
+        if (current.timer.isValid()
+                && !current.timer.hasExpired(
+                    EOrmRecordCache::m_checkInterval)) {
+            return -1;
+        }
+        current.timer.start();
+    }
+    QSqlQuery qr(db);
+    if (!qr.exec("PRAGMA data_version") || !qr.next()) {
+        return -1;
+    }
+    return qr.value(0).toLongLong();
+}
+
+/*!
+ * \lang_en
+ * \brief Function check data version of SQLite database read by
+ *  dataVersion(), the lock is held by caller.
+ *
+ *  If version was changed by other connection, all records of the connection
+ *  are removed.
+ * \param db - a database object
+ * \param version - data version, -1 if it was not read
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет версию данных базы SQLite, прочитанную
+ *  dataVersion(), блокировка удерживается вызывающей стороной.
+ *
+ *  Если версия изменена другим соединением, удаляются все записи соединения.
+ * \param db - объект базы данных
+ * \param version - версия данных, -1, если она не прочитана
+ * \endlang
+ */
+void EOrmRecordCache::checkDataVersion(QSqlDatabase db, qint64 version)
+{
+    if (version < 0) {
+        return;
+    }
+    DataVersion &current = EOrmRecordCache::m_versions[db.connectionName()];
+    if (current.version > -1 && current.version != version) {
+        QString prefix = EOrm::connectionKey(db) + QLatin1Char('/');
+        foreach (QString recordKey, EOrmRecordCache::m_records.keys()) {
+            if (recordKey.startsWith(prefix)) {
+                EOrmRecordCache::m_records.remove(recordKey);
+            }
+        }
+    }
+    current.version = version;
+}
+
+/*!
+ * \lang_en
+ * \brief Function estimate memory used by values of record in bytes.
+ * \param values - values of columns
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция оценивает память, занимаемую значениями записи, в байтах.
+ * \param values - значения столбцов
+ * \return int
+ * \endlang
+ */
+int EOrmRecordCache::cost(const QVector<QVariant> &values)
+{
+    int bytes = sizeof(QVector<QVariant>) + values.count() * sizeof(QVariant);
+    foreach (QVariant value, values) {
+        if (value.type() == QVariant::String) {
+            bytes += value.toString().size() * sizeof(QChar);
+        } else if (value.type() == QVariant::ByteArray) {
+            bytes += value.toByteArray().size();
+        }
+    }
+    return bytes;
+}
+
+/*!
+ * \lang_en
+ * \brief Function remove once more records changed by the transaction of
+ *  connection, it is called by EOrm when the outer transaction is committed
+ *  or rolled back.
+ * \param db - a database object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция повторно удаляет записи, измененные транзакцией
+ *  соединения, вызывается EOrm при фиксации или отмене внешней транзакции.
+ * \param db - объект базы данных
+ * \endlang
+ */
+void EOrmRecordCache::finishTransaction(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmRecordCache::m_mutex);
+    Pending pending = EOrmRecordCache::m_pending.take(db.connectionName());
+    foreach (QString tableKey, pending.tables) {
+        EOrmRecordCache::removeTable(tableKey);
+    }
+    foreach (QString recordKey, pending.records) {
+        EOrmRecordCache::m_records.remove(recordKey);
+    }
+}
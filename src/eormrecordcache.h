@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMRECORDCACHE_H
+#define EORMRECORDCACHE_H
+
+#include "eorm_global.h"
+#include <QtSql>
+
+/*!
+ * \class EOrmRecordCache
+ *
+ * \lang_en
+ * \brief The static class, process-wide cache of records by primary key.
+ *
+ *  Cache is turned on for the table of connection by enable(). Then
+ *  EOrmActiveRecord::load() takes values of columns from memory, if they are
+ *  cached, otherwise reads them from database and caches. Records are
+ *  removed from cache by save() and remove() of objects, by
+ *  EOrmActiveRecord::removeAll(), EOrmFind::updateAll() and
+ *  EOrmFind::deleteAll(). The least recently used records are evicted if
+ *  memory budget (see setMaxCost()) is exceeded. Values read inside a
+ *  transaction (see EOrm::transaction()) are not cached, and records changed
+ *  in it are removed once more when the outer transaction is committed or
+ *  rolled back, so the cache never keeps uncommitted values. On SQLite writes
+ *  of other connections are detected by PRAGMA data_version, which is checked
+ *  not more often than checkInterval(), so lookups of hot records do not
+ *  touch database. It is intended for reference tables, which are read often
+ *  and changed rarely. Access to the cache is thread-safe. Example:
+ * \code
+ *  EOrmRecordCache::enable(EOrm::activeConnection(), "country");
+ *  Country *obj = new Country(7); // read from database
+ *  Country *other = new Country(7); // taken from cache
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статический класс, общий для процесса кэш записей по первичному
+ *  ключу.
+ *
+ *  Кэш включается для таблицы соединения функцией enable(). После этого
+ *  EOrmActiveRecord::load() берет значения столбцов из памяти, если они
+ *  закэшированы, иначе читает их из базы и кэширует. Записи удаляются из кэша
+ *  функциями save() и remove() объектов, EOrmActiveRecord::removeAll(),
+ *  EOrmFind::updateAll() и EOrmFind::deleteAll(). Давно не используемые
+ *  записи вытесняются при превышении бюджета памяти (см. setMaxCost()).
+ *  Значения, прочитанные внутри транзакции (см. EOrm::transaction()), не
+ *  кэшируются, а измененные в ней записи повторно удаляются при фиксации или
+ *  отмене внешней транзакции, поэтому кэш не хранит незафиксированные
+ *  значения. Для SQLite запись другими соединениями определяется по PRAGMA
+ *  data_version, которая проверяется не чаще checkInterval(), поэтому чтение
+ *  часто используемых записей не обращается к базе. Предназначен для справочных
+ *  таблиц, которые часто читаются и редко меняются. Доступ к кэшу
+ *  потокобезопасен. Пример:
+ * \code
+ *  EOrmRecordCache::enable(EOrm::activeConnection(), "country");
+ *  Country *obj = new Country(7); // чтение из базы
+ *  Country *other = new Country(7); // взято из кэша
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmRecordCache
+{
+    friend class EOrm;
+
+public:
+    static void enable(QSqlDatabase db, const QString &tableName);
+    static void disable(QSqlDatabase db, const QString &tableName);
+    static bool isEnabled(QSqlDatabase db, const QString &tableName);
+    static bool fetch(QSqlDatabase db, const QString &tableName,
+                      const QVariant &pk, QVector<QVariant> *values);
+    static void store(QSqlDatabase db, const QString &tableName,
+                      const QVariant &pk, const QVector<QVariant> &values);
+    static void invalidate(QSqlDatabase db, const QString &tableName,
+                           const QVariant &pk);
+    static void invalidate(QSqlDatabase db, const QString &tableName);
+    static void clear();
+    static int maxCost();
+    static void setMaxCost(int bytes);
+    static int checkInterval();
+    static void setCheckInterval(int msecs);
+    static qint64 hits(QSqlDatabase db, const QString &tableName);
+    static qint64 misses(QSqlDatabase db, const QString &tableName);
+
+private:
+    struct Stats {
+        Stats() : hits(0), misses(0) {}
+        qint64 hits;
+        qint64 misses;
+    };
+    struct DataVersion {
+        DataVersion() : version(-1) {}
+        qint64 version;
+        QElapsedTimer timer;
+    };
+    struct Pending {
+        QSet<QString> tables;
+        QSet<QString> records;
+    };
+
+    static QString key(QSqlDatabase db, const QString &tableName);
+    static void removeTable(const QString &tableKey);
+    static qint64 dataVersion(QSqlDatabase db, const QString &tableName);
+    static void checkDataVersion(QSqlDatabase db, qint64 version);
+    static int cost(const QVector<QVariant> &values);
+    static void finishTransaction(QSqlDatabase db);
+
+    static QCache<QString, QVector<QVariant> > m_records;
+    static QHash<QString, Stats> m_tables;
+    static QHash<QString, DataVersion> m_versions;
+    static QHash<QString, Pending> m_pending;
+    static int m_checkInterval;
+    static QMutex m_mutex;
+
+};
+
+#endif // EORMRECORDCACHE_H
@@ -0,0 +1,293 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormrowset.h"
+
+/*!
+ * \lang_en
+ * \brief Default constructor, create empty rowset without columns.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Стандартный конструктор, создает пустой набор без столбцов.
+ * \endlang
+ */
+EOrmRowSet::EOrmRowSet()
+{
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, create empty rowset with columns.
+ * \param columns - names of columns
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, создает пустой набор со столбцами.
+ * \param columns - наименования столбцов
+ * \endlang
+ */
+EOrmRowSet::EOrmRowSet(const QStringList &columns)
+{
+    Header *header = new Header;
+    header->columns = columns;
+    for (int i = 0; i < columns.count(); i++) {
+        header->indexes.insert(columns.at(i), i);
+    }
+    this->m_header = QSharedPointer<const Header>(header);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned TRUE if rowset has no rows.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает TRUE, если в наборе нет строк.
+ * \return bool
+ * \endlang
+ */
+bool EOrmRowSet::isEmpty() const
+{
+    return this->m_values.isEmpty();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of rows.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество строк.
+ * \return int
+ * \endlang
+ */
+int EOrmRowSet::count() const
+{
+    int columns = this->columnCount();
+    return columns > 0 ? this->m_values.count() / columns : 0;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of columns.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество столбцов.
+ * \return int
+ * \endlang
+ */
+int EOrmRowSet::columnCount() const
+{
+    return this->m_header.isNull() ? 0 : this->m_header->columns.count();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned names of columns.
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает наименования столбцов.
+ * \return QStringList
+ * \endlang
+ */
+QStringList EOrmRowSet::columns() const
+{
+    return this->m_header.isNull() ? QStringList() : this->m_header->columns;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned ordinal of the column, -1 if there is no such column.
+ * \param column - name of column
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает порядковый номер столбца, -1 если такого столбца нет.
+ * \param column - наименование столбца
+ * \return int
+ * \endlang
+ */
+int EOrmRowSet::indexOf(const QString &column) const
+{
+    return this->m_header.isNull() ? -1
+                                   : this->m_header->indexes.value(column, -1);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned value by row and ordinal of column.
+ * \param row - number of row
+ * \param column - ordinal of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает значение по строке и порядковому номеру столбца.
+ * \param row - номер строки
+ * \param column - порядковый номер столбца
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmRowSet::value(int row, int column) const
+{
+    int columns = this->columnCount();
+    if (row < 0 || column < 0 || column >= columns) {
+        return QVariant();
+    }
+    return this->m_values.value(row * columns + column);
+}
+
+/*!
+ * \lang_en
+ * \brief Returned value by row and name of column.
+ * \param row - number of row
+ * \param column - name of column
+ * \return QVariant
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает значение по строке и наименованию столбца.
+ * \param row - номер строки
+ * \param column - наименование столбца
+ * \return QVariant
+ * \endlang
+ */
+QVariant EOrmRowSet::value(int row, const QString &column) const
+{
+    return this->value(row, this->indexOf(column));
+}
+
+/*!
+ * \lang_en
+ * \brief Returned values of all rows, row by row.
+ * \return const QVector<QVariant> &
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает значения всех строк, по строкам.
+ * \return const QVector<QVariant> &
+ * \endlang
+ */
+const QVector<QVariant> &EOrmRowSet::values() const
+{
+    return this->m_values;
+}
+
+/*!
+ * \lang_en
+ * \brief Function reserve memory for the given count of rows.
+ * \param rows - count of rows
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция резервирует память под заданное количество строк.
+ * \param rows - количество строк
+ * \endlang
+ */
+void EOrmRowSet::reserve(int rows)
+{
+    if (rows > 0) {
+        this->m_values.reserve(rows * this->columnCount());
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function append the current row of query.
+ *
+ *  Columns of query are taken by ordinals of rowset columns.
+ * \param query - positioned on a valid row query
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция добавляет текущую строку запроса.
+ *
+ *  Столбцы запроса берутся по порядковым номерам столбцов набора.
+ * \param query - запрос, спозиционированный на строке
+ * \endlang
+ */
+void EOrmRowSet::appendRow(const QSqlQuery &query)
+{
+    int columns = this->columnCount();
+    for (int i = 0; i < columns; i++) {
+        this->m_values.append(query.value(i));
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Static function, read all rows of executed query.
+ *
+ *  Names of columns are taken from the query result.
+ * \param query - executed query
+ * \return EOrmRowSet
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция, читает все строки выполненного запроса.
+ *
+ *  Наименования столбцов берутся из результата запроса.
+ * \param query - выполненный запрос
+ * \return EOrmRowSet
+ * \endlang
+ */
+EOrmRowSet EOrmRowSet::fromQuery(QSqlQuery *query)
+{
+    QSqlRecord record = query->record();
+    QStringList columns;
+    for (int i = 0; i < record.count(); i++) {
+        columns << record.fieldName(i);
+    }
+    EOrmRowSet rows(columns);
+    rows.reserve(query->size());
+    while (query->next()) {
+        rows.appendRow(*query);
+    }
+    return rows;
+}
@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMROWSET_H
+#define EORMROWSET_H
+
+#include "eorm_global.h"
+#include <QtSql>
+
+/*!
+ * \class EOrmRowSet
+ *
+ * \lang_en
+ * \brief Compact result of selection, rows of values without objects.
+ *
+ *  Values of all rows are stored in one flat vector row by row, names of
+ *  columns are stored once in the header shared by all copies of rowset. It
+ *  is used for reports, where values are needed only and creation of objects
+ *  is too expensive. Example:
+ * \code
+ *  EOrmRowSet rows = EOrmFind::find()->select(QStringList() << "name")
+ *                                    ->rows<Test>();
+ *  int name = rows.indexOf("name");
+ *  for (int i = 0; i < rows.count(); i++) {
+ *      qDebug() << rows.value(i, name).toString();
+ *  }
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Компактный результат выборки, строки значений без объектов.
+ *
+ *  Значения всех строк хранятся в одном плоском векторе по строкам,
+ *  наименования столбцов хранятся один раз в заголовке, общем для всех копий
+ *  набора. Используется для отчетов, где нужны только значения, а создание
+ *  объектов слишком дорого. Пример:
+ * \code
+ *  EOrmRowSet rows = EOrmFind::find()->select(QStringList() << "name")
+ *                                    ->rows<Test>();
+ *  int name = rows.indexOf("name");
+ *  for (int i = 0; i < rows.count(); i++) {
+ *      qDebug() << rows.value(i, name).toString();
+ *  }
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmRowSet
+{
+
+public:
+    EOrmRowSet();
+    explicit EOrmRowSet(const QStringList &columns);
+    bool isEmpty() const;
+    int count() const;
+    int columnCount() const;
+    QStringList columns() const;
+    int indexOf(const QString &column) const;
+    QVariant value(int row, int column) const;
+    QVariant value(int row, const QString &column) const;
+    const QVector<QVariant> &values() const;
+    void reserve(int rows);
+    void appendRow(const QSqlQuery &query);
+    static EOrmRowSet fromQuery(QSqlQuery *query);
+
+private:
+    struct Header {
+        QStringList columns;
+        QHash<QString, int> indexes;
+    };
+
+    QSharedPointer<const Header> m_header;
+    QVector<QVariant> m_values;
+
+};
+
+#endif // EORMROWSET_H
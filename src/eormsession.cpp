@@ -0,0 +1,322 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormsession.h"
+
+/*!
+ * \lang_en
+ * \brief Default constructor, create session on active connection.
+ * \param parent - parent QObject
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Стандартный конструктор, создает сессию на активном соединении.
+ * \param parent - родительский QObject
+ * \endlang
+ */
+EOrmSession::EOrmSession(QObject *parent) :
+    QObject(parent)
+{
+    this->m_db = EOrm::activeConnection();
+}
+
+/*!
+ * \lang_en
+ * \brief Constructor, create session on connection.
+ * \param db - connection
+ * \param parent - parent QObject
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Конструктор, создает сессию на соединении.
+ * \param db - соединение
+ * \param parent - родительский QObject
+ * \endlang
+ */
+EOrmSession::EOrmSession(QSqlDatabase db, QObject *parent) :
+    QObject(parent)
+{
+    this->m_db = db;
+}
+
+/*!
+ * \lang_en
+ * \brief Function register object for saving.
+ *
+ *  New object will be inserted, existing object will be updated if it has
+ *  changed columns at the moment of flush.
+ * \param obj - object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция регистрирует объект для сохранения.
+ *
+ *  Новый объект будет добавлен, существующий объект будет обновлен, если на
+ *  момент сохранения у него есть измененные столбцы.
+ * \param obj - объект
+ * \return bool
+ * \endlang
+ */
+bool EOrmSession::add(EOrmActiveRecord *obj)
+{
+    if (obj == 0) {
+        return false;
+    }
+    if (obj->db().connectionName() != this->m_db.connectionName()) {
+        EOrm::throwError(37, "Session: Object uses other connection");
+    }
+    if (this->m_saved.contains(obj) || this->m_removed.contains(obj)) {
+        return false;
+    }
+    this->registerTable(obj);
+    this->m_saved << obj;
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function register object for removal.
+ *
+ *  New object is only unregistered from saving.
+ * \param obj - object
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция регистрирует объект для удаления.
+ *
+ *  Новый объект только снимается с регистрации для сохранения.
+ * \param obj - объект
+ * \return bool
+ * \endlang
+ */
+bool EOrmSession::remove(EOrmActiveRecord *obj)
+{
+    if (obj == 0) {
+        return false;
+    }
+    if (obj->db().connectionName() != this->m_db.connectionName()) {
+        EOrm::throwError(37, "Session: Object uses other connection");
+    }
+    this->m_saved.removeAll(obj);
+    if (obj->isNew() || this->m_removed.contains(obj)) {
+        return true;
+    }
+    this->registerTable(obj);
+    this->m_removed << obj;
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function save all registered objects in one transaction.
+ *
+ *  Objects are grouped by tables. New objects are inserted by
+ *  EOrmActiveRecord::insertAll(), changed objects are updated without
+ *  reloading by batches of objects with the same set of changed columns,
+ *  removed objects are deleted by EOrmActiveRecord::removeAll(). On success
+ *  registrations are cleared. On error the transaction is rolled back,
+ *  registrations are kept and objects get back their state before flush, so
+ *  flush can be repeated.
+ * \return bool
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция сохраняет все зарегистрированные объекты в одной транзакции.
+ *
+ *  Объекты группируются по таблицам. Новые объекты добавляются функцией
+ *  EOrmActiveRecord::insertAll(), измененные объекты обновляются без
+ *  перезагрузки пакетами объектов с одинаковым набором измененных столбцов,
+ *  удаляемые объекты удаляются функцией EOrmActiveRecord::removeAll(). При
+ *  успехе регистрации очищаются. При ошибке транзакция откатывается,
+ *  регистрации сохраняются, а объекты получают обратно свое состояние до
+ *  сохранения, поэтому сохранение можно повторить.
+ * \return bool
+ * \endlang
+ */
+bool EOrmSession::flush()
+{
+    QList<EOrmActiveRecord*> inserted;
+    QList<EOrmActiveRecord*> updated;
+    QList<EOrmActiveRecord*> removed;
+    foreach (QString tableName, this->m_tables) {
+        foreach (QPointer<EOrmActiveRecord> obj, this->m_saved) {
+            if (obj.isNull() || obj->tableName() != tableName) {
+                continue;
+            }
+            if (obj->isNew()) {
+                inserted << obj.data();
+            } else if (obj->isDirty()) {
+                updated << obj.data();
+            }
+        }
+    }
+    for (int i = this->m_tables.count() - 1; i >= 0; i--) {
+        foreach (QPointer<EOrmActiveRecord> obj, this->m_removed) {
+            if (!obj.isNull() && !obj->isNew()
+                    && obj->tableName() == this->m_tables.at(i)) {
+                removed << obj.data();
+            }
+        }
+    }
+    if (inserted.isEmpty() && updated.isEmpty() && removed.isEmpty()) {
+        this->clear();
+        return true;
+    }
+    // objects are changed by writes, their state is restored on rollback
+    QList<EOrmActiveRecord*> objects = inserted + updated + removed;
+    QList<EOrmActiveRecord::State> states;
+    foreach (EOrmActiveRecord *obj, objects) {
+        states << obj->state();
+    }
+    EOrm::transaction(this->m_db);
+    try {
+        if (!EOrmActiveRecord::insertAll(inserted)) {
+            EOrm::throwError(38, "Session: Objects inserting failed");
+        }
+        if (!EOrmActiveRecord::updateChanged(updated)) {
+            EOrm::throwError(39, "Session: Object updating failed");
+        }
+        if (!EOrmActiveRecord::removeAll(removed)) {
+            EOrm::throwError(40, "Session: Objects removing failed");
+        }
+    } catch (...) {
+        EOrm::rollback(this->m_db);
+        this->restore(objects, states);
+        throw;
+    }
+    if (!EOrm::commit(this->m_db)) {
+        this->restore(objects, states);
+        return false;
+    }
+    this->clear();
+    return true;
+}
+
+/*!
+ * \lang_en
+ * \brief Function clear all registrations without saving.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция очищает все регистрации без сохранения.
+ * \endlang
+ */
+void EOrmSession::clear()
+{
+    this->m_saved.clear();
+    this->m_removed.clear();
+    this->m_tables.clear();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of registered objects.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество зарегистрированных объектов.
+ * \return int
+ * \endlang
+ */
+int EOrmSession::count() const
+{
+    return this->m_saved.count() + this->m_removed.count();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned connection of session.
+ * \return QSqlDatabase
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает соединение сессии.
+ * \return QSqlDatabase
+ * \endlang
+ */
+QSqlDatabase EOrmSession::db() const
+{
+    return this->m_db;
+}
+
+/*!
+ * \lang_en
+ * \brief Function remember table of object for ordering of flush.
+ * \param obj - object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция запоминает таблицу объекта для упорядочивания сохранения.
+ * \param obj - объект
+ * \endlang
+ */
+void EOrmSession::registerTable(EOrmActiveRecord *obj)
+{
+    QString tableName = obj->tableName();
+    if (!this->m_tables.contains(tableName)) {
+        this->m_tables << tableName;
+    }
+}
+
+/*!
+ * \lang_en
+ * \brief Function restore state of objects after rollback of flush.
+ * \param objects - objects of flush
+ * \param states - states of objects before flush
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция восстанавливает состояние объектов после отката
+ *  сохранения.
+ * \param objects - объекты сохранения
+ * \param states - состояния объектов до сохранения
+ * \endlang
+ */
+void EOrmSession::restore(const QList<EOrmActiveRecord*> &objects,
+                          const QList<EOrmActiveRecord::State> &states)
+{
+    for (int i = 0; i < objects.count(); i++) {
+        objects.at(i)->restore(states.at(i));
+    }
+}
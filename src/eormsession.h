@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMSESSION_H
+#define EORMSESSION_H
+
+#include "eorm_global.h"
+#include <QObject>
+#include <QPointer>
+#include "eormactiverecord.h"
+
+/*!
+ * \class EOrmSession
+ *
+ * \lang_en
+ * \brief Class of the unit of work, collects changes of objects and saves them
+ *  by one transaction.
+ *
+ *  Objects are registered by add() and remove() functions, the database is not
+ *  touched until flush() is called. Flush inserts new objects by batches,
+ *  updates changed columns of existing objects and removes objects by batches,
+ *  all in one transaction. Tables are processed in order of their first
+ *  registration, removal goes in the reverse order, so parent objects have to
+ *  be registered before their children. All objects must use connection of
+ *  the session. Example:
+ * \code
+ *  EOrmSession session;
+ *  Test *obj = new Test;
+ *  obj->setValue("name", "test");
+ *  session.add(obj);
+ *  session.remove(other);
+ *  session.flush();
+ * \endcode
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Класс единицы работы, собирает изменения объектов и сохраняет их
+ *  одной транзакцией.
+ *
+ *  Объекты регистрируются функциями add() и remove(), к базе данных не
+ *  происходит обращений до вызова flush(). Сохранение добавляет новые объекты
+ *  пакетами, обновляет измененные столбцы существующих объектов и удаляет
+ *  объекты пакетами, все в одной транзакции. Таблицы обрабатываются в порядке
+ *  их первой регистрации, удаление идет в обратном порядке, поэтому
+ *  родительские объекты должны регистрироваться раньше дочерних. Все объекты
+ *  должны использовать соединение сессии. Пример:
+ * \code
+ *  EOrmSession session;
+ *  Test *obj = new Test;
+ *  obj->setValue("name", "test");
+ *  session.add(obj);
+ *  session.remove(other);
+ *  session.flush();
+ * \endcode
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EOrmSession(QObject *parent = 0);
+    explicit EOrmSession(QSqlDatabase db, QObject *parent = 0);
+    bool add(EOrmActiveRecord *obj);
+    bool remove(EOrmActiveRecord *obj);
+    bool flush();
+    void clear();
+    int count() const;
+    QSqlDatabase db() const;
+
+private:
+    void registerTable(EOrmActiveRecord *obj);
+    void restore(const QList<EOrmActiveRecord*> &objects,
+                 const QList<EOrmActiveRecord::State> &states);
+    QList<QPointer<EOrmActiveRecord> > m_saved;
+    QList<QPointer<EOrmActiveRecord> > m_removed;
+    QStringList m_tables;
+    QSqlDatabase m_db;
+
+};
+
+#endif // EORMSESSION_H
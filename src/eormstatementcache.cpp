@@ -0,0 +1,475 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "eormstatementcache.h"
+
+/*!
+ * \lang_en
+ * \brief Initialization of the cache. By default up to 256 statements are kept
+ *  for every connection.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Инициализация кэша. По-умолчанию для каждого соединения хранится до
+ *  256 запросов.
+ * \endlang
+ */
+QHash<QString, EOrmStatementCache::Statements>
+EOrmStatementCache::m_connections;
+QMutex EOrmStatementCache::m_mutex;
+int EOrmStatementCache::m_capacity = 256;
+
+/*!
+ * \lang_en
+ * \brief Function returned prepared statement.
+ *
+ *  If the statement for such table, operation and columns was already
+ *  prepared on the connection, it is returned with old bound values, which
+ *  should be replaced by caller. Otherwise the statement is prepared and
+ *  stored. If preparing failed, null pointer is returned. Statement should
+ *  be released by QSqlQuery::finish() after use.
+ * \param db - a database object
+ * \param operation - type of statement
+ * \param tableName - name of the table
+ * \param primaryKeyName - name of primary key
+ * \param columns - list of columns
+ * \param rows - count of rows, only for Insert and Delete
+ * \param returning - list of columns returned by the statement
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает подготовленный запрос.
+ *
+ *  Если запрос для такой таблицы, операции и столбцов уже подготавливался на
+ *  данном соединении, он возвращается со старыми значениями параметров,
+ *  которые вызывающая сторона должна заменить. Иначе запрос подготавливается
+ *  и сохраняется. Если подготовить запрос не удалось, возвращается нулевой
+ *  указатель. После использования запрос нужно освободить функцией
+ *  QSqlQuery::finish().
+ * \param db - объект базы данных
+ * \param operation - тип запроса
+ * \param tableName - имя таблицы
+ * \param primaryKeyName - наименование первичного ключа
+ * \param columns - список столбцов
+ * \param rows - количество строк, только для Insert и Delete
+ * \param returning - список столбцов, возвращаемых запросом
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ */
+QSharedPointer<QSqlQuery> EOrmStatementCache::statement(
+        QSqlDatabase db, Operation operation, const QString &tableName,
+        const QString &primaryKeyName, const QStringList &columns, int rows,
+        const QStringList &returning)
+{
+    QString key = QString::number(operation) + QLatin1Char('|') + tableName
+            + QLatin1Char('|') + primaryKeyName + QLatin1Char('|')
+            + columns.join(",") + QLatin1Char('|') + QString::number(rows)
+            + QLatin1Char('|') + returning.join(",");
+    QSharedPointer<QSqlQuery> query = EOrmStatementCache::lookup(db, key);
+    if (!query.isNull()) {
+        return query;
+    }
+    query = QSharedPointer<QSqlQuery>(new QSqlQuery(db));
+    if (!query->prepare(EOrmStatementCache::sql(operation, tableName,
+                                                primaryKeyName, columns,
+                                                rows, returning))) {
+        return QSharedPointer<QSqlQuery>();
+    }
+    EOrmStatementCache::insert(db, key, query);
+    return query;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned prepared statement by SQL code.
+ *
+ *  It is similar statement() for objects, it is used by EOrmFind. Statement
+ *  should be released by QSqlQuery::finish() after use.
+ * \param db - a database object
+ * \param sql - SQL code with placeholders
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает подготовленный запрос по SQL-коду.
+ *
+ *  Аналогична statement() для объектов, используется в EOrmFind. После
+ *  использования запрос нужно освободить функцией QSqlQuery::finish().
+ * \param db - объект базы данных
+ * \param sql - SQL-код с плейсхолдерами
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ */
+QSharedPointer<QSqlQuery> EOrmStatementCache::statement(QSqlDatabase db,
+                                                        const QString &sql)
+{
+    QString key = QLatin1String("sql|") + sql;
+    QSharedPointer<QSqlQuery> query = EOrmStatementCache::lookup(db, key);
+    if (!query.isNull()) {
+        return query;
+    }
+    query = QSharedPointer<QSqlQuery>(new QSqlQuery(db));
+    if (!query->prepare(sql)) {
+        return QSharedPointer<QSqlQuery>();
+    }
+    EOrmStatementCache::insert(db, key, query);
+    return query;
+}
+
+/*!
+ * \lang_en
+ * \brief Function returned stored statement and counted hit or miss.
+ *
+ *  Found statement is marked as the most recently used.
+ * \param db - a database object
+ * \param key - key of the statement
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция возвращает сохраненный запрос и учитывает попадание или
+ *  промах.
+ *
+ *  Найденный запрос отмечается как использованный последним.
+ * \param db - объект базы данных
+ * \param key - ключ запроса
+ * \return QSharedPointer<QSqlQuery>
+ * \endlang
+ */
+QSharedPointer<QSqlQuery> EOrmStatementCache::lookup(QSqlDatabase db,
+                                                     const QString &key)
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    Statements &statements =
+            EOrmStatementCache::m_connections[db.connectionName()];
+    QHash<QString, Entry>::iterator it = statements.queries.find(key);
+    if (it == statements.queries.end()) {
+        statements.misses++;
+        return QSharedPointer<QSqlQuery>();
+    }
+    statements.hits++;
+    it.value().used = ++statements.tick;
+    return it.value().query;
+}
+
+/*!
+ * \lang_en
+ * \brief Function store prepared statement.
+ *
+ *  If capacity is reached, the least recently used statements of the
+ *  connection are released one by one, other statements stay prepared.
+ * \param db - a database object
+ * \param key - key of the statement
+ * \param query - prepared statement
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция сохраняет подготовленный запрос.
+ *
+ *  Если достигнута емкость, дольше всех не использованные запросы
+ *  соединения освобождаются по одному, остальные запросы остаются
+ *  подготовленными.
+ * \param db - объект базы данных
+ * \param key - ключ запроса
+ * \param query - подготовленный запрос
+ * \endlang
+ */
+void EOrmStatementCache::insert(QSqlDatabase db, const QString &key,
+                                QSharedPointer<QSqlQuery> query)
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    Statements &statements =
+            EOrmStatementCache::m_connections[db.connectionName()];
+    while (!statements.queries.isEmpty()
+           && statements.queries.count() >= EOrmStatementCache::m_capacity) {
+        QHash<QString, Entry>::iterator oldest = statements.queries.begin();
+        QHash<QString, Entry>::iterator it = statements.queries.begin();
+        for (; it != statements.queries.end(); ++it) {
+            if (it.value().used < oldest.value().used) {
+                oldest = it;
+            }
+        }
+        statements.queries.erase(oldest);
+    }
+    Entry entry;
+    entry.query = query;
+    entry.used = ++statements.tick;
+    statements.queries.insert(key, entry);
+}
+
+/*!
+ * \lang_en
+ * \brief Function generated SQL code of the statement.
+ *
+ *  For Select columns are selected by primary key, for Insert columns are
+ *  inserted, for Update columns are updated by primary key, for Delete
+ *  columns are not used. Values are substituted with placeholders "?" in
+ *  order of columns, the primary key placeholder is the last. Insert of
+ *  several rows lists placeholders row by row, insert without columns uses
+ *  default values, delete of several rows lists primary keys. If returning
+ *  columns are set, they are returned by the statement with RETURNING
+ *  clause.
+ * \param operation - type of statement
+ * \param tableName - name of the table
+ * \param primaryKeyName - name of primary key
+ * \param columns - list of columns
+ * \param rows - count of rows, only for Insert and Delete
+ * \param returning - list of columns returned by the statement
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция формирует SQL-код запроса.
+ *
+ *  Для Select столбцы выбираются по первичному ключу, для Insert столбцы
+ *  добавляются, для Update столбцы обновляются по первичному ключу, для
+ *  Delete столбцы не используются. Значения замещаются плейсхолдерами "?" в
+ *  порядке столбцов, плейсхолдер первичного ключа последний. При добавлении
+ *  нескольких строк плейсхолдеры перечисляются по строкам, добавление без
+ *  столбцов использует значения по-умолчанию, при удалении нескольких строк
+ *  перечисляются первичные ключи. Если заданы возвращаемые столбцы, запрос
+ *  возвращает их с помощью блока RETURNING.
+ * \param operation - тип запроса
+ * \param tableName - имя таблицы
+ * \param primaryKeyName - наименование первичного ключа
+ * \param columns - список столбцов
+ * \param rows - количество строк, только для Insert и Delete
+ * \param returning - список столбцов, возвращаемых запросом
+ * \return QString
+ * \endlang
+ */
+QString EOrmStatementCache::sql(Operation operation, const QString &tableName,
+                                const QString &primaryKeyName,
+                                const QStringList &columns, int rows,
+                                const QStringList &returning)
+{
+    QStringList sql;
+    switch (operation) {
+    case Select:
+        sql << "SELECT";
+        sql << columns.join(",");
+        sql << "FROM";
+        sql << tableName;
+        sql << "WHERE";
+        sql << primaryKeyName + " = ?";
+        break;
+    case Insert:
+        sql << "INSERT INTO";
+        sql << tableName;
+        if (columns.isEmpty()) {
+            sql << "DEFAULT VALUES";
+        } else {
+            QString row = "(" + EOrmStatementCache::placeholders(
+                        columns.count()) + ")";
+            QStringList values;
+            for (int i = 0; i < qMax(1, rows); i++) {
+                values << row;
+            }
+            sql << "(" + columns.join(",") + ")";
+            sql << "VALUES";
+            sql << values.join(",");
+        }
+        break;
+    case Update:
+        sql << "UPDATE";
+        sql << tableName;
+        sql << "SET";
+        sql << columns.join(" = ?, ") + " = ?";
+        sql << "WHERE";
+        sql << primaryKeyName + " = ?";
+        break;
+    case Delete:
+        sql << "DELETE FROM";
+        sql << tableName;
+        sql << "WHERE";
+        if (rows > 1) {
+            sql << primaryKeyName + " IN ("
+                   + EOrmStatementCache::placeholders(rows) + ")";
+        } else {
+            sql << primaryKeyName + " = ?";
+        }
+        break;
+    }
+    if (!returning.isEmpty()) {
+        sql << "RETURNING";
+        sql << returning.join(",");
+    }
+    return sql.join(" ");
+}
+
+/*!
+ * \lang_en
+ * \brief Function substitute variables with placeholders.
+ *
+ *  Returned a line from "?", enumerat through a comma, an amount equal
+ *  to count. It are necessary for convenience of operation with a database.
+ * \param count - count of placeholders (as a rule properties of object)
+ * \return QString
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция замещения переменных плейсхолдерами.
+ *
+ *  Возвращает строчку из "?", перечисленных через запятую, количеством,
+ *  равным count. Нужна для удобства работы с базой данных.
+ * \param count - количество плейсхолдеров (как правило свойств объекта)
+ * \return QString
+ * \endlang
+ */
+QString EOrmStatementCache::placeholders(int count)
+{
+    QStringList phList;
+    for (int i = 0; i < count; i++) {
+        phList << "?";
+    }
+    return phList.join(",");
+}
+
+/*!
+ * \lang_en
+ * \brief Function released statements and counters of the connection.
+ * \param db - a database object
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция освобождает запросы и счетчики соединения.
+ * \param db - объект базы данных
+ * \endlang
+ */
+void EOrmStatementCache::clear(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    EOrmStatementCache::m_connections.remove(db.connectionName());
+}
+
+/*!
+ * \lang_en
+ * \brief Function released statements and counters of all connections.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция освобождает запросы и счетчики всех соединений.
+ * \endlang
+ */
+void EOrmStatementCache::clear()
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    EOrmStatementCache::m_connections.clear();
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of statements found in cache for the connection.
+ * \param db - a database object
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество запросов, найденных в кэше для соединения.
+ * \param db - объект базы данных
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmStatementCache::hits(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    return EOrmStatementCache::m_connections.value(db.connectionName()).hits;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned count of statements prepared for the connection.
+ * \param db - a database object
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает количество запросов, подготовленных для соединения.
+ * \param db - объект базы данных
+ * \return qint64
+ * \endlang
+ */
+qint64 EOrmStatementCache::misses(QSqlDatabase db)
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    return EOrmStatementCache::m_connections.value(db.connectionName()).misses;
+}
+
+/*!
+ * \lang_en
+ * \brief Returned the maximum count of statements kept for one connection.
+ * \return int
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Возвращает максимальное количество запросов одного соединения.
+ * \return int
+ * \endlang
+ */
+int EOrmStatementCache::capacity()
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    return EOrmStatementCache::m_capacity;
+}
+
+/*!
+ * \lang_en
+ * \brief Set the maximum count of statements kept for one connection.
+ *
+ *  When the limit is reached, the least recently used statement of the
+ *  connection is released before a new one is stored.
+ * \param capacity - count of statements
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Устанавливает максимальное количество запросов одного соединения.
+ *
+ *  При достижении предела перед сохранением нового запроса освобождается
+ *  дольше всех не использованный запрос соединения.
+ * \param capacity - количество запросов
+ * \endlang
+ */
+void EOrmStatementCache::setCapacity(int capacity)
+{
+    QMutexLocker locker(&EOrmStatementCache::m_mutex);
+    EOrmStatementCache::m_capacity = qMax(1, capacity);
+}
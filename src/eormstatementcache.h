@@ -0,0 +1,134 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EORMSTATEMENTCACHE_H
+#define EORMSTATEMENTCACHE_H
+
+#include "eorm_global.h"
+#include <QtSql>
+
+/*!
+ * \class EOrmStatementCache
+ *
+ * \lang_en
+ * \brief The static class, cache of prepared statements of objects.
+ *
+ *  Statements used by EOrmActiveRecord for loading, inserting, updating and
+ *  removing are prepared once per connection and then are reused with new
+ *  bound values. Statement is identified by table, operation and list of
+ *  columns. Statements of EOrmFind with bound values are identified by SQL
+ *  code. Up to capacity() statements are kept for every connection, when it
+ *  is reached the least recently used statement is released. For every
+ *  connection the counters of hits and misses are kept. Before removing
+ *  connection with QSqlDatabase::removeDatabase() its statements should be
+ *  released by clear().
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статический класс, кэш подготовленных запросов объектов.
+ *
+ *  Запросы, которые EOrmActiveRecord использует для загрузки, добавления,
+ *  обновления и удаления, подготавливаются один раз для соединения и далее
+ *  используются повторно с новыми значениями параметров. Запрос определяется
+ *  таблицей, операцией и списком столбцов. Запросы EOrmFind со значениями
+ *  параметров определяются SQL-кодом. Для каждого соединения хранится до
+ *  capacity() запросов, при достижении предела освобождается дольше всех не
+ *  использованный запрос. Для каждого соединения ведутся счетчики попаданий
+ *  и промахов. Перед удалением соединения функцией
+ *  QSqlDatabase::removeDatabase() его запросы нужно освободить функцией
+ *  clear().
+ * \endlang
+ */
+class EORMSHARED_EXPORT EOrmStatementCache
+{
+
+public:
+    enum Operation { Select, Insert, Update, Delete };
+    static QSharedPointer<QSqlQuery> statement(QSqlDatabase db,
+                                               Operation operation,
+                                               const QString &tableName,
+                                               const QString &primaryKeyName,
+                                               const QStringList &columns,
+                                               int rows = 1,
+                                               const QStringList &returning =
+                                               QStringList());
+    static QSharedPointer<QSqlQuery> statement(QSqlDatabase db,
+                                               const QString &sql);
+    static QString sql(Operation operation, const QString &tableName,
+                       const QString &primaryKeyName,
+                       const QStringList &columns, int rows = 1,
+                       const QStringList &returning = QStringList());
+    static QString placeholders(int count);
+    static void clear(QSqlDatabase db);
+    static void clear();
+    static qint64 hits(QSqlDatabase db);
+    static qint64 misses(QSqlDatabase db);
+    static int capacity();
+    static void setCapacity(int capacity);
+
+private:
+    struct Entry
+    {
+        Entry() : used(0) {}
+        QSharedPointer<QSqlQuery> query;
+        quint64 used;
+    };
+    struct Statements
+    {
+        Statements() : hits(0), misses(0), tick(0) {}
+        QHash<QString, Entry> queries;
+        qint64 hits;
+        qint64 misses;
+        quint64 tick;
+    };
+
+    static QSharedPointer<QSqlQuery> lookup(QSqlDatabase db,
+                                            const QString &key);
+    static void insert(QSqlDatabase db, const QString &key,
+                       QSharedPointer<QSqlQuery> query);
+
+    static QHash<QString, Statements> m_connections;
+    static QMutex m_mutex;
+    static int m_capacity;
+
+};
+
+#endif // EORMSTATEMENTCACHE_H
@@ -0,0 +1,17 @@
+QT       += sql testlib
+
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_eormfind
+
+TEMPLATE = app
+
+SOURCES += tst_eormfind.cpp
+
+LIBS += -L../../src/ -leorm
+
+INCLUDEPATH += ../../src
+DEPENDPATH += ../../src
@@ -0,0 +1,247 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "eormfind.h"
+#include "eormstatementcache.h"
+
+/*!
+ * \lang_en
+ * \class Person
+ * \brief Test object of the table person.
+ * \endlang
+ *
+ * \lang_ru
+ * \class Person
+ * \brief Тестовый объект таблицы person.
+ * \endlang
+ */
+class Person : public EOrmActiveRecord
+{
+public:
+    Person() { this->init(QSqlDatabase::database("tst_find")); }
+    QString tableName() { return "person"; }
+    QString primaryKeyName() { return "id"; }
+};
+
+/*!
+ * \lang_en
+ * \class tst_EOrmFind
+ * \brief Tests of conditions of EOrmFind with bound values.
+ *
+ *  Placeholders are searched in SQL code of every driver, selection is
+ *  checked on in-memory SQLite database.
+ * \endlang
+ *
+ * \lang_ru
+ * \class tst_EOrmFind
+ * \brief Тесты условий EOrmFind со значениями параметров.
+ *
+ *  Плейсхолдеры ищутся в SQL-коде каждого драйвера, выборка проверяется на
+ *  базе SQLite в памяти.
+ * \endlang
+ */
+class tst_EOrmFind : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void placeholders_data();
+    void placeholders();
+    void percentValue();
+    void cleanupTestCase();
+};
+
+/*!
+ * \lang_en
+ * \brief Function opened in-memory SQLite database with test table.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция открывает базу SQLite в памяти с тестовой таблицей.
+ * \endlang
+ */
+void tst_EOrmFind::initTestCase()
+{
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        return;
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "tst_find");
+    db.setDatabaseName(":memory:");
+    QVERIFY(db.open());
+    QSqlQuery qr(db);
+    QVERIFY(qr.exec("CREATE TABLE person (id INTEGER PRIMARY KEY,"
+                    " name TEXT)"));
+}
+
+/*!
+ * \lang_en
+ * \brief Function set SQL expressions with every kind of skipped text.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция задает SQL-выражения с каждым видом пропускаемого текста.
+ * \endlang
+ */
+void tst_EOrmFind::placeholders_data()
+{
+    QTest::addColumn<QString>("driver");
+    QTest::addColumn<QString>("expression");
+    QTest::addColumn<QStringList>("names");
+    QTest::addColumn<QString>("positional");
+
+    QTest::newRow("single quotes") << "QSQLITE"
+        << "name = 'a ? :b' AND id = :id"
+        << (QStringList() << "id")
+        << "name = 'a ? :b' AND id = ?";
+    QTest::newRow("double quotes") << "QPSQL"
+        << "\"a ? :b\" = :name"
+        << (QStringList() << "name")
+        << "\"a ? :b\" = ?";
+    QTest::newRow("line comment") << "QPSQL"
+        << "id = ? -- :id or ?\nAND name = ?"
+        << (QStringList() << "?" << "?")
+        << "id = ? -- :id or ?\nAND name = ?";
+    QTest::newRow("block comment") << "QPSQL"
+        << "id = :id /* ? :name */ AND name = :name"
+        << (QStringList() << "id" << "name")
+        << "id = ? /* ? :name */ AND name = ?";
+    QTest::newRow("dollar quotes") << "QPSQL"
+        << "name = $tag$ ? :id $tag$ AND id = :id"
+        << (QStringList() << "id")
+        << "name = $tag$ ? :id $tag$ AND id = ?";
+    QTest::newRow("cast") << "QPSQL"
+        << "id::text = :id"
+        << (QStringList() << "id")
+        << "id::text = ?";
+    QTest::newRow("backticks") << "QMYSQL"
+        << "`a ? :b` = :name"
+        << (QStringList() << "name")
+        << "`a ? :b` = ?";
+    QTest::newRow("brackets") << "QSQLITE"
+        << "[a ? :b] = :name"
+        << (QStringList() << "name")
+        << "[a ? :b] = ?";
+    QTest::newRow("array subscript") << "QPSQL"
+        << "tags[?] = :tag"
+        << (QStringList() << "?" << "tag")
+        << "tags[?] = ?";
+    QTest::newRow("array element") << "QPSQL"
+        << "a[1] = ?"
+        << (QStringList() << "?")
+        << "a[1] = ?";
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked found placeholders and expression with positional
+ *  placeholders.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет найденные плейсхолдеры и выражение с
+ *  позиционными плейсхолдерами.
+ * \endlang
+ */
+void tst_EOrmFind::placeholders()
+{
+    QFETCH(QString, driver);
+    QFETCH(QString, expression);
+    QFETCH(QStringList, names);
+    QFETCH(QString, positional);
+
+    QString result;
+    QCOMPARE(EOrmFind::placeholders(expression, driver, &result), names);
+    QCOMPARE(result, positional);
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that bound value with "%1" and placeholders is
+ *  compared as is and does not change SQL code.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что значение параметра с "%1" и плейсхолдерами
+ *  сравнивается как есть и не меняет SQL-код.
+ * \endlang
+ */
+void tst_EOrmFind::percentValue()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_find");
+    if (!db.isOpen()) {
+        QSKIP("QSQLITE driver is not available");
+    }
+    QString name = "%1 :name ?";
+    QSqlQuery qr(db);
+    QVERIFY(qr.prepare("INSERT INTO person (name) VALUES (?)"));
+    qr.addBindValue(name);
+    QVERIFY(qr.exec());
+    QVariantMap params;
+    params.insert("name", name);
+    Person *person = EOrmFind::find(db)->where("name = :name", params)
+                                       ->one<Person>();
+    QVERIFY(person != 0);
+    QCOMPARE(person->value("name").toString(), name);
+    delete person;
+}
+
+/*!
+ * \lang_en
+ * \brief Function released cached statements and closed the database.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция освобождает кэшированные запросы и закрывает базу.
+ * \endlang
+ */
+void tst_EOrmFind::cleanupTestCase()
+{
+    EOrmStatementCache::clear();
+    QSqlDatabase::removeDatabase("tst_find");
+}
+
+QTEST_GUILESS_MAIN(tst_EOrmFind)
+
+#include "tst_eormfind.moc"
@@ -0,0 +1,175 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "eormfind.h"
+#include "eormquerycache.h"
+
+/*!
+ * \lang_en
+ * \class tst_EOrmQueryCache
+ * \brief Tests of keys of results in EOrmQueryCache.
+ *
+ *  Results are stored for SQL code selected from in-memory SQLite database.
+ * \endlang
+ *
+ * \lang_ru
+ * \class tst_EOrmQueryCache
+ * \brief Тесты ключей результатов в EOrmQueryCache.
+ *
+ *  Результаты сохраняются для SQL-кода, выбранного из базы SQLite в памяти.
+ * \endlang
+ */
+class tst_EOrmQueryCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void literalWhitespace();
+    void nonPositiveTtl();
+    void cleanupTestCase();
+};
+
+/*!
+ * \lang_en
+ * \brief Function opened in-memory SQLite database.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция открывает базу SQLite в памяти.
+ * \endlang
+ */
+void tst_EOrmQueryCache::initTestCase()
+{
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("QSQLITE driver is not available");
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "tst_querycache");
+    db.setDatabaseName(":memory:");
+    QVERIFY(db.open());
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that queries which differ only by whitespaces
+ *  inside a string literal have different results in cache.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что запросы, различающиеся только пробелами
+ *  внутри строкового литерала, имеют разные результаты в кэше.
+ * \endlang
+ */
+void tst_EOrmQueryCache::literalWhitespace()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_querycache");
+    QString wide = "SELECT 'a  b' AS name";
+    QString narrow = "SELECT 'a b' AS name";
+    QSqlQuery qr(db);
+    QVERIFY(qr.exec(wide));
+    EOrmRowSet rows = EOrmRowSet::fromQuery(&qr);
+    qr.finish();
+    QCOMPARE(rows.value(0, 0).toString(), QString("a  b"));
+    EOrmQueryCache::store(db, "test", wide, QVariantList(), rows, 60000,
+                          EOrmQueryCache::generation(db, "test"));
+
+    EOrmRowSet cached;
+    QVERIFY(!EOrmQueryCache::fetch(db, "test", narrow, QVariantList(),
+                                   &cached));
+    QVERIFY(EOrmQueryCache::fetch(db, "test", wide, QVariantList(),
+                                  &cached));
+    QCOMPARE(cached.value(0, 0).toString(), QString("a  b"));
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that results with ttl less than 1 are not stored
+ *  and EOrmFind::cache() rejects such ttl.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что результаты с ttl меньше 1 не сохраняются, и
+ *  EOrmFind::cache() отклоняет такое ttl.
+ * \endlang
+ */
+void tst_EOrmQueryCache::nonPositiveTtl()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_querycache");
+    QString sql = "SELECT 'ttl' AS name";
+    QSqlQuery qr(db);
+    QVERIFY(qr.exec(sql));
+    EOrmRowSet rows = EOrmRowSet::fromQuery(&qr);
+    qr.finish();
+    EOrmQueryCache::store(db, "test", sql, QVariantList(), rows, 0,
+                          EOrmQueryCache::generation(db, "test"));
+    EOrmRowSet cached;
+    QVERIFY(!EOrmQueryCache::fetch(db, "test", sql, QVariantList(),
+                                   &cached));
+
+    EOrmFind *find = EOrmFind::find(db);
+    EOrmFind *result = find->cache(0);
+    QVERIFY(result != find);
+    delete result;
+    QVERIFY(find->cache(1) == find);
+    delete find;
+}
+
+/*!
+ * \lang_en
+ * \brief Function released cached results and closed the database.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция освобождает кэшированные результаты и закрывает базу.
+ * \endlang
+ */
+void tst_EOrmQueryCache::cleanupTestCase()
+{
+    EOrmQueryCache::clear();
+    QSqlDatabase::removeDatabase("tst_querycache");
+}
+
+QTEST_GUILESS_MAIN(tst_EOrmQueryCache)
+
+#include "tst_eormquerycache.moc"
@@ -0,0 +1,215 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "eorm.h"
+#include "eormfind.h"
+#include "eormstatementcache.h"
+
+/*!
+ * \lang_en
+ * \class Person
+ * \brief Test object of the table person.
+ * \endlang
+ *
+ * \lang_ru
+ * \class Person
+ * \brief Тестовый объект таблицы person.
+ * \endlang
+ */
+class Person : public EOrmActiveRecord
+{
+public:
+    Person() { this->init(); }
+    QString tableName() { return "person"; }
+    QString primaryKeyName() { return "id"; }
+};
+
+/*!
+ * \lang_en
+ * \class tst_EOrmRoundTrip
+ * \brief Tests of count of statements executed by selection of objects.
+ *
+ *  Statements are counted by hits and misses of EOrmStatementCache, through
+ *  which every statement with bound values is executed, so conditions of
+ *  tests have values. Metadata of the table is loaded before counting.
+ * \endlang
+ *
+ * \lang_ru
+ * \class tst_EOrmRoundTrip
+ * \brief Тесты количества запросов, выполняемых при выборке объектов.
+ *
+ *  Запросы считаются по попаданиям и промахам EOrmStatementCache, через
+ *  который выполняется каждый запрос со связанными значениями, поэтому
+ *  условия тестов имеют значения. Метаданные таблицы загружаются до подсчета.
+ * \endlang
+ */
+class tst_EOrmRoundTrip : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void all();
+    void one();
+    void cleanupTestCase();
+
+private:
+    static qint64 statements(QSqlDatabase db);
+};
+
+/*!
+ * \lang_en
+ * \brief Function opened in-memory SQLite database with filled test table.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция открывает базу SQLite в памяти с заполненной тестовой
+ *  таблицей.
+ * \endlang
+ */
+void tst_EOrmRoundTrip::initTestCase()
+{
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        QSKIP("QSQLITE driver is not available");
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "tst_roundtrip");
+    db.setDatabaseName(":memory:");
+    QVERIFY(db.open());
+    EOrm::setConnectionName("tst_roundtrip");
+    QSqlQuery qr(db);
+    QVERIFY(qr.exec("CREATE TABLE person (id INTEGER PRIMARY KEY,"
+                    " name TEXT, age INTEGER)"));
+    for (int i = 1; i <= 100; i++) {
+        QVERIFY(qr.exec(QString("INSERT INTO person (name, age)"
+                                " VALUES ('person %1', %1)").arg(i)));
+    }
+    delete new Person();
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that all() selects all objects with values by one
+ *  statement.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что all() выбирает все объекты со значениями
+ *  одним запросом.
+ * \endlang
+ */
+void tst_EOrmRoundTrip::all()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_roundtrip");
+    qint64 before = tst_EOrmRoundTrip::statements(db);
+    QList<Person*> persons = EOrmFind::find()
+            ->where("age > ?", QVariantList() << 0)->all<Person>();
+    QCOMPARE(tst_EOrmRoundTrip::statements(db) - before, qint64(1));
+    QCOMPARE(persons.count(), 100);
+    QCOMPARE(persons.last()->value("name").toString(),
+             QString("person 100"));
+    qDeleteAll(persons);
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that one() selects object with values by one
+ *  statement.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что one() выбирает объект со значениями одним
+ *  запросом.
+ * \endlang
+ */
+void tst_EOrmRoundTrip::one()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_roundtrip");
+    qint64 before = tst_EOrmRoundTrip::statements(db);
+    Person *person = EOrmFind::find()
+            ->where("age = ?", QVariantList() << 42)->one<Person>();
+    QCOMPARE(tst_EOrmRoundTrip::statements(db) - before, qint64(1));
+    QVERIFY(person != 0);
+    QCOMPARE(person->value("name").toString(), QString("person 42"));
+    delete person;
+}
+
+/*!
+ * \lang_en
+ * \brief Function closed the database.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция закрывает базу.
+ * \endlang
+ */
+void tst_EOrmRoundTrip::cleanupTestCase()
+{
+    EOrmStatementCache::clear();
+    EOrm::setConnectionName(QString());
+    QSqlDatabase::removeDatabase("tst_roundtrip");
+}
+
+/*!
+ * \lang_en
+ * \brief Static function returned count of statements executed through
+ *  statement cache of connection.
+ * \param db - a database object
+ * \return qint64
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция возвращает количество запросов, выполненных
+ *  через кэш запросов соединения.
+ * \param db - объект базы данных
+ * \return qint64
+ * \endlang
+ */
+qint64 tst_EOrmRoundTrip::statements(QSqlDatabase db)
+{
+    return EOrmStatementCache::hits(db) + EOrmStatementCache::misses(db);
+}
+
+QTEST_GUILESS_MAIN(tst_EOrmRoundTrip)
+
+#include "tst_eormroundtrip.moc"
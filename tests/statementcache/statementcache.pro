@@ -0,0 +1,17 @@
+QT       += sql testlib
+
+QT       -= gui
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_eormstatementcache
+
+TEMPLATE = app
+
+SOURCES += tst_eormstatementcache.cpp
+
+LIBS += -L../../src/ -leorm
+
+INCLUDEPATH += ../../src
+DEPENDPATH += ../../src
@@ -0,0 +1,359 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Victor Zhuk.
+** Contact: chewire@gmail.com
+**
+** This file is part of the EOrm library.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**
+**  * Redistributions of source code must retain the above copyright notice,
+**    this list of conditions and the following disclaimer.
+**
+**  * Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+**  * Neither the name of the project's author nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "eorm.h"
+#include "eormactiverecord.h"
+#include "eormstatementcache.h"
+
+/*!
+ * \lang_en
+ * \class Person
+ * \brief Test object of the table person.
+ * \endlang
+ *
+ * \lang_ru
+ * \class Person
+ * \brief Тестовый объект таблицы person.
+ * \endlang
+ */
+class Person : public EOrmActiveRecord
+{
+public:
+    Person() { this->init(QSqlDatabase::database("tst_statementcache")); }
+    QString tableName() { return "person"; }
+    QString primaryKeyName() { return "id"; }
+};
+
+/*!
+ * \lang_en
+ * \class tst_EOrmStatementCache
+ * \brief Tests of SQL code generated by EOrmStatementCache.
+ *
+ *  Insert of one object is checked for every driver: RETURNING clause with
+ *  all columns is added when EOrm::supportsReturning() allows it. QPSQL
+ *  connection is not opened, because PostgreSQL needs a server, so prepared
+ *  statements and saving of objects are checked only on in-memory SQLite
+ *  database.
+ * \endlang
+ *
+ * \lang_ru
+ * \class tst_EOrmStatementCache
+ * \brief Тесты SQL-кода, формируемого EOrmStatementCache.
+ *
+ *  Добавление одного объекта проверяется для каждого драйвера: блок RETURNING
+ *  со всеми столбцами добавляется, когда это разрешает
+ *  EOrm::supportsReturning(). Соединение QPSQL не открывается, так как
+ *  PostgreSQL требует сервер, поэтому подготовленные запросы и сохранение
+ *  объектов проверяются только на базе SQLite в памяти.
+ * \endlang
+ */
+class tst_EOrmStatementCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void insertReturning_data();
+    void insertReturning();
+    void preparedInsert_data();
+    void preparedInsert();
+    void saveReturning();
+    void leastRecentlyUsed();
+    void cleanupTestCase();
+
+private:
+    static QStringList returning(QSqlDatabase db);
+
+    bool m_sqliteReturning;
+};
+
+/*!
+ * \lang_en
+ * \brief Function opened in-memory SQLite database with test table and added
+ *  not opened connections of other drivers.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция открывает базу SQLite в памяти с тестовой таблицей и
+ *  добавляет неоткрытые соединения других драйверов.
+ * \endlang
+ */
+void tst_EOrmStatementCache::initTestCase()
+{
+    this->m_sqliteReturning = false;
+    QSqlDatabase::addDatabase("QPSQL", "tst_statementcache_QPSQL");
+    QSqlDatabase::addDatabase("QMYSQL", "tst_statementcache_QMYSQL");
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        return;
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",
+                                                "tst_statementcache");
+    db.setDatabaseName(":memory:");
+    QVERIFY(db.open());
+    QSqlQuery qr(db);
+    QVERIFY(qr.exec("CREATE TABLE person (id INTEGER PRIMARY KEY,"
+                    " name TEXT, age INTEGER NOT NULL DEFAULT 18)"));
+    QVERIFY(qr.exec("SELECT sqlite_version()") && qr.next());
+    QStringList version = qr.value(0).toString().split('.');
+    int major = version.value(0).toInt();
+    int minor = version.value(1).toInt();
+    this->m_sqliteReturning = (major > 3 || (major == 3 && minor >= 35));
+}
+
+/*!
+ * \lang_en
+ * \brief Function set insert of one object for every driver: QPSQL always
+ *  returns columns, QSQLITE starting with SQLite 3.35, QMYSQL never.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция задает добавление одного объекта для каждого драйвера:
+ *  QPSQL всегда возвращает столбцы, QSQLITE начиная с SQLite 3.35, QMYSQL
+ *  никогда.
+ * \endlang
+ */
+void tst_EOrmStatementCache::insertReturning_data()
+{
+    QTest::addColumn<QString>("driver");
+    QTest::addColumn<bool>("supported");
+    QTest::addColumn<QString>("expected");
+
+    QString insert = "INSERT INTO person (name,age) VALUES (?,?)";
+    QString returning = insert + " RETURNING id,name,age";
+    QTest::newRow("QPSQL") << "QPSQL" << true << returning;
+    if (QSqlDatabase::database("tst_statementcache").isOpen()) {
+        QTest::newRow("QSQLITE") << "QSQLITE" << this->m_sqliteReturning
+            << (this->m_sqliteReturning ? returning : insert);
+    }
+    QTest::newRow("QMYSQL") << "QMYSQL" << false << insert;
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked support of RETURNING clause by driver and SQL code
+ *  of insert of one object with full refresh.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет поддержку блока RETURNING драйвером и SQL-код
+ *  добавления одного объекта с полным обновлением.
+ * \endlang
+ */
+void tst_EOrmStatementCache::insertReturning()
+{
+    QFETCH(QString, driver);
+    QFETCH(bool, supported);
+    QFETCH(QString, expected);
+
+    QSqlDatabase db = QSqlDatabase::database(driver == "QSQLITE"
+                                             ? "tst_statementcache"
+                                             : "tst_statementcache_" + driver,
+                                             false);
+    QCOMPARE(EOrm::supportsReturning(db), supported);
+    QStringList columns;
+    columns << "name" << "age";
+    QCOMPARE(EOrmStatementCache::sql(EOrmStatementCache::Insert, "person",
+                                     "id", columns, 1,
+                                     tst_EOrmStatementCache::returning(db)),
+             expected);
+}
+
+/*!
+ * \lang_en
+ * \brief Function set the same rows as insertReturning_data().
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция задает те же строки, что и insertReturning_data().
+ * \endlang
+ */
+void tst_EOrmStatementCache::preparedInsert_data()
+{
+    this->insertReturning_data();
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that the cached statement is prepared from the
+ *  same SQL code.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что кэшированный запрос подготовлен из того же
+ *  SQL-кода.
+ * \endlang
+ */
+void tst_EOrmStatementCache::preparedInsert()
+{
+    QFETCH(QString, driver);
+    QFETCH(QString, expected);
+
+    if (driver != "QSQLITE") {
+        QSKIP("Driver requires a database server");
+    }
+    QSqlDatabase db = QSqlDatabase::database("tst_statementcache");
+    QStringList columns;
+    columns << "name" << "age";
+    QSharedPointer<QSqlQuery> qr = EOrmStatementCache::statement(
+                db, EOrmStatementCache::Insert, "person", "id", columns, 1,
+                tst_EOrmStatementCache::returning(db));
+    QVERIFY(!qr.isNull());
+    QCOMPARE(qr->lastQuery(), expected);
+    qr->finish();
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that saved object receives generated primary key
+ *  and default value of column from the insert statement, without following
+ *  load().
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что сохраненный объект получает сгенерированный
+ *  первичный ключ и значение столбца по-умолчанию из запроса добавления, без
+ *  последующего load().
+ * \endlang
+ */
+void tst_EOrmStatementCache::saveReturning()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_statementcache");
+    if (!db.isOpen()) {
+        QSKIP("QSQLITE driver is not available");
+    }
+    if (!this->m_sqliteReturning) {
+        QSKIP("RETURNING clause requires SQLite 3.35 or later");
+    }
+    Person person;
+    person.setValue("name", "Victor");
+    qint64 before = EOrmStatementCache::hits(db)
+            + EOrmStatementCache::misses(db);
+    QVERIFY(person.save(EOrmActiveRecord::FullRefresh));
+    QCOMPARE(EOrmStatementCache::hits(db) + EOrmStatementCache::misses(db)
+             - before, qint64(1));
+    QVERIFY(person.value("id").toInt() > 0);
+    QCOMPARE(person.value("age").toInt(), 18);
+    QVERIFY(person.isLoaded("age"));
+    QVERIFY(!person.isDirty());
+}
+
+/*!
+ * \lang_en
+ * \brief Function checked that only the least recently used statement is
+ *  released when capacity is reached.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция проверяет, что при достижении емкости освобождается только
+ *  дольше всех не использованный запрос.
+ * \endlang
+ */
+void tst_EOrmStatementCache::leastRecentlyUsed()
+{
+    QSqlDatabase db = QSqlDatabase::database("tst_statementcache");
+    if (!db.isOpen()) {
+        QSKIP("QSQLITE driver is not available");
+    }
+    int capacity = EOrmStatementCache::capacity();
+    EOrmStatementCache::clear(db);
+    EOrmStatementCache::setCapacity(2);
+    QVERIFY(!EOrmStatementCache::statement(db, "SELECT 1").isNull());
+    QVERIFY(!EOrmStatementCache::statement(db, "SELECT 2").isNull());
+    QVERIFY(!EOrmStatementCache::statement(db, "SELECT 1").isNull());
+    QVERIFY(!EOrmStatementCache::statement(db, "SELECT 3").isNull());
+    QCOMPARE(EOrmStatementCache::hits(db), qint64(1));
+    QCOMPARE(EOrmStatementCache::misses(db), qint64(3));
+    QVERIFY(!EOrmStatementCache::statement(db, "SELECT 1").isNull());
+    QCOMPARE(EOrmStatementCache::hits(db), qint64(2));
+    QVERIFY(!EOrmStatementCache::statement(db, "SELECT 2").isNull());
+    QCOMPARE(EOrmStatementCache::misses(db), qint64(4));
+    EOrmStatementCache::setCapacity(capacity);
+    EOrmStatementCache::clear(db);
+}
+
+/*!
+ * \lang_en
+ * \brief Function released cached statements and closed the database.
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Функция освобождает кэшированные запросы и закрывает базу.
+ * \endlang
+ */
+void tst_EOrmStatementCache::cleanupTestCase()
+{
+    EOrmStatementCache::clear();
+    QSqlDatabase::removeDatabase("tst_statementcache");
+    QSqlDatabase::removeDatabase("tst_statementcache_QPSQL");
+    QSqlDatabase::removeDatabase("tst_statementcache_QMYSQL");
+}
+
+/*!
+ * \lang_en
+ * \brief Static function returned columns returned by insert of one object
+ *  with full refresh, as EOrmActiveRecord::save() sets them.
+ * \param db - a database object
+ * \return QStringList
+ * \endlang
+ *
+ * \lang_ru
+ * \brief Статическая функция возвращает столбцы, возвращаемые добавлением
+ *  одного объекта с полным обновлением, как их задает
+ *  EOrmActiveRecord::save().
+ * \param db - объект базы данных
+ * \return QStringList
+ * \endlang
+ */
+QStringList tst_EOrmStatementCache::returning(QSqlDatabase db)
+{
+    QStringList columns;
+    if (EOrm::supportsReturning(db)) {
+        columns << "id" << "name" << "age";
+    }
+    return columns;
+}
+
+QTEST_GUILESS_MAIN(tst_EOrmStatementCache)
+
+#include "tst_eormstatementcache.moc"
@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+
+SUBDIRS += statementcache \
+    querycache \
+    roundtrip \
+    find